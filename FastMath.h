@@ -0,0 +1,268 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "Math.h"
+#include "RasterSIMD.h"
+
+// ڲѭõѧһ͸߹ݺÿоȷͿ㷨
+// ٰ汾дڸעҲĳRendererHeadless --bench-math ²ʱ 1
+
+// 㾫ȣMathExact ׼ĽȫͬMathFast ʹĽ
+enum MathAccuracy
+{
+	MathExact,
+	MathFast,
+};
+
+// ֱܷʹ SSE ָx64ߴ SSE  x86
+#if RENDERER_HAS_SSE41 && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define FAST_MATH_SCALAR_SSE 1
+#else
+#define FAST_MATH_SCALAR_SSE 0
+#endif
+
+// ٺ
+const double FAST_RSQRT_MAX_ERROR = 3e-7;// FastRsqrt4Լ SSE ָʱ FastRsqrt
+const double FAST_RSQRT_NO_SSE_MAX_ERROR = 5e-6;//  SSE ָʱ FastRsqrt
+const double FAST_LOG2_MAX_ERROR = 6.1e-5;
+const double FAST_EXP2_MAX_ERROR = 2.7e-6;
+const double SPECULAR_POW_MAX_ERROR = 4e-4;// ֻͳƽС 1/256 
+
+// 1/sqrt(x)x > 0ӲĽƵƽ 1.5 * 2^-12һţٵ < 3e-7 FastRsqrt4 Ľͬ
+// û SSE ʱƳֵţٵ < 5e-6
+// ҪѹôСΪһ dot(N, H) Ҫ 128 ηȲ 1e-3߹ͻ 30%
+inline float FastRsqrt(float x)
+{
+	float half_x = 0.5f * x;
+#if FAST_MATH_SCALAR_SSE
+	float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+	uint32_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	bits = 0x5f375a86 - (bits >> 1);
+	float y;
+	memcpy(&y, &bits, sizeof(y));
+	y = y * (1.5f - half_x * (y * y));
+#endif
+	return y * (1.5f - half_x * (y * y));
+}
+
+//  normalize ͬȽӽ 0 ʱMathFast ʱ FastRsqrtҲ
+inline Vec3 normalize(const Vec3& v, MathAccuracy accuracy)
+{
+	if (accuracy == MathExact)
+	{
+		return normalize(v);
+	}
+
+	float len2 = dot(v, v);
+	if (len2 > 1e-12f)
+	{
+		return v * FastRsqrt(len2);
+	}
+	return Vec3();
+}
+
+// log2(x)x Ĺx = 2^e * mm  [sqrt(0.5), sqrt(2)) ֮䣬 4 ζʽ log2(1 + t) / t
+//  < 6.1e-5x ӽ 1 ʱҲӽ 0ȫͳ˼㣬ûз֧
+inline float FastLog2(float x)
+{
+	// ȥ sqrt(0.5) λģʽָλ eٴ x ָλȥ e õ m
+	uint32_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	uint32_t offset = bits - 0x3f3504f3;
+	int e = (int32_t)offset >> 23;
+	bits -= offset & 0xff800000;
+	float m;
+	memcpy(&m, &bits, sizeof(m));
+
+	float t = m - 1.0f;
+	float p = 2.611588003e-1f;
+	p = p * t - 3.924590243e-1f;
+	p = p * t + 4.846494793e-1f;
+	p = p * t - 7.204625665e-1f;
+	p = p * t + 1.442655828f;
+	return (float)e + t * p;
+}
+
+// 2^xֱƴָλС 4 ζʽ < 2.7e-6x  [-126, 127] 
+inline float FastExp2(float x)
+{
+	//  SSE ʱ maxss/minss ǯλ std::min/max ɵǷ֧
+#if FAST_MATH_SCALAR_SSE
+	x = _mm_cvtss_f32(_mm_min_ss(_mm_max_ss(_mm_set_ss(x), _mm_set_ss(-126.0f)), _mm_set_ss(127.0f)));
+#else
+	x = std::min(std::max(x, -126.0f), 127.0f);
+#endif
+	//  127 ֮ضϾȡͬʱõָλ
+	int biased = (int)(x + 127.0f);
+	float f = x - (float)(biased - 127);
+	float p = 1.353414050e-2f;
+	p = p * f + 5.201151329e-2f;
+	p = p * f + 2.414427258e-1f;
+	p = p * f + 6.930038402e-1f;
+	p = p * f + 1.000002593f;
+
+	uint32_t bits = (uint32_t)biased << 23;
+	float scale;
+	memcpy(&scale, &bits, sizeof(scale));
+	return p * scale;
+}
+
+// ߹ x^px >= 0p >= 0MathFast ʱ 2^(p * log2(x))
+// С 1/256 ʱ |p * log2(x)| <= 8 < 4e-4СĽֻкСľ
+inline float SpecularPow(float x, float p, MathAccuracy accuracy)
+{
+	if (accuracy == MathExact)
+	{
+		return std::pow(x, p);
+	}
+	if (x <= 0.0f)
+	{
+		return p == 0.0f ? 1.0f : 0.0f;
+	}
+	return FastExp2(p * FastLog2(x));
+}
+
+// Schlick ķ F0 + (1 - F0) * (1 - cosTheta)^5MathFast ʱηֻγ˷
+inline float SchlickFresnel(float cos_theta, float F0, MathAccuracy accuracy)
+{
+	float t = 1.0f - cos_theta;
+	if (accuracy == MathExact)
+	{
+		return F0 + (1.0f - F0) * std::pow(t, 5.0f);
+	}
+	float t2 = t * t;
+	return F0 + (1.0f - F0) * (t2 * t2 * t);
+}
+
+#if RENDERER_HAS_SSE41
+
+// 4 ·İ汾Log4Exp4Pow4  MathExact ʱõ Cephes ʽ float Fast ͷǿٽ
+
+// ln(x)Ҫ x > 0ʹ Cephes Ķʽ
+inline SSE41_TARGET __m128 Log4(__m128 x)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128i xi = _mm_castps_si128(x);
+
+	//  x = m * 2^em  [0.5, 1) ֮
+	__m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(xi, 23), _mm_set1_epi32(126)));
+	__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(xi, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f000000)));
+
+	// m < sqrt(0.5) ʱ 2mʹʽԱ [sqrt(0.5) - 1, sqrt(2) - 1]
+	__m128 small = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+	e = _mm_sub_ps(e, _mm_and_ps(one, small));
+	m = _mm_add_ps(_mm_sub_ps(m, one), _mm_and_ps(m, small));
+
+	__m128 z = _mm_mul_ps(m, m);
+	__m128 y = _mm_set1_ps(7.0376836292E-2f);
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.1514610310E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.1676998740E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.2420140846E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.4249322787E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.6668057665E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(2.0000714765E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-2.4999993993E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(3.3333331174E-1f));
+	y = _mm_mul_ps(_mm_mul_ps(y, m), z);
+
+	y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+	y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+	return _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+}
+
+// e^xʹ Cephes Ķʽ
+inline SSE41_TARGET __m128 Exp4(__m128 x)
+{
+	x = _mm_min_ps(x, _mm_set1_ps(88.3762626647949f));
+	x = _mm_max_ps(x, _mm_set1_ps(-88.3762626647949f));
+
+	// x = n * ln2 + r2^n ֱƴָλ
+	__m128 n = _mm_floor_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)), _mm_set1_ps(0.5f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(0.693359375f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(-2.12194440e-4f)));
+
+	__m128 z = _mm_mul_ps(x, x);
+	__m128 y = _mm_set1_ps(1.9875691500E-4f);
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.3981999507E-3f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(8.3334519073E-3f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(4.1665795894E-2f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.6666665459E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(5.0000001201E-1f));
+	y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, z), x), _mm_set1_ps(1.0f));
+
+	__m128i pow2n = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127)), 23);
+	return _mm_mul_ps(y, _mm_castsi128_ps(pow2n));
+}
+
+// x^px <= 0 ʱΪ 0p > 0
+inline SSE41_TARGET __m128 Pow4(__m128 x, float p)
+{
+	if (p == 0.0f)
+	{
+		return _mm_set1_ps(1.0f);
+	}
+
+	__m128 positive = _mm_cmpgt_ps(x, _mm_setzero_ps());
+	__m128 r = Exp4(_mm_mul_ps(_mm_set1_ps(p), Log4(_mm_max_ps(x, _mm_set1_ps(1e-30f)))));
+	return _mm_and_ps(r, positive);
+}
+
+// 4 · FastRsqrt < 3e-7
+inline SSE41_TARGET __m128 FastRsqrt4(__m128 x)
+{
+	__m128 half_x = _mm_mul_ps(_mm_set1_ps(0.5f), x);
+	__m128 y = _mm_rsqrt_ps(x);
+	return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(half_x, _mm_mul_ps(y, y))));
+}
+
+// 4 · FastLog2㷨ͽ汾ͬ
+inline SSE41_TARGET __m128 FastLog2x4(__m128 x)
+{
+	__m128i xi = _mm_castps_si128(x);
+	__m128i offset = _mm_sub_epi32(xi, _mm_set1_epi32(0x3f3504f3));
+	__m128 e = _mm_cvtepi32_ps(_mm_srai_epi32(offset, 23));
+	__m128 m = _mm_castsi128_ps(_mm_sub_epi32(xi, _mm_and_si128(offset, _mm_set1_epi32((int)0xff800000))));
+
+	__m128 t = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+	__m128 p = _mm_set1_ps(2.611588003e-1f);
+	p = _mm_sub_ps(_mm_mul_ps(p, t), _mm_set1_ps(3.924590243e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(4.846494793e-1f));
+	p = _mm_sub_ps(_mm_mul_ps(p, t), _mm_set1_ps(7.204625665e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.442655828f));
+	return _mm_add_ps(e, _mm_mul_ps(t, p));
+}
+
+// 4 · FastExp2㷨ͽ汾ͬ
+inline SSE41_TARGET __m128 FastExp2x4(__m128 x)
+{
+	x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(127.0f));
+	__m128i biased = _mm_cvttps_epi32(_mm_add_ps(x, _mm_set1_ps(127.0f)));
+	__m128 f = _mm_sub_ps(x, _mm_cvtepi32_ps(_mm_sub_epi32(biased, _mm_set1_epi32(127))));
+
+	__m128 p = _mm_set1_ps(1.353414050e-2f);
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.201151329e-2f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.414427258e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.930038402e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.000002593f));
+
+	return _mm_mul_ps(p, _mm_castsi128_ps(_mm_slli_epi32(biased, 23)));
+}
+
+//  Pow4 ͬ x^p SpecularPow  MathFast ͬ
+inline SSE41_TARGET __m128 FastPow4(__m128 x, float p)
+{
+	if (p == 0.0f)
+	{
+		return _mm_set1_ps(1.0f);
+	}
+
+	__m128 positive = _mm_cmpgt_ps(x, _mm_setzero_ps());
+	__m128 r = FastExp2x4(_mm_mul_ps(_mm_set1_ps(p), FastLog2x4(_mm_max_ps(x, _mm_set1_ps(1e-30f)))));
+	return _mm_and_ps(r, positive);
+}
+
+#endif
@@ -0,0 +1,2096 @@
+using namespace std;
+
+#include <SDL3/SDL.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#include "Math.h"
+#include "Renderer.h"
+#include "Model.h"
+#include "Scene.h"
+#include "TileScheduler.h"
+#include "Profiler.h"
+#include "FastMath.h"
+
+// ޴ڵȾع̶·Ⱦ N ֡ڴе֡ÿ֡ʱͳƣJSON
+// ѡذһ֡ PPM ڻعԱȡڣûʾ Linux 
+//
+// RendererHeadless [--frames N] [--width W] [--height H] [--threads N] [--scalar] [--no-hiz] [--no-cull] [--no-lod] [--no-light-cull] [--no-shadows] [--no-pcf] [--deferred] [--fast-math]
+//                  [--plant ģ.obj] [--texture ] [--normal-map ͼ] [--ground ģ.obj]
+//                  [--json .json] [--ppm һ֡.ppm] [--trace ʱ.json]
+//                  [--filter nearest|bilinear|trilinear] [--layout linear|tiled] [--compress] [--plant-cull back|front|none]
+// --compress ͼѹ BC1ͼѹ BC5
+// --plant-cull ֲ޳ʽĬϺ main.cpp һ涼
+// --fast-math ùʹ FastMath.h ĿٽƣĬϺ main.cpp һʹþȷѧ
+// --trace Ҫʱ RENDERER_PROFILE=1 Chrome trace ʽķֽ׶μʱ
+//
+// RendererHeadless --bench-texture ͼƬֻ˷ʽзʽĲٶȺͻδд
+// RendererHeadless --bench-layout [--frames N] [ѡ]ӼͬȾֲԱзʽ֡ʱͻδд
+// RendererHeadless --bench-compress ͼƬԱ RGBA8BC1BC5 ָʽڴռá RGBA8  PSNR Ͳٶ
+// RendererHeadless --bench-cull [--frames N] [--tiles N] [ѡ]ѵ̳ N x N Ĵ󳡾Աȿ׶޳֡ʱ
+// RendererHeadless --bench-scene [--frames N] [ѡ]ʵӼʮӵǧԱʵԡBVHBVH ֡ʱͿɼʵ
+// RendererHeadless --bench-lod [--frames N] [ѡ]ֲɽԶļϣԱȿ LOD ֡ʱ䡢դͻ
+// RendererHeadless --bench-lights [--frames N] [ѡ]Ĭϳм 0  1024 СΧĵԴԱȿعԴ޳֡ʱÿرĹԴ
+// RendererHeadless --bench-shadows [--frames N] [ѡ]ԸֱַʵӰͼͼȾٶȣٶԱȲӰӲӰ PCF ʱ汾֡ʱ
+// RendererHeadless --bench-shaders [--frames N] [ѡ]ɫ϶Աػɫʱжϵͨð汾Ļ֡ʱ䣬治ͬʱ 1
+// RendererHeadless --bench-math [--frames N] [ѡ]ѧԾȷ㷨ÿεõĺʱٶԱ־Ĭϳ֡ʱͻ죬 FastMath.h еʱ 1
+
+// ͳ򣨰̣߳ operator new ĴԤ֮֡Ƿڷڴ
+// ׼汾 nothrow 汾תֻ滻һ
+static std::atomic<uint64_t> allocation_count(0);
+
+void* operator new(size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size > 0 ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+// Ĭϲǰ֡Ὠ棨㻺桢ֿбӰͼԴأȶ״̬ķ
+const int ALLOCATION_WARMUP_FRAMES = 10;
+
+struct HeadlessOptions
+{
+    int frames = 300;
+    int width = 800;
+    int height = 600;
+    int threads = 0;// 0 ʾʹĬ߳CPU 
+    bool simd = true;
+    bool hiz = true;
+    bool cull = true;
+    bool lod = true;
+    bool light_cull = true;
+    bool shadows = true;
+    bool pcf = true;
+    bool deferred = false;
+    bool fast_math = false;
+    TextureFilter filter = FilterTrilinear;
+    TextureLayout layout = LayoutTiled;
+    bool compress = false;
+    CullMode plant_cull = CullNone;
+    string plant = "indoor plant_02.obj";
+    string texture = "indoor plant_2_COL.jpg";
+    string normal_map = "indoor plant_2_NOR.jpg";
+    string ground = "ground.obj";
+    string json;
+    string ppm;
+    string trace;
+    string bench_texture;
+    bool bench_layout = false;
+    string bench_compress;
+    bool bench_cull = false;
+    bool bench_scene = false;
+    bool bench_lod = false;
+    bool bench_lights = false;
+    bool bench_shadows = false;
+    bool bench_shaders = false;
+    bool bench_math = false;
+    int tiles = 16;// --bench-cull еÿ̵Ŀ
+};
+
+// ӲLinux perf_eventֻͳƵ̣߳ûȨ޻ Linux ʱ available Ϊ false
+// ÿ Start / Stop ֮δдۼӵ l1d_read_misses  llc_misses 
+struct CacheCounters
+{
+    bool available = false;
+    long long l1d_read_misses = 0;
+    long long llc_misses = 0;
+
+    CacheCounters();
+    ~CacheCounters();
+    void Start();
+    void Stop();
+    void Reset() { l1d_read_misses = 0; llc_misses = 0; }
+
+private:
+    int l1d_fd = -1;
+    int llc_fd = -1;
+};
+
+// Ĭϲÿ֡ڴԤȽ׶εԼ֮֡͵ֵ֡
+struct AllocationStats
+{
+    int warmup_frames = 0;
+    uint64_t warmup = 0;
+    int steady_frames = 0;
+    uint64_t steady_total = 0;
+    uint64_t steady_max = 0;
+};
+
+// ĬϲԺ͸׼Թõĳ main.cpp ͬһֲԴ
+// ʱ options ߳͸أģͺͼĬϳͻʱͷģ͡ͼ
+// procedural Ϊ true ʱģͻͼļʧܾóɵļͼ
+struct BenchScene
+{
+    Model* plant = NULL;
+    Model* ground = NULL;
+    Texture* texture = NULL;// ֲͼ--compress ʱ BC1
+    Texture* normal_map = NULL;// ֲķͼ--compress ʱ BC5
+    double plant_load_ms = 0;// ֲģ͵ĺʱûлʱ OBJ 𼶼
+    Material plant_Mat = { 0.1f, 0.8f, 0.1f, 5.0f };
+    Material ground_Mat = { 0.1f, 0.7f, 0.5f, 32.0f };
+    Mat4 plant_model_mat;
+    Mat4 ground_model_mat;
+    Scene scene;// ֲһʵ
+    std::vector<Light> lights;// ƽй͵ԴͶӰҪӰʱԼĸ shadow_size
+    int width;
+    int height;
+    Camera* camera = NULL;
+    std::vector<Uint32> frame_buffers[2];// Աַʽʱһݣֻһʱõһ
+    std::vector<float> z_buffer;
+
+    BenchScene(const HeadlessOptions& options, bool procedural = false);
+    ~BenchScene();
+    BenchScene(const BenchScene&) = delete;
+    BenchScene& operator=(const BenchScene&) = delete;
+};
+
+bool ParseOptions(int argc, char* argv[], HeadlessOptions& options);
+bool ParseFilter(const string& name, TextureFilter& filter);
+bool ParseLayout(const string& name, TextureLayout& layout);
+bool ParseCullMode(const string& name, CullMode& cull_mode);
+void SetupFrame(int frame, int frame_count, Camera* camera, std::vector<Light>& lights);
+void DrawSky(Uint32* frame_buffer, int width, int height);
+double Percentile(std::vector<double> values, double p);
+bool WriteJson(const string& filename, const HeadlessOptions& options, const std::vector<double>& frame_ms, const RenderStats& stats, const CacheCounters& counters, const AllocationStats& allocations);
+bool WritePPM(const string& filename, const Uint32* frame_buffer, int width, int height);
+void BenchmarkTexture(const char* filename);
+void BenchmarkLayout(const HeadlessOptions& options);
+void BenchmarkCompress(const char* filename);
+void BenchmarkCull(const HeadlessOptions& options);
+void BenchmarkScene(const HeadlessOptions& options);
+void BenchmarkLod(const HeadlessOptions& options);
+void BenchmarkLights(const HeadlessOptions& options);
+void BenchmarkShadows(const HeadlessOptions& options);
+bool BenchmarkShaders(const HeadlessOptions& options);
+bool BenchmarkMath(const HeadlessOptions& options);
+SDL_Surface* CreatePatternSurface(bool normal_map);
+Model* CreatePatternModel(bool ground);
+Texture* LoadBenchTexture(const string& filename, bool normal_map, TextureLayout layout, TextureFormat format, bool pattern);
+
+int main(int argc, char* argv[])
+{
+    HeadlessOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        return 1;
+    }
+
+    if (!options.bench_texture.empty())
+    {
+        BenchmarkTexture(options.bench_texture.c_str());
+        return 0;
+    }
+    if (options.bench_layout)
+    {
+        BenchmarkLayout(options);
+        return 0;
+    }
+    if (!options.bench_compress.empty())
+    {
+        BenchmarkCompress(options.bench_compress.c_str());
+        return 0;
+    }
+    if (options.bench_cull)
+    {
+        BenchmarkCull(options);
+        return 0;
+    }
+    if (options.bench_scene)
+    {
+        BenchmarkScene(options);
+        return 0;
+    }
+    if (options.bench_lod)
+    {
+        BenchmarkLod(options);
+        return 0;
+    }
+    if (options.bench_lights)
+    {
+        BenchmarkLights(options);
+        return 0;
+    }
+    if (options.bench_shadows)
+    {
+        BenchmarkShadows(options);
+        return 0;
+    }
+    if (options.bench_shaders)
+    {
+        return BenchmarkShaders(options) ? 0 : 1;
+    }
+    if (options.bench_math)
+    {
+        return BenchmarkMath(options) ? 0 : 1;
+    }
+
+    BenchScene bench(options);
+    if (bench.plant->nfaces() == 0 && bench.ground->nfaces() == 0)
+    {
+        cerr << "No geometry loaded (" << options.plant << ", " << options.ground << ")" << endl;
+        return 1;
+    }
+
+    Scene& scene = bench.scene;
+    std::vector<Light> lights = bench.lights;
+    lights[0].shadow_size = 2048;
+    lights[1].shadow_size = 512;
+
+    int width = bench.width;
+    int height = bench.height;
+    Camera* camera = bench.camera;
+    Uint32* frame_buffer = bench.frame_buffers[0].data();
+    std::vector<float>& z_buffer = bench.z_buffer;
+
+    std::vector<double> frame_ms;
+    frame_ms.reserve(options.frames);
+    std::vector<uint64_t> frame_allocations;
+    frame_allocations.reserve(options.frames);
+    RenderStats stats;
+    CacheCounters counters;
+    int shadow_maps_rendered = 0, shadow_maps_cached = 0;
+
+    for (int frame = 0; frame < options.frames; frame++)
+    {
+        PROFILE_SCOPE("Frame");
+        SetupFrame(frame, options.frames, camera, lights);
+
+        uint64_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+        counters.Start();
+        auto start = std::chrono::steady_clock::now();
+
+        // ƽйӰͼֻڵһ֡Ⱦֻ֮ƶĵԴҪػ
+        ShadowStats shadow_stats = scene.UpdateShadows(lights);
+        shadow_maps_rendered += shadow_stats.maps_rendered;
+        shadow_maps_cached += shadow_stats.maps_cached;
+
+        ClearDepth(z_buffer);
+        DrawSky(frame_buffer, width, height);
+
+        scene.Draw(width, height, camera, frame_buffer, z_buffer, lights);
+        ResolveDeferred(width, height, camera, frame_buffer, lights);
+
+        auto end = std::chrono::steady_clock::now();
+        counters.Stop();
+        frame_allocations.push_back(allocation_count.load(std::memory_order_relaxed) - allocations_before);
+        frame_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        RenderStats frame_stats = CollectRenderStats();
+        ProfileFrame(frame_stats);
+        stats += frame_stats;
+    }
+
+    // ܴӡ̨д JSON
+    double total_ms = 0;
+    for (double ms : frame_ms)
+    {
+        total_ms += ms;
+    }
+    double mean_ms = frame_ms.empty() ? 0 : total_ms / frame_ms.size();
+
+    AllocationStats allocations;
+    allocations.warmup_frames = std::min(ALLOCATION_WARMUP_FRAMES, options.frames);
+    for (int frame = 0; frame < options.frames; frame++)
+    {
+        if (frame < allocations.warmup_frames)
+        {
+            allocations.warmup += frame_allocations[frame];
+            continue;
+        }
+        allocations.steady_frames++;
+        allocations.steady_total += frame_allocations[frame];
+        allocations.steady_max = std::max(allocations.steady_max, frame_allocations[frame]);
+    }
+
+    cout << options.frames << " frames " << width << "x" << height << " (" << (IsSIMDEnabled() ? "SSE4.1" : "scalar") << ", " << (IsDeferredEnabled() ? "deferred" : "forward") << ", Hi-Z " << (IsHiZEnabled() ? "on" : "off") << ", " << (IsFastMathEnabled() ? "fast" : "exact") << " math, " << TileScheduler::Instance().WorkerCount() << " threads)" << endl;
+    cout << "  Frame time: mean " << mean_ms << " ms, p50 " << Percentile(frame_ms, 50) << " ms, p99 " << Percentile(frame_ms, 99) << " ms" << endl;
+    cout << "  Triangles/frame: submitted " << stats.triangles_submitted / options.frames << ", frustum culled " << stats.triangles_frustum_culled / options.frames
+         << ", back-face culled " << stats.triangles_backface_culled / options.frames << ", near-clipped " << stats.triangles_clipped_one / options.frames << " + " << stats.triangles_clipped_two / options.frames
+         << ", guard-band clipped " << stats.triangles_guard_clipped / options.frames << ", skipped by LOD " << stats.triangles_lod_skipped / options.frames << "; models culled " << stats.models_culled / options.frames << endl;
+    if (total_ms > 0)
+    {
+        // ؼֻ RENDERER_PROFILE=1 ʱͳ
+        cout << "  Throughput: " << stats.triangles_submitted / (total_ms / 1000.0) / 1e6 << " Mtriangles/s, ";
+        if (RENDERER_PROFILE)
+        {
+            cout << stats.pixels_shaded / (total_ms / 1000.0) / 1e6 << " Mpixels/s shaded (" << (double)stats.pixel_lights / std::max(stats.pixels_shaded, (uint64_t)1) << " lights/pixel), "
+                 << stats.texture_samples / (total_ms / 1000.0) / 1e6 << " Msamples/s";
+        }
+        else
+        {
+            cout << "pixels and samples not counted (build with RENDERER_PROFILE=1)";
+        }
+        cout << " (" << TextureFilterName(GetTextureFilter()) << ", " << TextureLayoutName(options.layout) << (options.compress ? ", bc1/bc5" : "") << ")" << endl;
+    }
+    if (IsShadowMappingEnabled())
+    {
+        cout << "  Shadow maps: " << shadow_maps_rendered << " rendered, " << shadow_maps_cached << " reused from the previous frame (" << (IsShadowPCFEnabled() ? "PCF" : "hard") << ")" << endl;
+    }
+    if (counters.available)
+    {
+        cout << "  Cache misses/frame (calling thread): L1D read " << counters.l1d_read_misses / options.frames << ", LLC " << counters.llc_misses / options.frames << endl;
+    }
+    cout << "  Allocations: " << allocations.warmup << " in the first " << allocations.warmup_frames << " frames (warm-up), " << allocations.steady_total << " in the other " << allocations.steady_frames << " frames (max " << allocations.steady_max << " per frame)" << endl;
+
+    // Ԥ֮֡ӦȫеĻ
+    int result = 0;
+    if (allocations.steady_total > 0)
+    {
+        cerr << "Steady-state frames allocated memory " << allocations.steady_total << " times" << endl;
+        result = 1;
+    }
+    if (!options.json.empty() && !WriteJson(options.json, options, frame_ms, stats, counters, allocations))
+    {
+        cerr << "Cannot write " << options.json << endl;
+        result = 1;
+    }
+    if (!options.ppm.empty() && !WritePPM(options.ppm, frame_buffer, width, height))
+    {
+        cerr << "Cannot write " << options.ppm << endl;
+        result = 1;
+    }
+
+    if (!options.trace.empty() && !WriteChromeTrace(options.trace.c_str()))
+    {
+        cerr << "Cannot write " << options.trace << (RENDERER_PROFILE ? "" : " (build with RENDERER_PROFILE=1 to record timings)") << endl;
+        result = 1;
+    }
+
+    return result;
+}
+
+bool ParseFilter(const string& name, TextureFilter& filter)
+{
+    for (int f = FilterNearest; f <= FilterTrilinear; f++)
+    {
+        if (name == TextureFilterName((TextureFilter)f))
+        {
+            filter = (TextureFilter)f;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseLayout(const string& name, TextureLayout& layout)
+{
+    for (int l = LayoutLinear; l <= LayoutTiled; l++)
+    {
+        if (name == TextureLayoutName((TextureLayout)l))
+        {
+            layout = (TextureLayout)l;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseCullMode(const string& name, CullMode& cull_mode)
+{
+    for (int c = CullBack; c <= CullNone; c++)
+    {
+        if (name == CullModeName((CullMode)c))
+        {
+            cull_mode = (CullMode)c;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseOptions(int argc, char* argv[], HeadlessOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--scalar") options.simd = false;
+        else if (arg == "--no-hiz") options.hiz = false;
+        else if (arg == "--no-cull") options.cull = false;
+        else if (arg == "--no-lod") options.lod = false;
+        else if (arg == "--no-light-cull") options.light_cull = false;
+        else if (arg == "--no-shadows") options.shadows = false;
+        else if (arg == "--no-pcf") options.pcf = false;
+        else if (arg == "--deferred") options.deferred = true;
+        else if (arg == "--fast-math") options.fast_math = true;
+        else if (arg == "--frames" && has_value) options.frames = atoi(argv[++i]);
+        else if (arg == "--width" && has_value) options.width = atoi(argv[++i]);
+        else if (arg == "--height" && has_value) options.height = atoi(argv[++i]);
+        else if (arg == "--threads" && has_value) options.threads = atoi(argv[++i]);
+        else if (arg == "--plant" && has_value) options.plant = argv[++i];
+        else if (arg == "--texture" && has_value) options.texture = argv[++i];
+        else if (arg == "--normal-map" && has_value) options.normal_map = argv[++i];
+        else if (arg == "--ground" && has_value) options.ground = argv[++i];
+        else if (arg == "--json" && has_value) options.json = argv[++i];
+        else if (arg == "--ppm" && has_value) options.ppm = argv[++i];
+        else if (arg == "--trace" && has_value) options.trace = argv[++i];
+        else if (arg == "--bench-texture" && has_value) options.bench_texture = argv[++i];
+        else if (arg == "--bench-layout") options.bench_layout = true;
+        else if (arg == "--bench-compress" && has_value) options.bench_compress = argv[++i];
+        else if (arg == "--compress") options.compress = true;
+        else if (arg == "--bench-cull") options.bench_cull = true;
+        else if (arg == "--bench-scene") options.bench_scene = true;
+        else if (arg == "--bench-lod") options.bench_lod = true;
+        else if (arg == "--bench-lights") options.bench_lights = true;
+        else if (arg == "--bench-shadows") options.bench_shadows = true;
+        else if (arg == "--bench-shaders") options.bench_shaders = true;
+        else if (arg == "--bench-math") options.bench_math = true;
+        else if (arg == "--tiles" && has_value) options.tiles = atoi(argv[++i]);
+        else if (arg == "--filter" && has_value && ParseFilter(argv[i + 1], options.filter)) i++;
+        else if (arg == "--layout" && has_value && ParseLayout(argv[i + 1], options.layout)) i++;
+        else if (arg == "--plant-cull" && has_value && ParseCullMode(argv[i + 1], options.plant_cull)) i++;
+        else
+        {
+            cerr << "Unknown option: " << arg << endl;
+            cerr << "Usage: " << argv[0] << " [--frames N] [--width W] [--height H] [--threads N] [--scalar] [--no-hiz] [--no-cull] [--no-lod] [--no-light-cull] [--no-shadows] [--no-pcf] [--deferred] [--fast-math]" << endl
+                 << "       [--plant file.obj] [--texture file] [--normal-map file] [--ground file.obj] [--json out.json] [--ppm out.ppm] [--trace trace.json]" << endl
+                 << "       [--filter nearest|bilinear|trilinear] [--layout linear|tiled] [--compress] [--plant-cull back|front|none]" << endl
+                 << "       " << argv[0] << " --bench-texture image" << endl
+                 << "       " << argv[0] << " --bench-layout [--frames N] [scene options]" << endl
+                 << "       " << argv[0] << " --bench-compress image" << endl
+                 << "       " << argv[0] << " --bench-cull [--frames N] [--tiles N] [scene options]" << endl
+                 << "       " << argv[0] << " --bench-scene [--frames N] [scene options]" << endl
+                 << "       " << argv[0] << " --bench-lod [--frames N] [scene options]" << endl
+                 << "       " << argv[0] << " --bench-lights [--frames N] [scene options]" << endl
+                 << "       " << argv[0] << " --bench-shadows [--frames N] [scene options]" << endl
+                 << "       " << argv[0] << " --bench-shaders [--frames N] [scene options]" << endl
+                 << "       " << argv[0] << " --bench-math [--frames N] [scene options]" << endl;
+            return false;
+        }
+    }
+
+    if (options.frames <= 0 || options.width <= 0 || options.height <= 0 || options.tiles <= 0)
+    {
+        cerr << "--frames, --width, --height and --tiles must be positive" << endl;
+        return false;
+    }
+    return true;
+}
+
+// ֲתһȦԴ˶ main.cpp һֻʱ֡ž֤ÿеĻȫͬ
+void SetupFrame(int frame, int frame_count, Camera* camera, std::vector<Light>& lights)
+{
+    float t = (float)frame / frame_count;
+    float angle = to_radians(t * 360.0f);
+    float radius = 12.0f;
+
+    camera->position = Vec3(sin(angle) * radius, 2.0f + sin(angle * 2.0f), cos(angle) * radius);
+    camera->target = Vec3(0, 1, 0);
+
+    float time = frame / 60.0f;
+    lights[1].position = Vec3(sin(time) * 2.0f, 1.5f + cos(time * 0.5f), cos(time) * 2.0f);
+}
+
+void DrawSky(Uint32* frame_buffer, int width, int height)
+{
+    for (int y = 0; y < height; y++)
+    {
+        float t = (float)y / height;
+        Uint32 color = Vec3ToUint32(Vec3(0.5f, 0.7f, 1.0f) * (1 - t) + Vec3(0.f, 0.2f, 0.4f) * t);
+        std::fill(frame_buffer + y * width, frame_buffer + (y + 1) * width, color);
+    }
+}
+
+// ȷٷλ
+double Percentile(std::vector<double> values, double p)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+
+    size_t rank = (size_t)ceil(p / 100.0 * values.size());
+    rank = std::min(std::max(rank, (size_t)1), values.size());
+    std::nth_element(values.begin(), values.begin() + (rank - 1), values.end());
+    return values[rank - 1];
+}
+
+bool WriteJson(const string& filename, const HeadlessOptions& options, const std::vector<double>& frame_ms, const RenderStats& stats, const CacheCounters& counters, const AllocationStats& allocations)
+{
+    ofstream out(filename);
+    if (!out)
+    {
+        return false;
+    }
+
+    double total_ms = 0, min_ms = 0, max_ms = 0;
+    if (!frame_ms.empty())
+    {
+        min_ms = *std::min_element(frame_ms.begin(), frame_ms.end());
+        max_ms = *std::max_element(frame_ms.begin(), frame_ms.end());
+    }
+    for (double ms : frame_ms)
+    {
+        total_ms += ms;
+    }
+    double seconds = total_ms / 1000.0;
+    double frames = (double)frame_ms.size();
+
+    out.precision(6);
+    out << "{" << endl;
+    out << "  \"config\": {\"width\": " << options.width << ", \"height\": " << options.height << ", \"frames\": " << options.frames
+        << ", \"threads\": " << TileScheduler::Instance().WorkerCount() << ", \"simd\": " << (IsSIMDEnabled() ? "true" : "false")
+        << ", \"hiz\": " << (IsHiZEnabled() ? "true" : "false") << ", \"cull\": " << (IsFrustumCullingEnabled() ? "true" : "false") << ", \"lod\": " << (IsLodEnabled() ? "true" : "false") << ", \"light_cull\": " << (IsLightCullingEnabled() ? "true" : "false") << ", \"shadows\": " << (IsShadowMappingEnabled() ? "true" : "false") << ", \"pcf\": " << (IsShadowPCFEnabled() ? "true" : "false") << ", \"deferred\": " << (IsDeferredEnabled() ? "true" : "false") << ", \"filter\": \"" << TextureFilterName(GetTextureFilter()) << "\", \"layout\": \"" << TextureLayoutName(options.layout) << "\", \"compress\": " << (options.compress ? "true" : "false") << ", \"plant_cull\": \"" << CullModeName(options.plant_cull) << "\"}," << endl;
+    out << "  \"frame_ms\": {\"mean\": " << (frames > 0 ? total_ms / frames : 0) << ", \"p50\": " << Percentile(frame_ms, 50) << ", \"p99\": " << Percentile(frame_ms, 99)
+        << ", \"min\": " << min_ms << ", \"max\": " << max_ms << ", \"total\": " << total_ms << "}," << endl;
+    out << "  \"triangles_per_second\": " << (seconds > 0 ? stats.triangles_submitted / seconds : 0) << "," << endl;
+
+    // ؼֻ RENDERER_PROFILE=1 ʱͳƣд null
+    if (RENDERER_PROFILE)
+    {
+        out << "  \"pixels_per_second\": " << (seconds > 0 ? stats.pixels_shaded / seconds : 0) << "," << endl;
+        out << "  \"texture_samples_per_second\": " << (seconds > 0 ? stats.texture_samples / seconds : 0) << "," << endl;
+    }
+    else
+    {
+        out << "  \"pixels_per_second\": null," << endl;
+        out << "  \"texture_samples_per_second\": null," << endl;
+    }
+
+    // ӲֻͳƵ Render ̣߳--threads 1 ʱ
+    if (counters.available)
+    {
+        out << "  \"cache_misses_per_frame\": {\"l1d_read\": " << counters.l1d_read_misses / frames << ", \"llc\": " << counters.llc_misses / frames << "}," << endl;
+    }
+    else
+    {
+        out << "  \"cache_misses_per_frame\": null," << endl;
+    }
+    out << "  \"allocations\": {\"warmup_frames\": " << allocations.warmup_frames << ", \"warmup\": " << allocations.warmup << ", \"steady_frames\": " << allocations.steady_frames
+        << ", \"steady_total\": " << allocations.steady_total << ", \"steady_per_frame\": " << (allocations.steady_frames > 0 ? (double)allocations.steady_total / allocations.steady_frames : 0.0)
+        << ", \"steady_max\": " << allocations.steady_max << "}," << endl;
+    out << "  \"per_frame\": {\"triangles_submitted\": " << stats.triangles_submitted / frames << ", \"triangles_backface_culled\": " << stats.triangles_backface_culled / frames
+        << ", \"models_culled\": " << stats.models_culled / frames << ", \"triangles_lod_skipped\": " << stats.triangles_lod_skipped / frames << ", \"triangles_frustum_culled\": " << stats.triangles_frustum_culled / frames << ", \"triangles_guard_clipped\": " << stats.triangles_guard_clipped / frames
+        << ", \"triangles_clipped_one\": " << stats.triangles_clipped_one / frames << ", \"triangles_clipped_two\": " << stats.triangles_clipped_two / frames
+        << ", \"pixels_depth_passed\": " << stats.pixels_depth_passed / frames << ", \"vertices_transformed\": " << stats.vertices_transformed / frames
+        << ", \"triangles_occluded\": " << stats.triangles_occluded / frames;
+    if (RENDERER_PROFILE)
+    {
+        out << ", \"texture_samples\": " << stats.texture_samples / frames << ", \"pixel_lights\": " << stats.pixel_lights / frames
+            << ", \"pixels_tested\": " << stats.pixels_tested / frames << ", \"pixels_shaded\": " << stats.pixels_shaded / frames
+            << ", \"blocks_rejected\": " << stats.blocks_rejected / frames << ", \"blocks_accepted\": " << stats.blocks_accepted / frames
+            << ", \"blocks_partial\": " << stats.blocks_partial / frames << ", \"blocks_occluded\": " << stats.blocks_occluded / frames;
+    }
+    else
+    {
+        out << ", \"texture_samples\": null, \"pixel_lights\": null, \"pixels_tested\": null, \"pixels_shaded\": null"
+            << ", \"blocks_rejected\": null, \"blocks_accepted\": null, \"blocks_partial\": null, \"blocks_occluded\": null";
+    }
+    out << "}," << endl;
+
+    out << "  \"frames\": [";
+    for (size_t i = 0; i < frame_ms.size(); i++)
+    {
+        out << (i > 0 ? ", " : "") << frame_ms[i];
+    }
+    out << "]" << endl;
+    out << "}" << endl;
+
+    return (bool)out;
+}
+
+//  PPMP6ͼƬ⣬ֽڱȽ
+bool WritePPM(const string& filename, const Uint32* frame_buffer, int width, int height)
+{
+    ofstream out(filename, ios::binary);
+    if (!out)
+    {
+        return false;
+    }
+
+    out << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<unsigned char> row(width * 3);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            Uint32 c = frame_buffer[y * width + x];
+            row[x * 3 + 0] = (c >> 16) & 0xff;
+            row[x * 3 + 1] = (c >> 8) & 0xff;
+            row[x * 3 + 2] = c & 0xff;
+        }
+        out.write((const char*)row.data(), row.size());
+    }
+
+    return (bool)out;
+}
+
+#if defined(__linux__)
+
+static int OpenCounter(uint32_t type, uint64_t config)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+CacheCounters::CacheCounters()
+{
+    l1d_fd = OpenCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    llc_fd = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    available = l1d_fd >= 0 && llc_fd >= 0;
+}
+
+CacheCounters::~CacheCounters()
+{
+    if (l1d_fd >= 0) close(l1d_fd);
+    if (llc_fd >= 0) close(llc_fd);
+}
+
+void CacheCounters::Start()
+{
+    if (!available)
+    {
+        return;
+    }
+
+    for (int fd : { l1d_fd, llc_fd })
+    {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void CacheCounters::Stop()
+{
+    if (!available)
+    {
+        return;
+    }
+
+    long long value = 0;
+    ioctl(l1d_fd, PERF_EVENT_IOC_DISABLE, 0);
+    ioctl(llc_fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(l1d_fd, &value, sizeof(value)) == sizeof(value)) l1d_read_misses += value;
+    if (read(llc_fd, &value, sizeof(value)) == sizeof(value)) llc_misses += value;
+}
+
+#else
+
+CacheCounters::CacheCounters() {}
+CacheCounters::~CacheCounters() {}
+void CacheCounters::Start() {}
+void CacheCounters::Stop() {}
+
+#endif
+
+BenchScene::BenchScene(const HeadlessOptions& options, bool procedural) : width(options.width), height(options.height)
+{
+    if (options.threads > 0)
+    {
+        TileScheduler::SetThreadCount(options.threads);
+    }
+    SetSIMDEnabled(options.simd);
+    SetHiZEnabled(options.hiz);
+    SetFrustumCullingEnabled(options.cull);
+    SetLodEnabled(options.lod);
+    SetLightCullingEnabled(options.light_cull);
+    SetShadowMappingEnabled(options.shadows);
+    SetShadowPCFEnabled(options.pcf);
+    SetDeferredEnabled(options.deferred);
+    SetFastMathEnabled(options.fast_math);
+    SetTextureFilter(options.filter);
+
+    auto load_start = std::chrono::steady_clock::now();
+    plant = new Model(options.plant.c_str());
+    plant_load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+    ground = new Model(options.ground.c_str());
+    if (procedural && plant->nfaces() == 0)
+    {
+        delete plant;
+        plant = CreatePatternModel(false);
+    }
+    if (procedural && ground->nfaces() == 0)
+    {
+        delete ground;
+        ground = CreatePatternModel(true);
+    }
+    texture = LoadBenchTexture(options.texture, false, options.layout, options.compress ? FormatBC1 : FormatRGBA8, procedural);
+    normal_map = LoadBenchTexture(options.normal_map, true, options.layout, options.compress ? FormatBC5 : FormatRGBA8, procedural);
+
+    plant_model_mat = CreateScale(Vec3(1.0f, 1.0f, 1.0f));
+    ground_model_mat = CreateTranslation(Vec3(0, 0, 0));
+    scene.AddInstance(scene.AddMesh(ground, NULL, NULL, ground_Mat), ground_model_mat);
+    scene.AddInstance(scene.AddMesh(plant, texture, normal_map, plant_Mat, options.plant_cull), plant_model_mat);
+
+    lights =
+    {
+        Light::Directional(Vec3(1, -1, -1), Vec3(1, 1, 0.8f), 0.8f),
+        Light::Point(Vec3(0, 2, 0), Vec3(0.2f, 0.2f, 0.5f), 10.0f)
+    };
+
+    camera = Camera::CreateCamera(Vec3(0, 2, 20), 5.0f, -90.0f, 0.0f);
+    frame_buffers[0].resize(width * height);
+    frame_buffers[1].resize(width * height);
+    z_buffer.assign(width * height, 1.0f);
+}
+
+BenchScene::~BenchScene()
+{
+    delete camera;
+    delete plant;
+    delete ground;
+    delete texture;
+    delete normal_map;
+}
+
+// Ļ׼ԣòͬűһ顰ĻУu 仯죩ͰУv 仯죩˳
+// в൱Ļת 90 ȣʱÿβԽһУֿʱ 4 βŻһ
+void BenchmarkTexture(const char* filename)
+{
+    SDL_Surface* surface = LoadTexture(filename);
+    Texture* textures[2] = { Texture::CreateTexture(surface, LayoutLinear), Texture::CreateTexture(surface, LayoutTiled) };
+    SDL_DestroySurface(surface);
+    if (textures[0] == NULL || textures[1] == NULL)
+    {
+        cout << "Cannot load " << filename << endl;
+        delete textures[0];
+        delete textures[1];
+        return;
+    }
+
+    cout << filename << ": " << textures[0]->Width() << "x" << textures[0]->Height() << ", " << textures[0]->LevelCount() << " mip levels, "
+         << textures[0]->MemorySize() / (1024.0 * 1024.0) << " MB (linear), " << textures[1]->MemorySize() / (1024.0 * 1024.0) << " MB (tiled)" << endl;
+
+    // Ļ֮߳߳ȣ 1 ǷŴС 1 С0.3 ʱ lod ԹҪ
+    const float scales[] = { 2.0f, 1.0f, 0.3f };
+    const int target_samples = 1 << 22;
+    CacheCounters counters;
+    float checksum = 0;
+
+    for (int f = FilterNearest; f <= FilterTrilinear; f++)
+    {
+        TextureFilter filter = (TextureFilter)f;
+        for (float scale : scales)
+        {
+            for (int vertical = 0; vertical <= 1; vertical++)
+            {
+                for (const Texture* texture : textures)
+                {
+                    int size = std::max(1, (int)(std::max(texture->Width(), texture->Height()) * scale));
+                    float step = 1.0f / size;
+                    float lod = TextureLod(step, 0, 0, step);
+                    long long samples = 0;
+
+                    counters.Reset();
+                    counters.Start();
+                    auto start = std::chrono::steady_clock::now();
+                    Vec3 sum(0, 0, 0);
+                    while (samples < target_samples)
+                    {
+                        for (int j = 0; j < size; j++)
+                        {
+                            for (int i = 0; i < size; i++)
+                            {
+                                float a = (i + 0.5f) * step;
+                                float b = (j + 0.5f) * step;
+                                sum += vertical ? texture->Sample(b, a, lod, filter) : texture->Sample(a, b, lod, filter);
+                            }
+                        }
+                        samples += (long long)size * size;
+                    }
+                    auto end = std::chrono::steady_clock::now();
+                    counters.Stop();
+                    checksum += sum.x + sum.y + sum.z;
+
+                    double seconds = std::chrono::duration<double>(end - start).count();
+                    cout << "  " << TextureFilterName(filter) << ", scale " << scale << (vertical ? ", columns" : ", rows") << ", " << TextureLayoutName(texture->Layout())
+                         << ": " << samples / seconds / 1e6 << " Msamples/s";
+                    if (counters.available)
+                    {
+                        cout << ", L1D read misses/sample " << (double)counters.l1d_read_misses / samples << ", LLC misses/sample " << (double)counters.llc_misses / samples;
+                    }
+                    cout << endl;
+                }
+            }
+        }
+    }
+
+    if (!counters.available)
+    {
+        cout << "  (hardware cache counters unavailable)" << endl;
+    }
+    cout << "  checksum " << checksum << endl;
+    delete textures[0];
+    delete textures[1];
+}
+
+// зʽĻ׼ԣӼȾֲֲֻռҪ֣
+// ÿʹкͷֿеȾ N ֡֡ʱÿĻδд
+// ӲֻͳƵ̣߳ûָ --threads ʱΪ߳Ⱦü
+void BenchmarkLayout(const HeadlessOptions& options)
+{
+    BenchScene bench(options);
+    TileScheduler::SetThreadCount(options.threads > 0 ? options.threads : 1);
+
+    // зʽһδѹͼﰴ --layout صǷݲ
+    Texture* textures[2] = { LoadBenchTexture(options.texture, false, LayoutLinear, FormatRGBA8, false), LoadBenchTexture(options.texture, false, LayoutTiled, FormatRGBA8, false) };
+    Texture* normal_maps[2] = { LoadBenchTexture(options.normal_map, true, LayoutLinear, FormatRGBA8, false), LoadBenchTexture(options.normal_map, true, LayoutTiled, FormatRGBA8, false) };
+
+    if (bench.plant->nfaces() == 0 || (textures[0] == NULL && normal_maps[0] == NULL))
+    {
+        cerr << "--bench-layout needs a textured model (" << options.plant << ", " << options.texture << ")" << endl;
+    }
+    else
+    {
+
+        // ͬ򿴵ҶƬĻϵĳͬ uv ɨҲͲͬ
+        struct View
+        {
+            const char* name;
+            Vec3 position;
+        };
+        const View views[] =
+        {
+            { "front", Vec3(0.0f, 1.5f, 5.0f) },
+            { "side", Vec3(5.0f, 1.5f, 0.0f) },
+            { "above", Vec3(0.3f, 7.0f, 0.3f) },
+            { "close-up", Vec3(1.2f, 1.3f, 1.8f) },
+        };
+
+        int width = bench.width;
+        int height = bench.height;
+        Camera* camera = bench.camera;
+        camera->target = Vec3(0, 1, 0);
+        Uint32* frame_buffer = bench.frame_buffers[0].data();
+        CacheCounters counters;
+
+        cout << "Texture layout benchmark: " << options.frames << " frames per view, " << width << "x" << height << ", " << TextureFilterName(options.filter)
+             << ", " << TileScheduler::Instance().WorkerCount() << " threads" << endl;
+
+        for (const View& view : views)
+        {
+            camera->position = view.position;
+            double layout_ms[2] = { 0, 0 };
+            for (int layout = LayoutLinear; layout <= LayoutTiled; layout++)
+            {
+                RenderStats stats;
+                double total_ms = 0;
+                counters.Reset();
+                CollectRenderStats();
+
+                //  0 ֻ֡ԤȻ棬
+                for (int frame = 0; frame <= options.frames; frame++)
+                {
+                    if (frame > 0)
+                    {
+                        counters.Start();
+                    }
+                    auto start = std::chrono::steady_clock::now();
+
+                    ClearDepth(bench.z_buffer);
+                    DrawSky(frame_buffer, width, height);
+                    Render(width, height, bench.plant, bench.plant_model_mat, textures[layout], camera, normal_maps[layout], frame_buffer, bench.z_buffer, bench.plant_Mat, bench.lights, options.plant_cull);
+                    ResolveDeferred(width, height, camera, frame_buffer, bench.lights);
+
+                    auto end = std::chrono::steady_clock::now();
+                    RenderStats frame_stats = CollectRenderStats();
+                    if (frame > 0)
+                    {
+                        counters.Stop();
+                        total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+                        stats += frame_stats;
+                    }
+                }
+
+                layout_ms[layout] = total_ms / options.frames;
+                cout << "  " << view.name << ", " << TextureLayoutName((TextureLayout)layout) << ": " << layout_ms[layout] << " ms/frame";
+                if (RENDERER_PROFILE)
+                {
+                    cout << ", " << stats.texture_samples / options.frames << " samples/frame";
+                }
+                if (counters.available && stats.texture_samples > 0)
+                {
+                    cout << ", L1D read misses/sample " << (double)counters.l1d_read_misses / stats.texture_samples
+                         << ", LLC misses/sample " << (double)counters.llc_misses / stats.texture_samples;
+                }
+                cout << endl;
+            }
+            if (layout_ms[LayoutTiled] > 0)
+            {
+                cout << "  " << view.name << ": tiled speedup " << layout_ms[LayoutLinear] / layout_ms[LayoutTiled] << "x" << endl;
+            }
+        }
+
+        if (!counters.available)
+        {
+            cout << "  (hardware cache counters unavailable)" << endl;
+        }
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        delete textures[i];
+        delete normal_maps[i];
+    }
+}
+
+// ѹʽĻ׼ԣͬһͼƬֱ RGBA8BC1BC5ڴռá 0  RGBA8  PSNR Ͳٶ
+// BC1 Ƚ RGB ͨBC5 ڷͼֻȽϴ RG ͨB ؽģ
+void BenchmarkCompress(const char* filename)
+{
+    SDL_Surface* surface = LoadTexture(filename);
+    Texture* textures[3] = { Texture::CreateTexture(surface, LayoutTiled, FormatRGBA8), Texture::CreateTexture(surface, LayoutTiled, FormatBC1), Texture::CreateTexture(surface, LayoutTiled, FormatBC5) };
+    SDL_DestroySurface(surface);
+    if (textures[0] == NULL)
+    {
+        cout << "Cannot load " << filename << endl;
+        return;
+    }
+
+    const Texture* reference = textures[0];
+    cout << filename << ": " << reference->Width() << "x" << reference->Height() << ", " << reference->LevelCount() << " mip levels" << endl;
+
+    const int target_samples = 1 << 22;
+    float checksum = 0;
+    for (const Texture* texture : textures)
+    {
+        //  0 رȽ
+        int channels = texture->Format() == FormatBC5 ? 2 : 3;
+        double squared_error = 0;
+        for (int y = 0; y < reference->Height(); y++)
+        {
+            for (int x = 0; x < reference->Width(); x++)
+            {
+                uint32_t a = reference->Texel(0, x, y), b = texture->Texel(0, x, y);
+                for (int i = 0; i < channels; i++)
+                {
+                    double d = (double)((a >> (i * 8)) & 0xff) - (double)((b >> (i * 8)) & 0xff);
+                    squared_error += d * d;
+                }
+            }
+        }
+        double mse = squared_error / ((double)reference->Width() * reference->Height() * channels);
+
+        cout << "  " << TextureFormatName(texture->Format()) << ": " << texture->MemorySize() / (1024.0 * 1024.0) << " MB ("
+             << (double)reference->MemorySize() / texture->MemorySize() << "x smaller), PSNR ";
+        if (mse > 0)
+        {
+            cout << 10.0 * log10(255.0 * 255.0 / mse) << " dB";
+        }
+        else
+        {
+            cout << "inf";
+        }
+
+        // һһġĻ˫ԣԼС 0.3 ԣҪ
+        const float scales[] = { 1.0f, 0.3f };
+        for (float scale : scales)
+        {
+            TextureFilter filter = scale < 1.0f ? FilterTrilinear : FilterBilinear;
+            int size = std::max(1, (int)(std::max(texture->Width(), texture->Height()) * scale));
+            float step = 1.0f / size;
+            float lod = TextureLod(step, 0, 0, step);
+            long long samples = 0;
+
+            auto start = std::chrono::steady_clock::now();
+            Vec3 sum(0, 0, 0);
+            while (samples < target_samples)
+            {
+                for (int j = 0; j < size; j++)
+                {
+                    for (int i = 0; i < size; i++)
+                    {
+                        sum += texture->Sample((i + 0.5f) * step, (j + 0.5f) * step, lod, filter);
+                    }
+                }
+                samples += (long long)size * size;
+            }
+            auto end = std::chrono::steady_clock::now();
+            checksum += sum.x + sum.y + sum.z;
+
+            double seconds = std::chrono::duration<double>(end - start).count();
+            cout << ", " << TextureFilterName(filter) << " " << samples / seconds / 1e6 << " Msamples/s";
+        }
+        cout << endl;
+    }
+
+    cout << "  checksum " << checksum << endl;
+    for (Texture* texture : textures)
+    {
+        delete texture;
+    }
+}
+
+// ׶޳Ļ׼ԣѵģ̳ N x N 飨ÿһ RenderмֲغĬϳͬ·
+// 󲿷ֵ׶Զƽ֮⣬ֱرպʹ׶޳Ⱦ N ֡֡ʱ䡢׶εȽַʽһ֡Ļ
+void BenchmarkCull(const HeadlessOptions& options)
+{
+    BenchScene bench(options);
+    Model* plant = bench.plant;
+    Model* ground = bench.ground;
+    if (ground->nfaces() == 0)
+    {
+        cerr << "--bench-cull needs a ground model (" << options.ground << ")" << endl;
+        return;
+    }
+
+    // 鰴ģͰΧеĴС޷ƴӣԭΪ
+    Vec3 size = ground->mesh.bounds_max - ground->mesh.bounds_min;
+    std::vector<Mat4> ground_model_mats;
+    for (int z = 0; z < options.tiles; z++)
+    {
+        for (int x = 0; x < options.tiles; x++)
+        {
+            ground_model_mats.push_back(CreateTranslation(Vec3((x - (options.tiles - 1) * 0.5f) * size.x, 0, (z - (options.tiles - 1) * 0.5f) * size.z)));
+        }
+    }
+
+    std::vector<Light> lights = bench.lights;
+    int width = bench.width;
+    int height = bench.height;
+    Camera* camera = bench.camera;
+    std::vector<float>& z_buffer = bench.z_buffer;
+
+    cout << "Frustum culling benchmark: " << options.tiles << "x" << options.tiles << " ground tiles (" << ground_model_mats.size() * ground->nfaces() << " triangles) + plant, "
+         << options.frames << " frames, " << width << "x" << height << ", " << TileScheduler::Instance().WorkerCount() << " threads" << endl;
+
+    double mode_ms[2] = { 0, 0 };
+    for (int cull = 0; cull <= 1; cull++)
+    {
+        SetFrustumCullingEnabled(cull != 0);
+        Uint32* frame_buffer = bench.frame_buffers[cull].data();
+        RenderStats stats;
+        double total_ms = 0;
+        CollectRenderStats();
+
+        for (int frame = 0; frame < options.frames; frame++)
+        {
+            SetupFrame(frame, options.frames, camera, lights);
+            auto start = std::chrono::steady_clock::now();
+
+            ClearDepth(z_buffer);
+            DrawSky(frame_buffer, width, height);
+            for (const Mat4& model_mat : ground_model_mats)
+            {
+                Render(width, height, ground, model_mat, NULL, camera, NULL, frame_buffer, z_buffer, bench.ground_Mat, lights);
+            }
+            Render(width, height, plant, bench.plant_model_mat, NULL, camera, NULL, frame_buffer, z_buffer, bench.plant_Mat, lights, options.plant_cull);
+            ResolveDeferred(width, height, camera, frame_buffer, lights);
+
+            auto end = std::chrono::steady_clock::now();
+            total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+            stats += CollectRenderStats();
+        }
+
+        mode_ms[cull] = total_ms / options.frames;
+        cout << "  culling " << (cull ? "on" : "off") << ": " << mode_ms[cull] << " ms/frame, models culled " << stats.models_culled / options.frames
+             << ", vertices transformed " << stats.vertices_transformed / options.frames << ", triangles frustum culled " << stats.triangles_frustum_culled / options.frames
+             << ", back-face culled " << stats.triangles_backface_culled / options.frames << ", guard-band clipped " << stats.triangles_guard_clipped / options.frames
+             << ", submitted " << stats.triangles_submitted / options.frames << endl;
+    }
+
+    int different = 0;
+    for (int i = 0; i < width * height; i++)
+    {
+        different += bench.frame_buffers[0][i] != bench.frame_buffers[1][i];
+    }
+    if (mode_ms[1] > 0)
+    {
+        cout << "  speedup " << mode_ms[0] / mode_ms[1] << "x, last frame differs in " << different << " pixels" << endl;
+    }
+
+    SetFrustumCullingEnabled(true);
+}
+
+// Ļ׼ԣ̳ N x N 飬ÿмһֲʵ 128 ӵ 8192Ĭ·ڳ
+// Զƽ֮׶ʵɼɼʵ泡ÿִСֱʵԡBVHBVH ɽԶȾ N ֡
+void BenchmarkScene(const HeadlessOptions& options)
+{
+    BenchScene bench(options);
+    if (bench.ground->nfaces() == 0)
+    {
+        cerr << "--bench-scene needs a ground model (" << options.ground << ")" << endl;
+    }
+    else
+    {
+        std::vector<Light> lights = bench.lights;
+        int width = bench.width;
+        int height = bench.height;
+        Camera* camera = bench.camera;
+        Uint32* frame_buffer = bench.frame_buffers[0].data();
+        std::vector<float>& z_buffer = bench.z_buffer;
+        Vec3 size = bench.ground->mesh.bounds_max - bench.ground->mesh.bounds_min;
+
+        cout << "Scene benchmark: " << options.frames << " frames per run, " << width << "x" << height << ", " << TileScheduler::Instance().WorkerCount() << " threads" << endl;
+
+        const int grid_sizes[] = { 8, 16, 32, 64 };
+        for (int grid : grid_sizes)
+        {
+            // һԭ㣬Ĭϳͬ
+            Scene scene;
+            int ground_mesh = scene.AddMesh(bench.ground, NULL, NULL, bench.ground_Mat);
+            int plant_mesh = scene.AddMesh(bench.plant, bench.texture, bench.normal_map, bench.plant_Mat, options.plant_cull);
+            for (int z = 0; z < grid; z++)
+            {
+                for (int x = 0; x < grid; x++)
+                {
+                    Vec3 offset((x - grid / 2) * size.x, 0, (z - grid / 2) * size.z);
+                    scene.AddInstance(ground_mesh, CreateTranslation(offset));
+                    scene.AddInstance(plant_mesh, CreateTranslation(offset));
+                }
+            }
+
+            auto build_start = std::chrono::steady_clock::now();
+            scene.Build();
+            double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count();
+            cout << "  " << scene.InstanceCount() << " instances (BVH built in " << build_ms << " ms)" << endl;
+
+            const char* mode_names[] = { "linear", "BVH", "BVH + sort" };
+            for (int mode = 0; mode < 3; mode++)
+            {
+                scene.SetBVHEnabled(mode > 0);
+                scene.SetSortEnabled(mode > 1);
+                double total_ms = 0;
+                long long visible = 0, visited = 0;
+                RenderStats stats;
+                CollectRenderStats();
+
+                for (int frame = 0; frame < options.frames; frame++)
+                {
+                    SetupFrame(frame, options.frames, camera, lights);
+                    auto start = std::chrono::steady_clock::now();
+
+                    ClearDepth(z_buffer);
+                    DrawSky(frame_buffer, width, height);
+                    SceneStats scene_stats = scene.Draw(width, height, camera, frame_buffer, z_buffer, lights);
+                    ResolveDeferred(width, height, camera, frame_buffer, lights);
+
+                    auto end = std::chrono::steady_clock::now();
+                    total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+                    visible += scene_stats.instances_visible;
+                    visited += scene_stats.nodes_visited;
+                    stats += CollectRenderStats();
+                }
+
+                cout << "    " << mode_names[mode] << ": " << total_ms / options.frames << " ms/frame, visible instances " << visible / options.frames
+                     << ", boxes tested " << visited / options.frames << ", pixels depth-passed " << stats.pixels_depth_passed / options.frames << endl;
+            }
+        }
+    }
+}
+
+// LOD Ļ׼ԣֻһֲֲǰɽԶļϣÿֱرպʹ LOD Ⱦ N ֡
+// ѡеļ𡢱任Ķդ֡ʱ䣬ͳַʽһ֡в
+void BenchmarkLod(const HeadlessOptions& options)
+{
+    BenchScene bench(options);
+    Model* plant = bench.plant;
+    if (plant->nfaces() == 0)
+    {
+        cerr << "--bench-lod needs a plant model (" << options.plant << ")" << endl;
+    }
+    else
+    {
+        // ûлʱʱ OBJ 𼶼򻯣лʱֻӳļ
+        cout << "LOD benchmark: " << options.plant << " loaded in " << bench.plant_load_ms << " ms, " << plant->LodCount() << " levels" << endl;
+        for (int lod = 0; lod < plant->LodCount(); lod++)
+        {
+            const MeshView& mesh = plant->lods[lod];
+            cout << "  level " << lod << ": " << mesh.index_count / 3 << " triangles, " << mesh.vertex_count << " vertices, error " << mesh.error << endl;
+        }
+
+        int width = bench.width;
+        int height = bench.height;
+        Camera* camera = bench.camera;
+        Vec3 center = (plant->mesh.bounds_min + plant->mesh.bounds_max) * 0.5f;
+
+        cout << options.frames << " frames per run, " << width << "x" << height << ", " << TileScheduler::Instance().WorkerCount() << " threads, error threshold " << GetLodErrorPixels() << " px" << endl;
+
+        const float distances[] = { 3, 6, 12, 24, 48, 96 };
+        for (float distance : distances)
+        {
+            camera->position = center + Vec3(0, 0, distance);
+            camera->target = center;
+            cout << "  distance " << distance << " (level " << SelectLod(plant, bench.plant_model_mat, height, camera) << ")" << endl;
+
+            for (int lod = 0; lod <= 1; lod++)
+            {
+                SetLodEnabled(lod != 0);
+                Uint32* frame_buffer = bench.frame_buffers[lod].data();
+                RenderStats stats;
+                double total_ms = 0;
+                CollectRenderStats();
+
+                for (int frame = 0; frame < options.frames; frame++)
+                {
+                    auto start = std::chrono::steady_clock::now();
+
+                    ClearDepth(bench.z_buffer);
+                    DrawSky(frame_buffer, width, height);
+                    Render(width, height, plant, bench.plant_model_mat, bench.texture, camera, bench.normal_map, frame_buffer, bench.z_buffer, bench.plant_Mat, bench.lights, options.plant_cull);
+                    ResolveDeferred(width, height, camera, frame_buffer, bench.lights);
+
+                    auto end = std::chrono::steady_clock::now();
+                    total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+                    stats += CollectRenderStats();
+                }
+
+                cout << "    LOD " << (lod ? "on " : "off") << ": " << total_ms / options.frames << " ms/frame, vertices transformed " << stats.vertices_transformed / options.frames
+                     << ", triangles rasterized " << stats.triangles_submitted / options.frames << ", pixels depth passed " << stats.pixels_depth_passed / options.frames << endl;
+            }
+
+            int different = 0;
+            for (int i = 0; i < width * height; i++)
+            {
+                different += bench.frame_buffers[0][i] != bench.frame_buffers[1][i];
+            }
+            cout << "    last frame differs in " << different << " pixels" << endl;
+        }
+
+        SetLodEnabled(true);
+    }
+}
+
+// Դ޳Ļ׼ԣĬϳֲԴ֮ڵϷ N ð뾶Լ 2 ĵԴN  0 ӵ 1024
+// ÿ N ֱرպʹ򿪹Դ޳Ⱦ N ֡֡ʱ䡢ÿƽĹԴͽصĺʱȽַʽһ֡Ļ
+void BenchmarkLights(const HeadlessOptions& options)
+{
+    BenchScene bench(options);
+    Scene& scene = bench.scene;
+
+    // ԴڵķΧڣûеʱֲΧ 40 x 40 ķΧ
+    Vec3 area_min(-20, 0, -20), area_max(20, 0, 20);
+    if (bench.ground->nfaces() > 0)
+    {
+        area_min = bench.ground->mesh.bounds_min;
+        area_max = bench.ground->mesh.bounds_max;
+    }
+
+    int width = bench.width;
+    int height = bench.height;
+    Camera* camera = bench.camera;
+    std::vector<float>& z_buffer = bench.z_buffer;
+
+    cout << "Light culling benchmark: " << options.frames << " frames per run, " << width << "x" << height << ", " << TileScheduler::Instance().WorkerCount() << " threads, "
+         << CLUSTER_TILE_SIZE << "px tiles x " << CLUSTER_SLICES << " depth slices" << endl;
+
+    const int light_counts[] = { 0, 16, 64, 256, 1024 };
+    for (int extra : light_counts)
+    {
+        std::vector<Light> lights = bench.lights;
+
+        // ̶ӵͬÿеĹԴȫͬ
+        uint32_t seed = 12345;
+        auto random = [&seed]()
+        {
+            seed = seed * 1664525u + 1013904223u;
+            return (seed >> 8) / 16777216.0f;
+        };
+        for (int i = 0; i < extra; i++)
+        {
+            Vec3 position(area_min.x + (area_max.x - area_min.x) * random(), 0.2f + 2.0f * random(), area_min.z + (area_max.z - area_min.z) * random());
+            Vec3 color(0.3f + 0.7f * random(), 0.3f + 0.7f * random(), 0.3f + 0.7f * random());
+            lights.push_back(Light::Point(position, color, 1.0f, 1.0f, 60.0f));
+        }
+
+        cout << "  " << lights.size() << " lights (point light range " << lights.back().range << ")" << endl;
+
+        for (int culling = 0; culling <= 1; culling++)
+        {
+            SetLightCullingEnabled(culling != 0);
+            Uint32* frame_buffer = bench.frame_buffers[culling].data();
+            RenderStats stats;
+            double total_ms = 0;
+            CollectRenderStats();
+
+            for (int frame = 0; frame < options.frames; frame++)
+            {
+                SetupFrame(frame, options.frames, camera, lights);
+                auto start = std::chrono::steady_clock::now();
+
+                ClearDepth(z_buffer);
+                DrawSky(frame_buffer, width, height);
+                scene.Draw(width, height, camera, frame_buffer, z_buffer, lights);
+                ResolveDeferred(width, height, camera, frame_buffer, lights);
+
+                auto end = std::chrono::steady_clock::now();
+                total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+                stats += CollectRenderStats();
+            }
+
+            cout << "    culling " << (culling ? "on " : "off") << ": " << total_ms / options.frames << " ms/frame";
+            if (RENDERER_PROFILE)
+            {
+                double pixels = stats.pixels_shaded > 0 ? (double)stats.pixels_shaded : 1.0;
+                cout << ", " << stats.pixel_lights / pixels << " lights/pixel, " << total_ms * 1e6 / pixels << " ns/pixel";
+            }
+            cout << endl;
+        }
+
+        int different = 0;
+        for (int i = 0; i < width * height; i++)
+        {
+            different += bench.frame_buffers[0][i] != bench.frame_buffers[1][i];
+        }
+        cout << "    last frame differs in " << different << " pixels" << endl;
+    }
+
+    SetLightCullingEnabled(true);
+}
+
+// ӰĻ׼ԣĬϳֲͬ
+// һֹرջ棬ֻȾͼƽй͵Դȡֱַʣÿͼĺʱκдصٶ
+// ڶ·ȾӰͼͻֿʱԱȲӰӲӰ PCF ʱ汾֡ʱ䣬Լõͼ
+void BenchmarkShadows(const HeadlessOptions& options)
+{
+    BenchScene bench(options);
+    Scene& scene = bench.scene;
+
+    int width = bench.width;
+    int height = bench.height;
+    Camera* camera = bench.camera;
+    Uint32* frame_buffer = bench.frame_buffers[0].data();
+    std::vector<float>& z_buffer = bench.z_buffer;
+
+    cout << "Shadow mapping benchmark: " << options.frames << " frames per run, " << width << "x" << height << ", " << TileScheduler::Instance().WorkerCount() << " threads, "
+         << bench.plant->nfaces() + bench.ground->nfaces() << " caster triangles" << endl;
+
+    // ֻȾͼÿζػ
+    SetShadowMappingEnabled(true);
+    SetShadowCacheEnabled(false);
+    cout << "  Depth-only pass (cache off):" << endl;
+
+    struct DepthRun
+    {
+        LightType type;
+        int size;
+    };
+    const DepthRun depth_runs[] = { { Directional, 1024 }, { Directional, 2048 }, { Directional, 4096 }, { Point, 256 }, { Point, 512 }, { Point, 1024 } };
+    for (const DepthRun& run : depth_runs)
+    {
+        std::vector<Light> lights = { bench.lights[run.type == Directional ? 0 : 1] };
+        lights[0].shadow_size = run.size;
+
+        ShadowStats total;
+        double total_ms = 0;
+        for (int frame = 0; frame < options.frames; frame++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            ShadowStats stats = scene.UpdateShadows(lights);
+            auto end = std::chrono::steady_clock::now();
+            total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+
+            total.faces_rendered += stats.faces_rendered;
+            total.casters_culled += stats.casters_culled;
+            total.triangles_submitted += stats.triangles_submitted;
+            total.pixels_written += stats.pixels_written;
+        }
+
+        double seconds = total_ms / 1000.0;
+        cout << "    " << (run.type == Directional ? "directional " : "point cube  ") << run.size << "x" << run.size << ": " << total_ms / options.frames << " ms/map, "
+             << total.faces_rendered / options.frames << " faces, " << total.triangles_submitted / options.frames << " triangles, "
+             << (seconds > 0 ? total.triangles_submitted / seconds / 1e6 : 0) << " Mtriangles/s, " << (seconds > 0 ? total.pixels_written / seconds / 1e6 : 0) << " Mtexels/s written" << endl;
+    }
+    SetShadowCacheEnabled(true);
+
+    // ĬϳԴӰͼ뻭ֿʱ
+    cout << "  Orbit (directional 2048, point cube 512, cache on):" << endl;
+    const char* modes[] = { "no shadows", "hard", "PCF" };
+    for (int mode = 0; mode < 3; mode++)
+    {
+        SetShadowMappingEnabled(mode != 0);
+        SetShadowPCFEnabled(mode == 2);
+
+        std::vector<Light> lights = bench.lights;
+        lights[0].shadow_size = 2048;
+        lights[1].shadow_size = 512;
+
+        double shadow_ms = 0, color_ms = 0;
+        int maps_rendered = 0, maps_cached = 0;
+        for (int frame = 0; frame < options.frames; frame++)
+        {
+            SetupFrame(frame, options.frames, camera, lights);
+
+            auto start = std::chrono::steady_clock::now();
+            ShadowStats stats = scene.UpdateShadows(lights);
+            auto middle = std::chrono::steady_clock::now();
+
+            ClearDepth(z_buffer);
+            DrawSky(frame_buffer, width, height);
+            scene.Draw(width, height, camera, frame_buffer, z_buffer, lights);
+            ResolveDeferred(width, height, camera, frame_buffer, lights);
+
+            auto end = std::chrono::steady_clock::now();
+            shadow_ms += std::chrono::duration<double, std::milli>(middle - start).count();
+            color_ms += std::chrono::duration<double, std::milli>(end - middle).count();
+            maps_rendered += stats.maps_rendered;
+            maps_cached += stats.maps_cached;
+            CollectRenderStats();
+        }
+
+        cout << "    " << modes[mode] << ": shadow maps " << shadow_ms / options.frames << " ms/frame (" << maps_rendered << " rendered, " << maps_cached << " reused), color pass "
+             << color_ms / options.frames << " ms/frame" << endl;
+    }
+
+    SetShadowMappingEnabled(true);
+    SetShadowPCFEnabled(true);
+}
+
+// ɫϵĲԣ7 λÿ϶һֲͼ߹⡢ԴࡢӰѧľϾ
+// ÿϷֱ SSE4.1 ͱǰӳɫ·Ⱦ N ֡Աػ汾ʱжÿԵͨð汾֡ʱ䣬
+// һ֡ĻȫͬRender ѡҲԤһ£ģͻͼļʧʱóɵļͼ
+bool BenchmarkShaders(const HeadlessOptions& options)
+{
+    // ӰǴ򿪣ÿԼԴǷͶӰ
+    BenchScene bench(options, true);
+    SetShadowMappingEnabled(true);
+    Model* plant = bench.plant;
+    Model* ground = bench.ground;
+
+    int width = bench.width;
+    int height = bench.height;
+    Camera* camera = bench.camera;
+    std::vector<float>& z_buffer = bench.z_buffer;
+
+    cout << "Shader permutation test: " << options.frames << " frames per run, " << width << "x" << height << ", " << TileScheduler::Instance().WorkerCount() << " threads" << endl;
+    cout << "  features: D diffuse map, N normal map, S specular, d directional, p point, s shadows, F fast math; times are generic / specialized ms/frame" << endl;
+
+    const char* paths[] = { "SSE4.1 forward", "SSE4.1 deferred", "scalar forward", "scalar deferred" };
+    double path_ms[4][2] = {};
+    int tested = 0, failed = 0;
+    for (int features = 0; features < SHADER_PERMUTATIONS; features++)
+    {
+        string name;
+        const char* letters = "DNSdpsF";
+        for (int bit = 0; bit < 7; bit++)
+        {
+            name += (features & (1 << bit)) ? letters[bit] : '-';
+        }
+
+        // ӰֻԹԴ壬ûйԴʱ Render ѡӰ
+        bool has_lights = (features & (FeatureDirectional | FeaturePoint)) != 0;
+        if ((features & FeatureShadows) && !has_lights)
+        {
+            cout << "    " << name << ": unreachable (shadows without lights)" << endl;
+            continue;
+        }
+
+        SetFastMathEnabled((features & FeatureFastMath) != 0);
+        Texture* diffuse = (features & FeatureDiffuseMap) ? bench.texture : NULL;
+        Texture* normal = (features & FeatureNormalMap) ? bench.normal_map : NULL;
+        bool specular = (features & FeatureSpecular) != 0;
+        Material plant_Mat = bench.plant_Mat;
+        Material ground_Mat = bench.ground_Mat;
+        if (!specular)
+        {
+            plant_Mat.specular = 0.0f;
+            ground_Mat.specular = 0.0f;
+        }
+
+        Scene scene;
+        scene.AddInstance(scene.AddMesh(ground, diffuse, normal, ground_Mat), CreateTranslation(Vec3(0, 0, 0)));
+        scene.AddInstance(scene.AddMesh(plant, diffuse, normal, plant_Mat, options.plant_cull), CreateScale(Vec3(1.0f, 1.0f, 1.0f)));
+
+        // ͵Դ˶ĬϳͬSetupFrame д motion ٿõĹԴ
+        std::vector<Light> motion = bench.lights;
+        motion[0].shadow_size = (features & FeatureShadows) ? 1024 : 0;
+        motion[1].shadow_size = (features & FeatureShadows) ? 256 : 0;
+        std::vector<Light> lights;
+        int point = -1;
+        if (features & FeatureDirectional)
+        {
+            lights.push_back(motion[0]);
+        }
+        if (features & FeaturePoint)
+        {
+            point = (int)lights.size();
+            lights.push_back(motion[1]);
+        }
+
+        cout << "    " << name << ":";
+        bool passed = true;
+        for (int path = 0; path < 4; path++)
+        {
+            SetSIMDEnabled(path < 2);
+            SetDeferredEnabled(path % 2 == 1);
+
+            double ms[2] = {};
+            for (int specialized = 0; specialized <= 1; specialized++)
+            {
+                SetShaderSpecializationEnabled(specialized != 0);
+                Uint32* frame_buffer = bench.frame_buffers[specialized].data();
+                for (int frame = 0; frame < options.frames; frame++)
+                {
+                    SetupFrame(frame, options.frames, camera, motion);
+                    if (point >= 0)
+                    {
+                        lights[point].position = motion[1].position;
+                    }
+                    scene.UpdateShadows(lights);
+
+                    auto start = std::chrono::steady_clock::now();
+                    ClearDepth(z_buffer);
+                    DrawSky(frame_buffer, width, height);
+                    scene.Draw(width, height, camera, frame_buffer, z_buffer, lights);
+                    ResolveDeferred(width, height, camera, frame_buffer, lights);
+                    auto end = std::chrono::steady_clock::now();
+                    ms[specialized] += std::chrono::duration<double, std::milli>(end - start).count();
+                    CollectRenderStats();
+                }
+                ms[specialized] /= options.frames;
+                path_ms[path][specialized] += ms[specialized];
+            }
+
+            int different = 0;
+            for (int i = 0; i < width * height; i++)
+            {
+                different += bench.frame_buffers[0][i] != bench.frame_buffers[1][i];
+            }
+            cout << " " << ms[0] << " / " << ms[1];
+            if (different > 0)
+            {
+                cout << " (" << paths[path] << " differs in " << different << " pixels)";
+                passed = false;
+            }
+            cout << ",";
+        }
+
+        // ֲĲʺ͹ԴѡӦ
+        SurfaceMaterial surface = { plant_Mat, diffuse, normal, GetTextureFilter() };
+        int selected = SelectShaderFeatures(surface, lights);
+        if (selected != features)
+        {
+            cout << " selected features " << selected << " instead of " << features;
+            passed = false;
+        }
+        cout << (passed ? " ok" : " FAILED") << endl;
+
+        tested++;
+        failed += !passed;
+    }
+
+    cout << "  Mean over " << tested << " permutations (generic / specialized ms/frame):" << endl;
+    for (int path = 0; path < 4; path++)
+    {
+        cout << "    " << paths[path] << ": " << path_ms[path][0] / tested << " / " << path_ms[path][1] / tested << endl;
+    }
+    cout << "  " << tested - failed << " of " << tested << " permutations match" << endl;
+
+    SetSIMDEnabled(true);
+    SetDeferredEnabled(false);
+    SetShaderSpecializationEnabled(true);
+    SetFastMathEnabled(false);
+    SetShadowPCFEnabled(true);
+    return failed == 0;
+}
+
+// ɵ 64x64 ͼͼļʧʱ棺ͼǲɫĸӣͼ߿ռĲ
+SDL_Surface* CreatePatternSurface(bool normal_map)
+{
+    const int size = 64;
+    SDL_Surface* surface = SDL_CreateSurface(size, size, SDL_PIXELFORMAT_RGBA32);
+    if (surface == NULL)
+    {
+        return NULL;
+    }
+
+    for (int y = 0; y < size; y++)
+    {
+        Uint8* row = (Uint8*)surface->pixels + y * surface->pitch;
+        for (int x = 0; x < size; x++)
+        {
+            Uint8* pixel = row + x * 4;
+            if (normal_map)
+            {
+                float nx = 0.4f * sinf(x * 0.4f);
+                float ny = 0.4f * cosf(y * 0.3f);
+                float nz = sqrtf(1.0f - nx * nx - ny * ny);
+                pixel[0] = (Uint8)((nx * 0.5f + 0.5f) * 255.0f);
+                pixel[1] = (Uint8)((ny * 0.5f + 0.5f) * 255.0f);
+                pixel[2] = (Uint8)((nz * 0.5f + 0.5f) * 255.0f);
+            }
+            else
+            {
+                bool odd = ((x / 8) + (y / 8)) % 2 != 0;
+                pixel[0] = (Uint8)(x * 4);
+                pixel[1] = (Uint8)(y * 4);
+                pixel[2] = odd ? 200 : 60;
+            }
+            pixel[3] = 255;
+        }
+    }
+    return surface;
+}
+
+// ͼļתָзʽ͸ʽļΪջʧʱpattern Ϊ true óɵͼ棬򷵻 NULL
+Texture* LoadBenchTexture(const string& filename, bool normal_map, TextureLayout layout, TextureFormat format, bool pattern)
+{
+    SDL_Surface* surface = filename.empty() ? NULL : LoadTexture(filename.c_str());
+    if (surface == NULL && pattern)
+    {
+        surface = CreatePatternSurface(normal_map);
+    }
+    Texture* texture = Texture::CreateTexture(surface, layout, format);
+    SDL_DestroySurface(surface);
+    return texture;
+}
+
+// ɵģͣģļʧʱ
+//  ground.obj һ 40 x 4010 x 10 ƽ棬һΣֲﻻһ뾶 1.5ԭľγ㹻ɸ LOD
+Model* CreatePatternModel(bool ground)
+{
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+    if (ground)
+    {
+        const int cells = 10;
+        for (int z = 0; z <= cells; z++)
+        {
+            for (int x = 0; x <= cells; x++)
+            {
+                MeshVertex v = {};
+                v.position = Vec3(-20.0f + 40.0f * x / cells, 0.0f, -20.0f + 40.0f * z / cells);
+                v.texcoord = Vec2((float)x / cells, (float)z / cells);
+                v.normal = Vec3(0, 1, 0);
+                vertices.push_back(v);
+            }
+        }
+        for (int z = 0; z < cells; z++)
+        {
+            for (int x = 0; x < cells; x++)
+            {
+                uint32_t a = z * (cells + 1) + x, b = a + cells + 1;
+                indices.insert(indices.end(), { a, b, b + 1, a, b + 1, a + 1 });
+            }
+        }
+    }
+    else
+    {
+        const int slices = 32, stacks = 16;
+        const float radius = 1.5f;
+        for (int i = 0; i <= stacks; i++)
+        {
+            float theta = to_radians(180.0f * i / stacks);
+            for (int j = 0; j <= slices; j++)
+            {
+                float phi = to_radians(360.0f * j / slices);
+                MeshVertex v = {};
+                v.normal = Vec3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+                v.position = Vec3(0, radius, 0) + v.normal * radius;
+                v.texcoord = Vec2((float)j / slices, 1.0f - (float)i / stacks);
+                vertices.push_back(v);
+            }
+        }
+        // һȦֻһΣһ˻߶
+        for (int i = 0; i < stacks; i++)
+        {
+            for (int j = 0; j < slices; j++)
+            {
+                uint32_t a = i * (slices + 1) + j, b = a + slices + 1;
+                if (i > 0)
+                {
+                    indices.insert(indices.end(), { a, a + 1, b });
+                }
+                if (i < stacks - 1)
+                {
+                    indices.insert(indices.end(), { a + 1, b + 1, b });
+                }
+            }
+        }
+    }
+    ComputeTangents(vertices, indices);
+    return new Model(std::move(vertices), std::move(indices));
+}
+
+// ʱʱѽۼӵⱻûõļȥ
+static volatile float math_sink;
+
+//  inputs еÿֵ kernelظ passes 飬ÿεõ
+template <typename T, typename Kernel>
+static double TimeKernel(const std::vector<T>& inputs, int passes, Kernel kernel)
+{
+    float sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++)
+    {
+        for (const T& x : inputs)
+        {
+            sum += kernel(x);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    math_sink = sum;
+    return std::chrono::duration<double, std::nano>(end - start).count() / ((double)passes * inputs.size());
+}
+
+#if RENDERER_HAS_SSE41
+// 4 ·ı⺯operator() Ҫ SSE4.1  TimeKernel4  ApplyKernel4 
+struct ExactRsqrtKernel4
+{
+    SSE41_TARGET __m128 operator()(__m128 x) const { return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(x)); }
+};
+
+struct FastRsqrtKernel4
+{
+    SSE41_TARGET __m128 operator()(__m128 x) const { return FastRsqrt4(x); }
+};
+
+struct FastLog2Kernel4
+{
+    SSE41_TARGET __m128 operator()(__m128 x) const { return FastLog2x4(x); }
+};
+
+struct FastExp2Kernel4
+{
+    SSE41_TARGET __m128 operator()(__m128 x) const { return FastExp2x4(x); }
+};
+
+struct ExactPowKernel4
+{
+    float p;
+    SSE41_TARGET __m128 operator()(__m128 x) const { return Pow4(x, p); }
+};
+
+struct FastPowKernel4
+{
+    float p;
+    SSE41_TARGET __m128 operator()(__m128 x) const { return FastPow4(x, p); }
+};
+
+// ÿδ 4 ֵ TimeKernelinputs ĸ 4 ı
+template <typename Kernel>
+static SSE41_TARGET double TimeKernel4(const std::vector<float>& inputs, int passes, Kernel kernel)
+{
+    __m128 sum = _mm_setzero_ps();
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++)
+    {
+        for (size_t i = 0; i < inputs.size(); i += 4)
+        {
+            sum = _mm_add_ps(sum, kernel(_mm_loadu_ps(&inputs[i])));
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    math_sink = _mm_cvtss_f32(sum);
+    return std::chrono::duration<double, std::nano>(end - start).count() / ((double)passes * inputs.size());
+}
+
+//  kernel Ľд outputsڼ
+template <typename Kernel>
+static SSE41_TARGET void ApplyKernel4(const std::vector<float>& inputs, std::vector<float>& outputs, Kernel kernel)
+{
+    outputs.resize(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i += 4)
+    {
+        _mm_storeu_ps(&outputs[i], kernel(_mm_loadu_ps(&inputs[i])));
+    }
+}
+#endif
+
+// ѧĻ׼
+// һڹл뷶Χڸȡ 1M ֵ double ļΪ׼ٽƵ
+// ԼȷͿ㷨ıSSE4.1 汾ÿεõݺֻͳƽС 1/256 
+// ڶ·ֱþȷͿٵѧȾĬϳ N ֡Ա֡ʱһ֡Ļ
+// 1/sqrt(x)log22^x ݺ FastMath.h еʱ false
+bool BenchmarkMath(const HeadlessOptions& options)
+{
+    const int count = 1 << 20;
+    const int passes = 10;
+
+    // ̶ӵͬÿеȫͬ
+    uint32_t seed = 12345;
+    auto random = [&seed]()
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / 16777216.0f;
+    };
+
+    std::vector<float> rsqrt_inputs(count), unit_inputs(count);
+    std::vector<Vec3> vector_inputs(count);
+    for (int i = 0; i < count; i++)
+    {
+        rsqrt_inputs[i] = powf(10.0f, -4.0f + 8.0f * random());
+        unit_inputs[i] = random();
+        Vec3 v;
+        do
+        {
+            v = Vec3(random() * 2 - 1, random() * 2 - 1, random() * 2 - 1);
+        } while (dot(v, v) < 1e-6f);
+        vector_inputs[i] = v;
+    }
+    std::vector<float> exp2_inputs(count);
+    for (int i = 0; i < count; i++)
+    {
+        exp2_inputs[i] = -126.0f + 253.0f * random();
+    }
+
+    // õʱһʧܣ EXCEEDED
+    int exceeded = 0;
+    auto check_bound = [&exceeded](double error, double bound)
+    {
+        exceeded += error > bound;
+        return error > bound ? " EXCEEDED" : "";
+    };
+
+    bool sse = RENDERER_HAS_SSE41 && CpuSupportsSSE41();
+    cout << "Fast math benchmark: " << count << " inputs x " << passes << " passes, ns per value (exact -> fast)" << endl;
+
+    // 1/sqrt(x)x  [1e-4, 1e4] ֮䰴ȷֲ
+    double rsqrt_error = 0;
+    for (float x : rsqrt_inputs)
+    {
+        rsqrt_error = std::max(rsqrt_error, fabs(FastRsqrt(x) * sqrt((double)x) - 1.0));
+    }
+    cout << "  1/sqrt(x), x in [1e-4, 1e4]: max relative error " << rsqrt_error << " (scalar)";
+#if RENDERER_HAS_SSE41
+    double rsqrt_error4 = 0;
+    if (sse)
+    {
+        std::vector<float> outputs;
+        ApplyKernel4(rsqrt_inputs, outputs, FastRsqrtKernel4());
+        for (int i = 0; i < count; i++)
+        {
+            rsqrt_error4 = std::max(rsqrt_error4, fabs(outputs[i] * sqrt((double)rsqrt_inputs[i]) - 1.0));
+        }
+        cout << ", " << rsqrt_error4 << " (SSE4.1)" << check_bound(rsqrt_error4, FAST_RSQRT_MAX_ERROR);
+    }
+#endif
+    cout << "; bound " << (FAST_MATH_SCALAR_SSE ? FAST_RSQRT_MAX_ERROR : FAST_RSQRT_NO_SSE_MAX_ERROR) << check_bound(rsqrt_error, FAST_MATH_SCALAR_SSE ? FAST_RSQRT_MAX_ERROR : FAST_RSQRT_NO_SSE_MAX_ERROR) << endl;
+    cout << "    scalar " << TimeKernel(rsqrt_inputs, passes, [](float x) { return 1.0f / std::sqrt(x); }) << " -> " << TimeKernel(rsqrt_inputs, passes, [](float x) { return FastRsqrt(x); });
+#if RENDERER_HAS_SSE41
+    if (sse)
+    {
+        cout << ", SSE4.1 " << TimeKernel4(rsqrt_inputs, passes, ExactRsqrtKernel4()) << " -> " << TimeKernel4(rsqrt_inputs, passes, FastRsqrtKernel4());
+    }
+#endif
+    cout << endl;
+
+    // log2(x)x  1/sqrt(x) ͬx = 1 ʱȷֵ 0
+    double log2_error = 0;
+    for (float x : rsqrt_inputs)
+    {
+        double exact = log2((double)x);
+        if (exact != 0)
+        {
+            log2_error = std::max(log2_error, fabs(FastLog2(x) / exact - 1.0));
+        }
+    }
+    cout << "  log2(x), x in [1e-4, 1e4]: max relative error " << log2_error << " (scalar)";
+#if RENDERER_HAS_SSE41
+    if (sse)
+    {
+        std::vector<float> outputs;
+        ApplyKernel4(rsqrt_inputs, outputs, FastLog2Kernel4());
+        double log2_error4 = 0;
+        for (int i = 0; i < count; i++)
+        {
+            double exact = log2((double)rsqrt_inputs[i]);
+            if (exact != 0)
+            {
+                log2_error4 = std::max(log2_error4, fabs(outputs[i] / exact - 1.0));
+            }
+        }
+        cout << ", " << log2_error4 << " (SSE4.1)" << check_bound(log2_error4, FAST_LOG2_MAX_ERROR);
+    }
+#endif
+    cout << "; bound " << FAST_LOG2_MAX_ERROR << check_bound(log2_error, FAST_LOG2_MAX_ERROR) << endl;
+    cout << "    scalar " << TimeKernel(rsqrt_inputs, passes, [](float x) { return std::log2(x); }) << " -> " << TimeKernel(rsqrt_inputs, passes, [](float x) { return FastLog2(x); });
+#if RENDERER_HAS_SSE41
+    if (sse)
+    {
+        cout << ", SSE4.1 fast " << TimeKernel4(rsqrt_inputs, passes, FastLog2Kernel4());
+    }
+#endif
+    cout << endl;
+
+    // 2^xx  FastExp2  [-126, 127] ھȷֲ
+    double exp2_error = 0;
+    for (float x : exp2_inputs)
+    {
+        exp2_error = std::max(exp2_error, fabs(FastExp2(x) / exp2((double)x) - 1.0));
+    }
+    cout << "  2^x, x in [-126, 127]: max relative error " << exp2_error << " (scalar)";
+#if RENDERER_HAS_SSE41
+    if (sse)
+    {
+        std::vector<float> outputs;
+        ApplyKernel4(exp2_inputs, outputs, FastExp2Kernel4());
+        double exp2_error4 = 0;
+        for (int i = 0; i < count; i++)
+        {
+            exp2_error4 = std::max(exp2_error4, fabs(outputs[i] / exp2((double)exp2_inputs[i]) - 1.0));
+        }
+        cout << ", " << exp2_error4 << " (SSE4.1)" << check_bound(exp2_error4, FAST_EXP2_MAX_ERROR);
+    }
+#endif
+    cout << "; bound " << FAST_EXP2_MAX_ERROR << check_bound(exp2_error, FAST_EXP2_MAX_ERROR) << endl;
+    cout << "    scalar " << TimeKernel(exp2_inputs, passes, [](float x) { return std::exp2(x); }) << " -> " << TimeKernel(exp2_inputs, passes, [](float x) { return FastExp2(x); });
+#if RENDERER_HAS_SSE41
+    if (sse)
+    {
+        cout << ", SSE4.1 fast " << TimeKernel4(exp2_inputs, passes, FastExp2Kernel4());
+    }
+#endif
+    cout << endl;
+
+    // һĸ [-1, 1] ֮
+    double normalize_error = 0;
+    for (const Vec3& v : vector_inputs)
+    {
+        Vec3 n = normalize(v, MathFast);
+        double len = sqrt((double)v.x * v.x + (double)v.y * v.y + (double)v.z * v.z);
+        normalize_error = std::max({ normalize_error, fabs(n.x - v.x / len), fabs(n.y - v.y / len), fabs(n.z - v.z / len) });
+    }
+    cout << "  normalize(v), |v| in (0, 1.7]: max component error " << normalize_error << endl;
+    cout << "    scalar " << TimeKernel(vector_inputs, passes, [](const Vec3& v) { Vec3 n = normalize(v); return n.x + n.y + n.z; }) << " -> "
+         << TimeKernel(vector_inputs, passes, [](const Vec3& v) { Vec3 n = normalize(v, MathFast); return n.x + n.y + n.z; }) << endl;
+
+    // cosTheta  [0, 1] ֮
+    double fresnel_error = 0;
+    for (float c : unit_inputs)
+    {
+        fresnel_error = std::max(fresnel_error, fabs(SchlickFresnel(c, 0.04f, MathFast) - (0.04 + 0.96 * pow(1.0 - c, 5.0))));
+    }
+    cout << "  Schlick Fresnel, cosTheta in [0, 1]: max absolute error " << fresnel_error << endl;
+    cout << "    scalar " << TimeKernel(unit_inputs, passes, [](float c) { return SchlickFresnel(c, 0.04f, MathExact); }) << " -> "
+         << TimeKernel(unit_inputs, passes, [](float c) { return SchlickFresnel(c, 0.04f, MathFast); }) << endl;
+
+    // ߹ݺָĬϳֲ͵ shininess * 4
+    const float powers[] = { 20.0f, 128.0f };
+    for (float p : powers)
+    {
+        double abs_error = 0, rel_error = 0;
+        for (float x : unit_inputs)
+        {
+            double exact = pow((double)x, (double)p);
+            double fast = SpecularPow(x, p, MathFast);
+            abs_error = std::max(abs_error, fabs(fast - exact));
+            if (exact >= 1.0 / 256)
+            {
+                rel_error = std::max(rel_error, fabs(fast / exact - 1.0));
+            }
+        }
+        cout << "  x^" << p << ", x in [0, 1]: max relative error " << rel_error << ", max absolute error " << abs_error << " (scalar)";
+#if RENDERER_HAS_SSE41
+        if (sse)
+        {
+            std::vector<float> outputs;
+            ApplyKernel4(unit_inputs, outputs, FastPowKernel4{ p });
+            double rel_error4 = 0;
+            for (int i = 0; i < count; i++)
+            {
+                double exact = pow((double)unit_inputs[i], (double)p);
+                if (exact >= 1.0 / 256)
+                {
+                    rel_error4 = std::max(rel_error4, fabs(outputs[i] / exact - 1.0));
+                }
+            }
+            cout << ", relative " << rel_error4 << " (SSE4.1)" << check_bound(rel_error4, SPECULAR_POW_MAX_ERROR);
+        }
+#endif
+        cout << "; relative bound " << SPECULAR_POW_MAX_ERROR << check_bound(rel_error, SPECULAR_POW_MAX_ERROR) << endl;
+        cout << "    scalar " << TimeKernel(unit_inputs, passes, [p](float x) { return SpecularPow(x, p, MathExact); }) << " -> " << TimeKernel(unit_inputs, passes, [p](float x) { return SpecularPow(x, p, MathFast); });
+#if RENDERER_HAS_SSE41
+        if (sse)
+        {
+            cout << ", SSE4.1 " << TimeKernel4(unit_inputs, passes, ExactPowKernel4{ p }) << " -> " << TimeKernel4(unit_inputs, passes, FastPowKernel4{ p });
+        }
+#endif
+        cout << endl;
+    }
+
+    // Ĭϳ־ȸȾ N ֡
+    BenchScene bench(options);
+    Scene& scene = bench.scene;
+    int width = bench.width;
+    int height = bench.height;
+    Camera* camera = bench.camera;
+    std::vector<float>& z_buffer = bench.z_buffer;
+
+    cout << "  Orbit: " << options.frames << " frames, " << width << "x" << height << " (" << (IsSIMDEnabled() ? "SSE4.1" : "scalar") << ", " << (IsDeferredEnabled() ? "deferred" : "forward") << ", "
+         << TileScheduler::Instance().WorkerCount() << " threads)" << endl;
+    for (int fast = 0; fast <= 1; fast++)
+    {
+        SetFastMathEnabled(fast != 0);
+        std::vector<Light> lights = bench.lights;
+        lights[0].shadow_size = 2048;
+        lights[1].shadow_size = 512;
+
+        Uint32* frame_buffer = bench.frame_buffers[fast].data();
+        double total_ms = 0;
+        uint64_t pixels = 0;
+        for (int frame = 0; frame < options.frames; frame++)
+        {
+            SetupFrame(frame, options.frames, camera, lights);
+            scene.UpdateShadows(lights);
+
+            auto start = std::chrono::steady_clock::now();
+            ClearDepth(z_buffer);
+            DrawSky(frame_buffer, width, height);
+            scene.Draw(width, height, camera, frame_buffer, z_buffer, lights);
+            ResolveDeferred(width, height, camera, frame_buffer, lights);
+            auto end = std::chrono::steady_clock::now();
+            total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+            pixels += CollectRenderStats().pixels_shaded;
+        }
+
+        cout << "    " << (fast ? "fast " : "exact") << ": " << total_ms / options.frames << " ms/frame";
+        if (RENDERER_PROFILE)
+        {
+            cout << ", " << total_ms * 1e6 / std::max(pixels, (uint64_t)1) << " ns/shaded pixel";
+        }
+        cout << endl;
+    }
+
+    // һ֡ͨȽ
+    int different = 0, max_difference = 0;
+    for (int i = 0; i < width * height; i++)
+    {
+        Uint32 a = bench.frame_buffers[0][i], b = bench.frame_buffers[1][i];
+        different += a != b;
+        for (int shift = 0; shift < 24; shift += 8)
+        {
+            max_difference = std::max(max_difference, abs((int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff)));
+        }
+    }
+    cout << "    last frame differs in " << different << " pixels, by at most " << max_difference << "/255 per channel" << endl;
+
+    if (exceeded > 0)
+    {
+        cout << "  " << exceeded << " measured errors exceed the bounds in FastMath.h" << endl;
+    }
+    else
+    {
+        cout << "  All measured errors are within the bounds in FastMath.h" << endl;
+    }
+
+    SetFastMathEnabled(false);
+    return exceeded == 0;
+}
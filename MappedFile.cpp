@@ -0,0 +1,118 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+MappedFile::MappedFile(const char* filename) : is_open(false), data(NULL), size(0), file_handle(INVALID_HANDLE_VALUE), mapping_handle(NULL)
+{
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+	file_handle = file;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size))
+	{
+		return;
+	}
+
+	size = (size_t)file_size.QuadPart;
+	if (size == 0)
+	{
+		is_open = true;// ļܴӳ
+		return;
+	}
+
+	mapping_handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping_handle == NULL)
+	{
+		size = 0;
+		return;
+	}
+
+	data = (const char*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL)
+	{
+		size = 0;
+		return;
+	}
+
+	is_open = true;
+}
+
+MappedFile::~MappedFile()
+{
+	if (data != NULL)
+	{
+		UnmapViewOfFile(data);
+	}
+	if (mapping_handle != NULL)
+	{
+		CloseHandle(mapping_handle);
+	}
+	if (file_handle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file_handle);
+	}
+}
+
+#else
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::MappedFile(const char* filename) : is_open(false), data(NULL), size(0), fd(-1)
+{
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+	{
+		return;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		return;
+	}
+
+	size = (size_t)st.st_size;
+	if (size == 0)
+	{
+		is_open = true;// ļܴӳ
+		return;
+	}
+
+	void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapped == MAP_FAILED)
+	{
+		size = 0;
+		return;
+	}
+
+	// ں˻˳ȡǰԤ
+	madvise(mapped, size, MADV_SEQUENTIAL);
+
+	data = (const char*)mapped;
+	is_open = true;
+}
+
+MappedFile::~MappedFile()
+{
+	if (data != NULL)
+	{
+		munmap((void*)data, size);
+	}
+	if (fd >= 0)
+	{
+		close(fd);
+	}
+}
+
+#endif
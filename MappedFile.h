@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+
+// ֻڴӳļļֱӳ䵽̵ַռ䣬Ҫȶ
+class MappedFile
+{
+public:
+	explicit MappedFile(const char* filename);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// ļ򿪲ӳɹļҲɹʱ Data() Ϊ NULL
+	bool IsOpen() const { return is_open; }
+	const char* Data() const { return data; }
+	size_t Size() const { return size; }
+
+private:
+	bool is_open;
+	const char* data;
+	size_t size;
+
+#if defined(_WIN32)
+	void* file_handle;
+	void* mapping_handle;
+#else
+	int fd;
+#endif
+};
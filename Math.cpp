@@ -2,73 +2,6 @@
 
 constexpr double PI = 3.14159265358979323846;
 
-// Vec2
-Vec2 operator+(const Vec2& a, const Vec2& b)
-{
-	return Vec2(a.x + b.x, a.y + b.y);
-}
-
-Vec2 operator-(const Vec2& a, const Vec2& b)
-{
-	return Vec2(a.x - b.x, a.y - b.y);
-}
-
-Vec2 operator*(const Vec2& v, float scalar)
-{
-	return Vec2(v.x * scalar, v.y * scalar);
-}
-
-// Vec3
-Vec3 operator+(const Vec3& a, const Vec3& b)
-{
-	return Vec3(a.x + b.x, a.y + b.y, a.z + b.z);
-}
-
-Vec3 operator-(const Vec3& a, const Vec3& b)
-{
-	return Vec3(a.x - b.x, a.y - b.y, a.z - b.z);
-}
-
-Vec3 operator*(const Vec3& v, float scalar)
-{
-	return Vec3(v.x * scalar, v.y * scalar, v.z * scalar);
-}
-
-Vec3 operator*(const Vec3& v1, const Vec3& v2)
-{
-	return Vec3(v1.x * v2.x, v1.y * v2.y, v1.z * v2.z);
-}
-
-float dot(const Vec3& a, const Vec3& b)
-{
-	return a.x * b.x + a.y * b.y + a.z * b.z;
-}
-
-Vec3 cross(const Vec3& a, const Vec3& b)
-{
-	return Vec3(a.y * b.z - a.z * b.y,
-				a.z * b.x - a.x * b.z,
-				a.x * b.y - a.y * b.x);
-}
-
-float length(const Vec3& v)
-{
-	return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
-}
-
-Vec3 normalize(const Vec3& v)
-{
-	float len = length(v);
-
-	//lenӽ0ʱ㣬ؿ
-	if (len > 1e-6)
-	{
-		return v * (1.0f / len);//ΪܣӦõ˷
-	}
-
-	return Vec3();
-}
-
 Uint32 Vec3ToUint32(const Vec3& color)
 {
 	//ֹɫ
@@ -198,6 +131,21 @@ Mat4 CreatePerspective(float fovY, float aspect, float nearZ, float farZ)
 	return perspective;
 }
 
+// ͶӰӿռ [left, right] x [bottom, top] x [-nearZ, -farZ] ӳ䵽 NDC  [-1, 1]^3w ʼΪ 1
+Mat4 CreateOrthographic(float left, float right, float bottom, float top, float nearZ, float farZ)
+{
+	Mat4 orthographic = Mat4::Indentity();
+
+	orthographic.m[0][0] = 2.0f / (right - left);
+	orthographic.m[0][3] = -(right + left) / (right - left);
+	orthographic.m[1][1] = 2.0f / (top - bottom);
+	orthographic.m[1][3] = -(top + bottom) / (top - bottom);
+	orthographic.m[2][2] = -2.0f / (farZ - nearZ);
+	orthographic.m[2][3] = -(farZ + nearZ) / (farZ - nearZ);
+
+	return orthographic;
+}
+
 float to_radians(float angle)
 {
 	return angle * PI / 180;
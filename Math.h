@@ -14,9 +14,21 @@ struct Vec2
 	Vec2(float x, float y) : x(x), y(y) {}
 };
 
-Vec2 operator+(const Vec2& a, const Vec2& b);
-Vec2 operator-(const Vec2& a, const Vec2& b);
-Vec2 operator*(const Vec2& v, float scalar);
+// Сͷļɫڲѭп
+inline Vec2 operator+(const Vec2& a, const Vec2& b)
+{
+	return Vec2(a.x + b.x, a.y + b.y);
+}
+
+inline Vec2 operator-(const Vec2& a, const Vec2& b)
+{
+	return Vec2(a.x - b.x, a.y - b.y);
+}
+
+inline Vec2 operator*(const Vec2& v, float scalar)
+{
+	return Vec2(v.x * scalar, v.y * scalar);
+}
 
 // ʵһά
 struct Vec4
@@ -56,15 +68,56 @@ struct Vec3
 	}
 };
 
-Vec3 operator+(const Vec3& a, const Vec3& b);
-Vec3 operator-(const Vec3& a, const Vec3& b);
-Vec3 operator*(const Vec3& v, float scalar);
-Vec3 operator*(const Vec3& v1, const Vec3& v2);
+inline Vec3 operator+(const Vec3& a, const Vec3& b)
+{
+	return Vec3(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+inline Vec3 operator-(const Vec3& a, const Vec3& b)
+{
+	return Vec3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+inline Vec3 operator*(const Vec3& v, float scalar)
+{
+	return Vec3(v.x * scalar, v.y * scalar, v.z * scalar);
+}
+
+inline Vec3 operator*(const Vec3& v1, const Vec3& v2)
+{
+	return Vec3(v1.x * v2.x, v1.y * v2.y, v1.z * v2.z);
+}
+
+inline float dot(const Vec3& a, const Vec3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Vec3 cross(const Vec3& a, const Vec3& b)
+{
+	return Vec3(a.y * b.z - a.z * b.y,
+				a.z * b.x - a.x * b.z,
+				a.x * b.y - a.y * b.x);
+}
+
+inline float length(const Vec3& v)
+{
+	return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+}
+
+inline Vec3 normalize(const Vec3& v)
+{
+	float len = length(v);
+
+	//lenӽ0ʱ㣬ؿ
+	if (len > 1e-6)
+	{
+		return v * (1.0f / len);//ΪܣӦõ˷
+	}
+
+	return Vec3();
+}
 
-float dot(const Vec3& a, const Vec3& b);
-Vec3 cross(const Vec3& a, const Vec3& b);
-float length(const Vec3& v);
-inline Vec3 normalize(const Vec3& v);
 Uint32 Vec3ToUint32(const Vec3& color);
 
 //ʵһ 4x4 
@@ -99,5 +152,6 @@ Mat4 CreateRotation(const Vec3& axis, float radians);
 Mat4 CreateScale(const Vec3& s);
 Mat4 CreateView(const Vec3& position, const Vec3& target, const Vec3& worldup);
 Mat4 CreatePerspective(float fovY, float aspect, float nearZ, float farZ);
+Mat4 CreateOrthographic(float left, float right, float bottom, float top, float nearZ, float farZ);
 
 float to_radians(float angle);
\ No newline at end of file
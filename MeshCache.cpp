@@ -0,0 +1,285 @@
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+
+#include "MeshCache.h"
+#include "MeshSimplify.h"
+
+static const char MESH_CACHE_MAGIC[4] = { 'R', 'L', 'M', 'C' };
+
+uint64_t HashBytes(const char* data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint64_t HashFile(const char* filename)
+{
+	MappedFile file(filename);
+	return HashBytes(file.Data(), file.Size());
+}
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// OBJ ļĴС޸ʱ
+static bool GetSourceStamp(const char* filename, uint64_t& size, int64_t& mtime)
+{
+	std::error_code ec;
+	size = (uint64_t)std::filesystem::file_size(filename, ec);
+	if (ec)
+	{
+		return false;
+	}
+
+	std::filesystem::file_time_type time = std::filesystem::last_write_time(filename, ec);
+	if (ec)
+	{
+		return false;
+	}
+
+	mtime = (int64_t)time.time_since_epoch().count();
+	return true;
+}
+
+static bool ReadHeader(const std::string& path, MeshCacheHeader& header)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in.read((char*)&header, sizeof(header)))
+	{
+		return false;
+	}
+
+	return memcmp(header.magic, MESH_CACHE_MAGIC, 4) == 0 && header.version == MESH_CACHE_VERSION && header.vertex_size == sizeof(MeshVertex);
+}
+
+// ֻдļͷʧҲûϵ´һιϣ
+static void PatchHeader(const std::string& path, const MeshCacheHeader& header)
+{
+	std::fstream out(path, std::ios::binary | std::ios::in | std::ios::out);
+	out.write((const char*)&header, sizeof(header));
+}
+
+// ļͷе LOD Χɸͼ
+static void MakeLodViews(const MeshCacheHeader& header, const MeshVertex* vertices, const uint32_t* indices, std::vector<MeshView>& lods)
+{
+	lods.resize(header.lod_count);
+	for (uint32_t i = 0; i < header.lod_count; i++)
+	{
+		const MeshLodRange& range = header.lods[i];
+		MeshView& view = lods[i];
+		view.vertices = vertices + range.first_vertex;
+		view.vertex_count = range.vertex_count;
+		view.indices = indices + range.first_index;
+		view.index_count = range.index_count;
+		view.bounds_min = header.bounds_min;
+		view.bounds_max = header.bounds_max;
+		view.error = range.error;
+	}
+}
+
+static bool MapCache(const std::string& path, const MeshCacheHeader& header, std::unique_ptr<MappedFile>& cache_file, std::vector<MeshView>& lods)
+{
+	std::unique_ptr<MappedFile> file(new MappedFile(path.c_str()));
+	if (!file->IsOpen() || file->Size() < sizeof(MeshCacheHeader))
+	{
+		return false;
+	}
+
+	// ӳ䵽ļͷ͸ղżһ£ֹм仺汻滻
+	if (memcmp(file->Data(), &header, sizeof(header)) != 0)
+	{
+		return false;
+	}
+
+	uint64_t vertex_bytes = (uint64_t)header.vertex_count * sizeof(MeshVertex);
+	uint64_t index_bytes = (uint64_t)header.index_count * sizeof(uint32_t);
+	if (header.vertex_offset % 16 != 0 || header.index_offset % 16 != 0 ||
+		header.vertex_offset + vertex_bytes > file->Size() || header.index_offset + index_bytes > file->Size() ||
+		header.index_count % 3 != 0 || header.lod_count < 1 || header.lod_count > MESH_LOD_MAX)
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header.lod_count; i++)
+	{
+		const MeshLodRange& range = header.lods[i];
+		if ((uint64_t)range.first_vertex + range.vertex_count > header.vertex_count ||
+			(uint64_t)range.first_index + range.index_count > header.index_count || range.index_count % 3 != 0)
+		{
+			return false;
+		}
+	}
+
+	MakeLodViews(header, (const MeshVertex*)(file->Data() + header.vertex_offset), (const uint32_t*)(file->Data() + header.index_offset), lods);
+
+	cache_file = std::move(file);
+	return true;
+}
+
+// ԭʼʼÿһһ򻯵һΣ׷ӵ vertices / indices ĩβ
+// 򻯵òࣨӷ̶Ķ̫࣬۵ͻᷭתʱͣ£ֵöһ
+static uint32_t BuildLods(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, MeshLodRange* lods)
+{
+	lods[0] = MeshLodRange();
+	lods[0].vertex_count = (uint32_t)vertices.size();
+	lods[0].index_count = (uint32_t)indices.size();
+
+	uint32_t lod_count = 1;
+	std::vector<MeshVertex> lod_vertices;
+	std::vector<uint32_t> lod_indices;
+	while (lod_count < MESH_LOD_MAX)
+	{
+		const MeshLodRange& prev = lods[lod_count - 1];
+		uint32_t target_triangles = prev.index_count / 3 / 2;
+		if (target_triangles < MESH_LOD_MIN_TRIANGLES)
+		{
+			break;
+		}
+
+		float error;
+		SimplifyMesh(&vertices[prev.first_vertex], prev.vertex_count, &indices[prev.first_index], prev.index_count, target_triangles * 3, lod_vertices, lod_indices, error);
+		if (lod_indices.empty() || lod_indices.size() > (size_t)prev.index_count * 3 / 4)
+		{
+			break;
+		}
+
+		MeshLodRange& lod = lods[lod_count++];
+		lod = MeshLodRange();
+		lod.first_vertex = (uint32_t)vertices.size();
+		lod.vertex_count = (uint32_t)lod_vertices.size();
+		lod.first_index = (uint32_t)indices.size();
+		lod.index_count = (uint32_t)lod_indices.size();
+		lod.error = prev.error + error;// ÿһһ򻯶ۼӹ
+
+		vertices.insert(vertices.end(), lod_vertices.begin(), lod_vertices.end());
+		indices.insert(indices.end(), lod_indices.begin(), lod_indices.end());
+	}
+
+	return lod_count;
+}
+
+// ԭʼİΧв𼶼򻯣ķΧд header 
+static void BuildMesh(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, MeshCacheHeader& header)
+{
+	if (!vertices.empty())
+	{
+		header.bounds_min = header.bounds_max = vertices[0].position;
+		for (const MeshVertex& v : vertices)
+		{
+			header.bounds_min = Vec3(std::min(header.bounds_min.x, v.position.x), std::min(header.bounds_min.y, v.position.y), std::min(header.bounds_min.z, v.position.z));
+			header.bounds_max = Vec3(std::max(header.bounds_max.x, v.position.x), std::max(header.bounds_max.y, v.position.y), std::max(header.bounds_max.z, v.position.z));
+		}
+	}
+
+	header.lod_count = BuildLods(vertices, indices, header.lods);
+}
+
+// дʱļٸͬʱɻʱдһļ
+static void WriteCache(const std::string& path, MeshCacheHeader header, const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	uint64_t vertex_bytes = (uint64_t)vertices.size() * sizeof(MeshVertex);
+	header.vertex_offset = AlignUp(sizeof(MeshCacheHeader), 16);
+	header.index_offset = AlignUp(header.vertex_offset + vertex_bytes, 16);
+
+	std::string temp_path = path + ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+	{
+		std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+		const char padding[16] = {};
+
+		out.write((const char*)&header, sizeof(header));
+		out.write(padding, header.vertex_offset - sizeof(header));
+		out.write((const char*)vertices.data(), vertex_bytes);
+		out.write(padding, header.index_offset - header.vertex_offset - vertex_bytes);
+		out.write((const char*)indices.data(), (uint64_t)indices.size() * sizeof(uint32_t));
+
+		if (!out)
+		{
+			out.close();
+			std::error_code ec;
+			std::filesystem::remove(temp_path, ec);
+			return;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(temp_path, path, ec);
+	if (ec)
+	{
+		std::filesystem::remove(temp_path, ec);
+	}
+}
+
+bool LoadMeshCached(const char* filename, std::unique_ptr<MappedFile>& cache_file, std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshView>& lods)
+{
+	cache_file.reset();
+	vertices.clear();
+	indices.clear();
+	lods.clear();
+
+	uint64_t source_size;
+	int64_t source_mtime;
+	if (!GetSourceStamp(filename, source_size, source_mtime))
+	{
+		return false;
+	}
+
+	std::string cache_path = std::string(filename) + ".rlmesh";
+
+	// С޸ʱ䶼ûֱʹû棻޸ʱٱȽݹϣ
+	MeshCacheHeader header;
+	if (ReadHeader(cache_path, header) && header.source_size == source_size)
+	{
+		bool valid = header.source_mtime == source_mtime;
+		if (!valid && header.source_hash == HashFile(filename))
+		{
+			// û䣬ֻļ¿򱣴»޸ʱ䣬´ϣ
+			header.source_mtime = source_mtime;
+			PatchHeader(cache_path, header);
+			valid = true;
+		}
+
+		if (valid && MapCache(cache_path, header, cache_file, lods))
+		{
+			return true;
+		}
+	}
+
+	if (!LoadObj(filename, vertices, indices))
+	{
+		return false;
+	}
+
+	header = MeshCacheHeader();
+	BuildMesh(vertices, indices, header);
+
+	memcpy(header.magic, MESH_CACHE_MAGIC, 4);
+	header.version = MESH_CACHE_VERSION;
+	header.vertex_size = sizeof(MeshVertex);
+	header.vertex_count = (uint32_t)vertices.size();
+	header.index_count = (uint32_t)indices.size();
+	header.source_size = source_size;
+	header.source_mtime = source_mtime;
+	header.source_hash = HashFile(filename);
+	MakeLodViews(header, vertices.data(), indices.data(), lods);
+	WriteCache(cache_path, header, vertices, indices);
+
+	return true;
+}
+
+void BuildMeshLods(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshView>& lods)
+{
+	MeshCacheHeader header = MeshCacheHeader();
+	BuildMesh(vertices, indices, header);
+	MakeLodViews(header, vertices.data(), indices.data(), lods);
+}
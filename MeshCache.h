@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "Math.h"
+#include "ObjLoader.h"
+#include "MappedFile.h"
+
+// ļİ汾ţʽ OBJ Ľб仯ʱ 1ɻԶ
+const uint32_t MESH_CACHE_VERSION = 4;
+
+// ϸڲΣLODԭʼ
+const int MESH_LOD_MAX = 5;
+
+// ÿһ LOD Ŀһһ룬Ͳټ
+const uint32_t MESH_LOD_MIN_TRIANGLES = 64;
+
+// һ LOD ڶ±еķΧ±һĵһ
+struct MeshLodRange
+{
+	uint32_t first_vertex;
+	uint32_t vertex_count;
+	uint32_t first_index;
+	uint32_t index_count;
+	float error;// ԭʼļģͿռľ룩ԭʼΪ 0
+	uint32_t reserved[3];
+};
+
+// ļͷǶ±飨С򣬰 16 ֽڶ룩
+//  LOD δͬһ±У 0 ԭʼ
+struct MeshCacheHeader
+{
+	char magic[4];// "RLMC"
+	uint32_t version;
+	uint32_t vertex_size;// sizeof(MeshVertex)ṹ岼ֱ˻ҲʧЧ
+	uint32_t vertex_count;
+	uint32_t index_count;
+	uint32_t lod_count;
+	uint64_t source_size;// ɻʱ OBJ ļĴС޸ʱݹϣ
+	int64_t source_mtime;
+	uint64_t source_hash;
+	uint64_t vertex_offset;
+	uint64_t index_offset;
+	Vec3 bounds_min, bounds_max;
+	MeshLodRange lods[MESH_LOD_MAX];
+};
+
+// ݵֻͼݿӳĻļҲڽ OBJ õ
+struct MeshView
+{
+	const MeshVertex* vertices;
+	uint32_t vertex_count;
+	const uint32_t* indices;
+	uint32_t index_count;
+	Vec3 bounds_min, bounds_max;// ģͿռİΧУ LOD ԭʼİΧ
+	float error;// ԭʼļģͿռľ룩
+
+	MeshView() : vertices(NULL), vertex_count(0), indices(NULL), index_count(0), bounds_min(), bounds_max(), error(0.0f) {}
+};
+
+// ȡ OBJ ԱߵĶƻ棨ļ ".rlmesh"
+// Чʱֻڴӳ䣬lods ֱָӳڴ棬Ҳƣ
+// 治ڡ汾Ի OBJ ޸ʱݹϣˣͽ OBJ ñ۵𼶼򻯣 vertices / indices вд
+// lods[0] ԭʼ֮ÿһԼΪһһ
+bool LoadMeshCached(const char* filename, std::unique_ptr<MappedFile>& cache_file, std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshView>& lods);
+
+// ѾڴеɵģΧв𼶼򻯣׷ vertices / indices Удļ
+void BuildMeshLods(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshView>& lods);
+
+// 64 λ FNV-1a ϣж OBJ Ƿ仯
+uint64_t HashBytes(const char* data, size_t size);
@@ -0,0 +1,387 @@
+#include <cmath>
+#include <queue>
+#include <algorithm>
+
+#include "MeshSimplify.h"
+
+// ߽ͷƽƽȨأԽ߽Խ
+const double BORDER_WEIGHT = 10.0;
+
+// ۵ηԭ߼нǵҵֵͲ۵ֹηת߱ϸļƬ
+const float MIN_NORMAL_COS = 0.25f;
+
+// Գ 4x4  Q = sum(w * p * p^T)p = (a, b, c, d) ƽ淽̣ x Ϊ x^T Q x
+struct Quadric
+{
+	double a00, a01, a02, a03;
+	double a11, a12, a13;
+	double a22, a23;
+	double a33;
+
+	Quadric() : a00(0), a01(0), a02(0), a03(0), a11(0), a12(0), a13(0), a22(0), a23(0), a33(0) {}
+
+	void AddPlane(const Vec3& n, float d, double w)
+	{
+		a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z; a03 += w * n.x * d;
+		a11 += w * n.y * n.y; a12 += w * n.y * n.z; a13 += w * n.y * d;
+		a22 += w * n.z * n.z; a23 += w * n.z * d;
+		a33 += w * d * d;
+	}
+
+	Quadric& operator+=(const Quadric& q)
+	{
+		a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+		a11 += q.a11; a12 += q.a12; a13 += q.a13;
+		a22 += q.a22; a23 += q.a23;
+		a33 += q.a33;
+		return *this;
+	}
+
+	double Evaluate(const Vec3& p) const
+	{
+		double x = p.x, y = p.y, z = p.z;
+		double e = a00 * x * x + a11 * y * y + a22 * z * z + a33
+			+ 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z + a03 * x + a13 * y + a23 * z);
+		return std::max(e, 0.0);
+	}
+};
+
+// ԭʼһƽ棨λ nnp + d = 0ڵƽ棬߿ű߽ϵĳͷƽ
+struct Plane
+{
+	Vec3 n;
+	float d;
+};
+
+// Ѷ u ڶ v ĺѡversion һ˵˵һѾʱ
+struct Collapse
+{
+	double cost;
+	uint32_t u, v;
+	uint32_t version_u, version_v;
+
+	bool operator<(const Collapse& other) const
+	{
+		return cost > other.cost;// priority_queue Ǵ󶥶ѣȽôСڶѶ
+	}
+};
+
+static Vec3 FaceNormal(const Vec3& p0, const Vec3& p1, const Vec3& p2)
+{
+	return cross(p1 - p0, p2 - p0);
+}
+
+static uint64_t EdgeKey(uint32_t a, uint32_t b)
+{
+	return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+void SimplifyMesh(const MeshVertex* vertices, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, uint32_t target_index_count,
+	std::vector<MeshVertex>& out_vertices, std::vector<uint32_t>& out_indices, float& error)
+{
+	out_vertices.clear();
+	out_indices.clear();
+	error = 0.0f;
+
+	uint32_t face_count = index_count / 3;
+	std::vector<uint32_t> faces(indices, indices + face_count * 3);
+	std::vector<bool> face_removed(face_count, false);
+
+	// λλȫͬһ鶥ǽӷ죬ȫ̶
+	std::vector<bool> locked(vertex_count, false);
+	{
+		std::vector<uint32_t> order(vertex_count);
+		for (uint32_t i = 0; i < vertex_count; i++)
+		{
+			order[i] = i;
+		}
+
+		auto less = [&](uint32_t a, uint32_t b)
+		{
+			const Vec3& pa = vertices[a].position;
+			const Vec3& pb = vertices[b].position;
+			if (pa.x != pb.x) return pa.x < pb.x;
+			if (pa.y != pb.y) return pa.y < pb.y;
+			return pa.z < pb.z;
+		};
+		std::sort(order.begin(), order.end(), less);
+
+		for (uint32_t i = 0; i < vertex_count;)
+		{
+			uint32_t j = i + 1;
+			while (j < vertex_count && !less(order[i], order[j]))
+			{
+				j++;
+			}
+			if (j - i > 1)
+			{
+				for (uint32_t k = i; k < j; k++)
+				{
+					locked[order[k]] = true;
+				}
+			}
+			i = j;
+		}
+	}
+
+	// ÿڵΣ۵ʱ u Ų v ϣɾڱʱ
+	std::vector<std::vector<uint32_t>> vertex_faces(vertex_count);
+	for (uint32_t f = 0; f < face_count; f++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			vertex_faces[faces[f * 3 + j]].push_back(f);
+		}
+	}
+
+	// ֻһʹõıǿű߽
+	std::vector<uint64_t> edges;
+	edges.reserve(face_count * 3);
+	for (uint32_t f = 0; f < face_count; f++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			edges.push_back(EdgeKey(faces[f * 3 + j], faces[f * 3 + (j + 1) % 3]));
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+
+	auto is_border = [&](uint32_t a, uint32_t b)
+	{
+		uint64_t key = EdgeKey(a, b);
+		auto range = std::equal_range(edges.begin(), edges.end(), key);
+		return range.second - range.first == 1;
+	};
+
+	// ƽ水Ȩۼӵ㣻߽ټһߡδֱƽ
+	// ͬʱÿõԭʼƽ棺ǰȨƽƽֻǵЩƽ
+	std::vector<Quadric> quadrics(vertex_count);
+	std::vector<Plane> planes;
+	std::vector<std::vector<uint32_t>> vertex_planes(vertex_count);
+	for (uint32_t f = 0; f < face_count; f++)
+	{
+		const uint32_t* face = &faces[f * 3];
+		Vec3 n = FaceNormal(vertices[face[0]].position, vertices[face[1]].position, vertices[face[2]].position);
+		float len = length(n);
+		if (len <= 0.0f)
+		{
+			continue;
+		}
+		n = n * (1.0f / len);
+		float d = -dot(n, vertices[face[0]].position);
+		uint32_t plane = (uint32_t)planes.size();
+		planes.push_back({ n, d });
+		for (int j = 0; j < 3; j++)
+		{
+			quadrics[face[j]].AddPlane(n, d, len * 0.5);
+			vertex_planes[face[j]].push_back(plane);
+		}
+
+		for (int j = 0; j < 3; j++)
+		{
+			uint32_t a = face[j], b = face[(j + 1) % 3];
+			if (!is_border(a, b))
+			{
+				continue;
+			}
+
+			Vec3 edge = vertices[b].position - vertices[a].position;
+			Vec3 bn = cross(edge, n);
+			float bn_len = length(bn);
+			if (bn_len <= 0.0f)
+			{
+				continue;
+			}
+			bn = bn * (1.0f / bn_len);
+			float bd = -dot(bn, vertices[a].position);
+			double w = BORDER_WEIGHT * dot(edge, edge);
+			quadrics[a].AddPlane(bn, bd, w);
+			quadrics[b].AddPlane(bn, bd, w);
+			uint32_t plane = (uint32_t)planes.size();
+			planes.push_back({ bn, bd });
+			vertex_planes[a].push_back(plane);
+			vertex_planes[b].push_back(plane);
+		}
+	}
+
+	std::vector<uint32_t> version(vertex_count, 0);
+	std::vector<bool> vertex_removed(vertex_count, false);
+	std::priority_queue<Collapse> heap;
+
+	auto push = [&](uint32_t u, uint32_t v)
+	{
+		if (locked[u] || u == v)
+		{
+			return;
+		}
+		Quadric q = quadrics[u];
+		q += quadrics[v];
+		Collapse c;
+		c.cost = q.Evaluate(vertices[v].position);
+		c.u = u;
+		c.v = v;
+		c.version_u = version[u];
+		c.version_v = version[v];
+		heap.push(c);
+	};
+
+	for (uint32_t f = 0; f < face_count; f++)
+	{
+		const uint32_t* face = &faces[f * 3];
+		for (int j = 0; j < 3; j++)
+		{
+			push(face[j], face[(j + 1) % 3]);
+			push(face[(j + 1) % 3], face[j]);
+		}
+	}
+
+	uint32_t live_faces = face_count;
+	float max_error = 0.0f;
+	std::vector<uint32_t> neighbors;
+
+	while (live_faces * 3 > target_index_count && !heap.empty())
+	{
+		Collapse c = heap.top();
+		heap.pop();
+
+		uint32_t u = c.u, v = c.v;
+		if (vertex_removed[u] || vertex_removed[v] || c.version_u != version[u] || c.version_v != version[v])
+		{
+			continue;
+		}
+
+		// ֮ǰ۵Ѿ uv ڣ۵µβܷת
+		bool adjacent = false;
+		bool flipped = false;
+		for (uint32_t f : vertex_faces[u])
+		{
+			if (face_removed[f])
+			{
+				continue;
+			}
+
+			const uint32_t* face = &faces[f * 3];
+			if (face[0] == v || face[1] == v || face[2] == v)
+			{
+				adjacent = true;
+				continue;
+			}
+
+			Vec3 p[3];
+			for (int j = 0; j < 3; j++)
+			{
+				p[j] = vertices[face[j]].position;
+			}
+			Vec3 before = FaceNormal(p[0], p[1], p[2]);
+			for (int j = 0; j < 3; j++)
+			{
+				if (face[j] == u)
+				{
+					p[j] = vertices[v].position;
+				}
+			}
+			Vec3 after = FaceNormal(p[0], p[1], p[2]);
+			if (dot(before, after) < MIN_NORMAL_COS * length(before) * length(after) || dot(after, after) <= 0.0f)
+			{
+				flipped = true;
+				break;
+			}
+		}
+		if (!adjacent || flipped)
+		{
+			continue;
+		}
+
+		for (uint32_t f : vertex_faces[u])
+		{
+			if (face_removed[f])
+			{
+				continue;
+			}
+
+			uint32_t* face = &faces[f * 3];
+			if (face[0] == v || face[1] == v || face[2] == v)
+			{
+				face_removed[f] = true;
+				live_faces--;
+				continue;
+			}
+
+			for (int j = 0; j < 3; j++)
+			{
+				if (face[j] == u)
+				{
+					face[j] = v;
+				}
+			}
+			vertex_faces[v].push_back(f);
+		}
+
+		quadrics[v] += quadrics[u];
+		vertex_removed[u] = true;
+		vertex_faces[u].clear();
+		version[v]++;
+
+		// v ڴ uv ԭƽ棬Զһƽľ۵ļ
+		std::vector<uint32_t>& vp = vertex_planes[v];
+		vp.insert(vp.end(), vertex_planes[u].begin(), vertex_planes[u].end());
+		std::vector<uint32_t>().swap(vertex_planes[u]);
+		std::sort(vp.begin(), vp.end());
+		vp.erase(std::unique(vp.begin(), vp.end()), vp.end());
+
+		const Vec3& position = vertices[v].position;
+		for (uint32_t plane : vp)
+		{
+			max_error = std::max(max_error, std::fabs(dot(planes[plane].n, position) + planes[plane].d));
+		}
+
+		// ȥ v ɾΣٰ v Χı·Ž
+		std::vector<uint32_t>& vf = vertex_faces[v];
+		vf.erase(std::remove_if(vf.begin(), vf.end(), [&](uint32_t f) { return (bool)face_removed[f]; }), vf.end());
+
+		neighbors.clear();
+		for (uint32_t f : vf)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				uint32_t w = faces[f * 3 + j];
+				if (w != v)
+				{
+					neighbors.push_back(w);
+				}
+			}
+		}
+		std::sort(neighbors.begin(), neighbors.end());
+		neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+		for (uint32_t w : neighbors)
+		{
+			push(v, w);
+			push(w, v);
+		}
+	}
+
+	// һαõ˳ѹ㣬ԭķʾֲ
+	std::vector<uint32_t> remap(vertex_count, UINT32_MAX);
+	out_indices.reserve(live_faces * 3);
+	out_vertices.reserve(live_faces);
+	for (uint32_t f = 0; f < face_count; f++)
+	{
+		if (face_removed[f])
+		{
+			continue;
+		}
+
+		for (int j = 0; j < 3; j++)
+		{
+			uint32_t index = faces[f * 3 + j];
+			if (remap[index] == UINT32_MAX)
+			{
+				remap[index] = (uint32_t)out_vertices.size();
+				out_vertices.push_back(vertices[index]);
+			}
+			out_indices.push_back(remap[index]);
+		}
+	}
+
+	error = max_error;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "ObjLoader.h"
+
+// öGarland-Heckbert QEMı۵ֱ±겻 target_index_count ޷۵
+// ֻ۵㲢ڵһжϣĶԲ䣬Ҫֵ
+// ͬһλж㣨ߵĽӷ죩ʱЩ̶ӷ಻ѿ
+// ŵı߽磨ҶƬıԵ߽紹ֱƽΪͷ߽Լ򻯵
+// ֻԱõĶ㣬error µĶ㵽ԭʼΧƽ棨ƽͱ߽ͷƽ棩루ģͿռ䣩
+// ȡֵǶƽֵΪʹ
+void SimplifyMesh(const MeshVertex* vertices, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, uint32_t target_index_count,
+	std::vector<MeshVertex>& out_vertices, std::vector<uint32_t>& out_indices, float& error);
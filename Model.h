@@ -1,156 +1,76 @@
 #pragma once
 #include <vector>
-#include <string>
-#include <fstream>
-#include <sstream>
+#include <cstdint>
+#include <memory>
+#include <SDL3/SDL.h>
 #include "Math.h"
-
-struct Face
-{
-	std::vector<int> v;
-	std::vector<int> vt;
-	std::vector<int> vn;
-};
+#include "ObjLoader.h"
+#include "MeshCache.h"
 
 class Model
 {
 public:
-	std::vector<Vec3> vertices;
-	std::vector<Vec2> verticesTexture;
-	std::vector<Vec3> verticesNormal;
-	std::vector<Face> faces;
-
-
+	MeshView mesh;// ȥغĶ±꣨ÿ 3 һ飩ԼΧ
+	std::vector<MeshView> lods;// ϸڲΣlods[0]  mesh ֮ͬÿһԼ
 
 	Model(const char* filename)
 	{
-		Vec3 lightDir(0, 0, -1);
-
-		std::ifstream in(filename);
-		std::string line;
-		while (std::getline(in, line))
+		if (!LoadMeshCached(filename, cache_file, vertex_storage, index_storage, lods))
 		{
-			if (line.compare(0, 2, "v ") == 0)
-			{
-				std::istringstream iss(line.substr(2));
-
-				float x, y, z;
-				if (!(iss >> x >> y >> z))
-				{
-					continue;
-				}
-
-				vertices.push_back(Vec3(x, y, z));
-			}
-			else if (line.compare(0, 3, "vt ") == 0)
-			{
-				std::istringstream iss(line.substr(3));
-
-				float x, y;
-				if (!(iss >> x >> y))
-				{
-					continue;
-				}
-
-				verticesTexture.push_back(Vec2(x, y));
-			}
-			else if (line.compare(0, 3, "vn ") == 0)
-			{
-				std::istringstream iss(line.substr(3));
-
-				float x, y, z;
-				if (!(iss >> x >> y >> z))
-				{
-					continue;
-				}
-
-				verticesNormal.push_back(Vec3(x, y, z));
-			}
-			else if(line.compare(0, 2, "f ") == 0)
-			{
-				std::istringstream iss(line.substr(2));
-				std::vector<int> v_indices;
-				std::vector<int> vt_indices;
-				std::vector<int> vn_indices;
-
-				std::string vertexStr;
-				while (iss >> vertexStr)
-				{
-					std::istringstream vss(vertexStr);
-					int v, vt, vn;
-					char slash;
-
-					vss >> v;
-
-					if (vss.peek() == '/')
-					{
-						vss >> slash;
-						if (vss.peek() != '/')
-						{
-							vss >> vt;
-							vt_indices.push_back(vt - 1);
-						}
-						if (vss.peek() == '/')
-						{
-							vss >> slash;
-							vss >> vn;
-							vn_indices.push_back(vn - 1);
-						}
-					}
-
-					v_indices.push_back(v - 1);//obj1ʼҪ0ʼ
-				}
-
-				//ȡĸͲ
-				for (int i = 1; i < (int)v_indices.size() - 1; i++)
-				{
-					Face face;
-
-					face.v.push_back(v_indices[0]);
-					face.v.push_back(v_indices[i]);
-					face.v.push_back(v_indices[i+1]);
-
-					face.vt.push_back(vt_indices[0]);
-					face.vt.push_back(vt_indices[i]);
-					face.vt.push_back(vt_indices[i + 1]);
-
-					face.vn.push_back(vn_indices[0]);
-					face.vn.push_back(vn_indices[i]);
-					face.vn.push_back(vn_indices[i + 1]);
+			SDL_Log("޷ģ %s", filename);
+		}
 
-					faces.push_back(face);
-				}
-			}
+		if (lods.empty())
+		{
+			lods.push_back(MeshView());
 		}
+		mesh = lods[0];
 	}
 
-	int nverts()
+	// ɵ񣬲 OBJ ͻļҪѾзߺ
+	Model(std::vector<MeshVertex> vertices, std::vector<uint32_t> indices) : vertex_storage(std::move(vertices)), index_storage(std::move(indices))
 	{
-		return vertices.size();
+		BuildMeshLods(vertex_storage, index_storage, lods);
+		if (lods.empty())
+		{
+			lods.push_back(MeshView());
+		}
+		mesh = lods[0];
 	}
 
-	int nfaces()
+	int LodCount() const
 	{
-		return faces.size();
+		return (int)lods.size();
 	}
 
-	Vec3 vert(int i)
+	// mesh ָ vertex_storage ӳĻ棬ܸ
+	Model(const Model&) = delete;
+	Model& operator=(const Model&) = delete;
+
+	int nverts()
 	{
-		return i < nverts() ? vertices[i] : Vec3(0, 0, 0);
+		return mesh.vertex_count;
 	}
 
-	Vec2 vertTex(int i)
+	int nfaces()
 	{
-		return i < verticesTexture.size() ? verticesTexture[i] : Vec2(0, 0);
+		return mesh.index_count / 3;
 	}
 
-	Vec3 vertNor(int i)
+	const MeshVertex& vert(int i)
 	{
-		return i < verticesNormal.size() ? verticesNormal[i] : Vec3(0, 0, 0);
+		return mesh.vertices[i];
 	}
 
-	Face face(int idx)
+	//  idx ε±
+	const uint32_t* face(int idx)
 	{
-		return faces[idx];
+		return &mesh.indices[idx * 3];
 	}
+
+private:
+	// ЧʱӳĻļڽ OBJ õ
+	std::unique_ptr<MappedFile> cache_file;
+	std::vector<MeshVertex> vertex_storage;
+	std::vector<uint32_t> index_storage;
 };
\ No newline at end of file
@@ -0,0 +1,392 @@
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include "TileScheduler.h"
+
+// ϵһ㣬±Ѿɴ 0 ʼ-1 ʾûһ
+// ԣ±ȰֿѶ㣬ϲʱټǰֿ
+struct ObjCorner
+{
+	int v, vt, vn;
+	uint8_t relative;//  0/1/2 λֱʾ v/vt/vn ±
+};
+
+// һֿĽ
+struct ObjChunk
+{
+	const char* begin;
+	const char* end;
+	std::vector<Vec3> positions;
+	std::vector<Vec2> texcoords;
+	std::vector<Vec3> normals;
+	std::vector<ObjCorner> corners;
+	std::vector<uint32_t> face_sizes;// ÿĶӦ corners һ
+};
+
+static inline bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* SkipSpaces(const char* p, const char* end)
+{
+	while (p < end && IsSpace(*p))
+	{
+		p++;
+	}
+	return p;
+}
+
+static inline bool ParseFloat(const char*& p, const char* end, float& value)
+{
+	p = SkipSpaces(p, end);
+	if (p < end && *p == '+')
+	{
+		p++;// from_chars 
+	}
+
+	std::from_chars_result result = std::from_chars(p, end, value);
+	if (result.ec != std::errc())
+	{
+		return false;
+	}
+
+	p = result.ptr;
+	return true;
+}
+
+static inline bool ParseInt(const char*& p, const char* end, int& value)
+{
+	if (p < end && *p == '+')
+	{
+		p++;
+	}
+
+	std::from_chars_result result = std::from_chars(p, end, value);
+	if (result.ec != std::errc())
+	{
+		return false;
+	}
+
+	p = result.ptr;
+	return true;
+}
+
+// obj1ʼҪ0ʼʾӵǰѶĩβ0 ʾûһ
+static inline int ResolveIndex(int index, size_t local_count, uint8_t bit, uint8_t& relative)
+{
+	if (index > 0)
+	{
+		return index - 1;
+	}
+	if (index < 0)
+	{
+		relative |= bit;
+		return (int)local_count + index;
+	}
+	return -1;
+}
+
+// һ "f v/vt/vn ..."p ָ "f" ֮
+static void ParseFace(const char* p, const char* end, ObjChunk& chunk)
+{
+	uint32_t count = 0;
+
+	while (true)
+	{
+		p = SkipSpaces(p, end);
+		if (p >= end)
+		{
+			break;
+		}
+
+		// ֧ vv/vtv//vnv/vt/vn д
+		int v = 0, vt = 0, vn = 0;
+		ParseInt(p, end, v);
+		if (p < end && *p == '/')
+		{
+			p++;
+			if (p < end && *p != '/')
+			{
+				ParseInt(p, end, vt);
+			}
+			if (p < end && *p == '/')
+			{
+				p++;
+				ParseInt(p, end, vn);
+			}
+		}
+
+		// ʣµ޷ʶַ
+		while (p < end && !IsSpace(*p))
+		{
+			p++;
+		}
+
+		ObjCorner corner;
+		corner.relative = 0;
+		corner.v = ResolveIndex(v, chunk.positions.size(), 1, corner.relative);
+		corner.vt = ResolveIndex(vt, chunk.texcoords.size(), 2, corner.relative);
+		corner.vn = ResolveIndex(vn, chunk.normals.size(), 4, corner.relative);
+		chunk.corners.push_back(corner);
+		count++;
+	}
+
+	chunk.face_sizes.push_back(count);
+}
+
+static void ParseChunk(ObjChunk& chunk)
+{
+	const char* p = chunk.begin;
+	while (p < chunk.end)
+	{
+		const char* line_end = (const char*)memchr(p, '\n', chunk.end - p);
+		if (line_end == NULL)
+		{
+			line_end = chunk.end;
+		}
+
+		// ؼֺհף"vt""vn" ܱ "v"
+		if (line_end - p >= 2 && p[0] == 'v' && IsSpace(p[1]))
+		{
+			const char* q = p + 2;
+			Vec3 v;
+			if (ParseFloat(q, line_end, v.x) && ParseFloat(q, line_end, v.y) && ParseFloat(q, line_end, v.z))
+			{
+				chunk.positions.push_back(v);
+			}
+		}
+		else if (line_end - p >= 3 && p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+		{
+			const char* q = p + 3;
+			Vec2 t;
+			if (ParseFloat(q, line_end, t.x) && ParseFloat(q, line_end, t.y))
+			{
+				chunk.texcoords.push_back(t);
+			}
+		}
+		else if (line_end - p >= 3 && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+		{
+			const char* q = p + 3;
+			Vec3 n;
+			if (ParseFloat(q, line_end, n.x) && ParseFloat(q, line_end, n.y) && ParseFloat(q, line_end, n.z))
+			{
+				chunk.normals.push_back(n);
+			}
+		}
+		else if (line_end - p >= 2 && p[0] == 'f' && IsSpace(p[1]))
+		{
+			ParseFace(p + 2, line_end, chunk);
+		}
+
+		p = line_end + 1;
+	}
+}
+
+bool LoadObj(const char* filename, std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices)
+{
+	vertices.clear();
+	indices.clear();
+
+	MappedFile file(filename);
+	if (!file.IsOpen())
+	{
+		return false;
+	}
+
+	const char* data = file.Data();
+	const char* data_end = data + file.Size();
+
+	// Сп飬ÿŲһеĿͷ֤ÿһһ
+	std::vector<ObjChunk> chunks;
+	const char* p = data;
+	while (p < data_end)
+	{
+		ObjChunk chunk;
+		chunk.begin = p;
+		chunk.end = data_end;
+		if ((size_t)(data_end - p) > OBJ_CHUNK_SIZE)
+		{
+			const char* line_end = (const char*)memchr(p + OBJ_CHUNK_SIZE, '\n', data_end - (p + OBJ_CHUNK_SIZE));
+			if (line_end != NULL)
+			{
+				chunk.end = line_end + 1;
+			}
+		}
+
+		p = chunk.end;
+		chunks.push_back(std::move(chunk));
+	}
+
+	TileScheduler& scheduler = TileScheduler::Instance();
+	scheduler.Run((int)chunks.size(), [&](int c, int)
+	{
+		ParseChunk(chunks[c]);
+	});
+
+	// ϲԣͬʱÿֿ֮ǰе±
+	std::vector<Vec3> positions;
+	std::vector<Vec2> texcoords;
+	std::vector<Vec3> normals;
+	std::vector<int> position_base(chunks.size()), texcoord_base(chunks.size()), normal_base(chunks.size());
+	size_t corner_count = 0;
+	for (size_t c = 0; c < chunks.size(); c++)
+	{
+		position_base[c] = (int)positions.size();
+		texcoord_base[c] = (int)texcoords.size();
+		normal_base[c] = (int)normals.size();
+
+		positions.insert(positions.end(), chunks[c].positions.begin(), chunks[c].positions.end());
+		texcoords.insert(texcoords.end(), chunks[c].texcoords.begin(), chunks[c].texcoords.end());
+		normals.insert(normals.end(), chunks[c].normals.begin(), chunks[c].normals.end());
+		corner_count += chunks[c].corners.size();
+	}
+
+	scheduler.Run((int)chunks.size(), [&](int c, int)
+	{
+		for (ObjCorner& corner : chunks[c].corners)
+		{
+			if (corner.relative & 1) corner.v += position_base[c];
+			if (corner.relative & 2) corner.vt += texcoord_base[c];
+			if (corner.relative & 4) corner.vn += normal_base[c];
+		}
+	});
+
+	// ļ˳ȥأͬ v/vt/vn ֻһγֵĶ
+	// λ±ͰͬһλϵĶֻͨм˳ȽϼɣҪϣ
+	const uint32_t NONE = UINT32_MAX;
+	std::vector<uint32_t> bucket_head(positions.size() + 1, NONE);// һͰԽλ±
+	std::vector<uint32_t> bucket_next;
+	std::vector<ObjCorner> keys;
+	std::vector<uint32_t> face;
+	indices.reserve(corner_count * 3 / 2);
+
+	for (const ObjChunk& chunk : chunks)
+	{
+		size_t k = 0;
+		for (uint32_t face_size : chunk.face_sizes)
+		{
+			face.clear();
+			for (uint32_t i = 0; i < face_size; i++, k++)
+			{
+				const ObjCorner& corner = chunk.corners[k];
+				size_t bucket = (size_t)corner.v < positions.size() ? corner.v : positions.size();
+
+				uint32_t id = bucket_head[bucket];
+				while (id != NONE && !(keys[id].v == corner.v && keys[id].vt == corner.vt && keys[id].vn == corner.vn))
+				{
+					id = bucket_next[id];
+				}
+
+				if (id == NONE)
+				{
+					id = (uint32_t)keys.size();
+					keys.push_back(corner);
+					bucket_next.push_back(bucket_head[bucket]);
+					bucket_head[bucket] = id;
+				}
+				face.push_back(id);
+			}
+
+			//ȡĸͲ
+			for (int i = 1; i < (int)face.size() - 1; i++)
+			{
+				indices.push_back(face[0]);
+				indices.push_back(face[i]);
+				indices.push_back(face[i + 1]);
+			}
+		}
+	}
+
+	// Խ±굱ԭ㡢ꡢ㷨
+	vertices.resize(keys.size());
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		const ObjCorner& key = keys[i];
+		vertices[i].position = (size_t)key.v < positions.size() ? positions[key.v] : Vec3(0, 0, 0);
+		vertices[i].texcoord = (size_t)key.vt < texcoords.size() ? texcoords[key.vt] : Vec2(0, 0);
+		vertices[i].normal = (size_t)key.vn < normals.size() ? normals[key.vn] : Vec3(0, 0, 0);
+	}
+
+	ComputeTangents(vertices, indices);
+	return true;
+}
+
+// ߵļнǣۼʱȨ
+static float CornerAngle(const Vec3& e1, const Vec3& e2)
+{
+	float len = length(e1) * length(e2);
+	if (len <= 0.0f)
+	{
+		return 0.0f;
+	}
+	return std::acos(std::clamp(dot(e1, e2) / len, -1.0f, 1.0f));
+}
+
+//  n ֱһλ
+static Vec3 AnyPerpendicular(const Vec3& n)
+{
+	Vec3 axis = std::fabs(n.x) < 0.9f ? Vec3(1, 0, 0) : Vec3(0, 1, 0);
+	return normalize(cross(n, axis));
+}
+
+void ComputeTangents(std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	std::vector<Vec3> tangents(vertices.size());
+	std::vector<Vec3> bitangents(vertices.size());
+
+	for (size_t f = 0; f + 2 < indices.size(); f += 3)
+	{
+		const uint32_t* face = &indices[f];
+		if (face[0] >= vertices.size() || face[1] >= vertices.size() || face[2] >= vertices.size())
+		{
+			continue;
+		}
+
+		const MeshVertex& a = vertices[face[0]];
+		const MeshVertex& b = vertices[face[1]];
+		const MeshVertex& c = vertices[face[2]];
+
+		// P - A = (u - uA) * dP/du + (v - vA) * dP/dv߽ dP/duߣ dP/dvߣ
+		Vec3 e1 = b.position - a.position;
+		Vec3 e2 = c.position - a.position;
+		float du1 = b.texcoord.x - a.texcoord.x, dv1 = b.texcoord.y - a.texcoord.y;
+		float du2 = c.texcoord.x - a.texcoord.x, dv2 = c.texcoord.y - a.texcoord.y;
+		float det = du1 * dv2 - du2 * dv1;
+		if (std::fabs(det) < 1e-12f)
+		{
+			continue;// ˻βṩ߷
+		}
+
+		float r = 1.0f / det;
+		Vec3 t = normalize((e1 * dv2 - e2 * dv1) * r);
+		Vec3 s = normalize((e2 * du1 - e1 * du2) * r);
+
+		// ÿ㴦ڽǼȨεʷַʽ޹
+		float angles[3] = { CornerAngle(e1, e2), CornerAngle(c.position - b.position, a.position - b.position), CornerAngle(a.position - c.position, b.position - c.position) };
+		for (int k = 0; k < 3; k++)
+		{
+			tangents[face[k]] += t * angles[k];
+			bitangents[face[k]] += s * angles[k];
+		}
+	}
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		MeshVertex& v = vertices[i];
+		Vec3 n = normalize(v.normal);
+
+		// ȥطߵķûпõʱȡһ뷨ߴֱķ
+		Vec3 t = normalize(tangents[i] - n * dot(n, tangents[i]));
+		if (dot(t, t) == 0.0f)
+		{
+			t = dot(n, n) > 0.0f ? AnyPerpendicular(n) : Vec3(1, 0, 0);
+		}
+
+		float w = dot(cross(n, t), bitangents[i]) < 0.0f ? -1.0f : 1.0f;
+		v.tangent = Vec4(t.x, t.y, t.z, w);
+	}
+}
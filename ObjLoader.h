@@ -0,0 +1,24 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Math.h"
+
+// ȥغĶ㣺λáꡢߺߴһͨ±
+struct MeshVertex
+{
+	Vec3 position;
+	Vec2 texcoord;
+	Vec3 normal;
+	Vec4 tangent;// xyz 뷨ĵλߣu ķ򣩣w Ǹߵķ򣺸 = cross(normal, tangent) * w
+};
+
+// ÿнֽֿ߽ŲһеĿͷ
+const size_t OBJ_CHUNK_SIZE = 1 << 20;
+
+// ȡ OBJ ļ v/vt/vn ȥغĶ±꣨ΰβΣ
+// ļͨڴӳȡгɿ̳߳ϲнԭ˳ϲнȫһ
+bool LoadObj(const char* filename, std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices);
+
+// ÿߣLoadObj ã
+//  MikkTSpace ͬÿε dP/dudP/dv 㴦ĽǶȼȨۼӣٶԶ㷨 Gram-Schmidt 
+void ComputeTangents(std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices);
@@ -0,0 +1,141 @@
+#include "Profiler.h"
+
+#if RENDERER_PROFILE
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// ÿ߳Լ¼бֻ߳д룬Ҫ
+struct ProfileThread
+{
+	int id;
+	std::vector<ProfileEvent> events;
+};
+
+// һ֡ı߽ͼ
+struct ProfileFrameRecord
+{
+	int64_t time;
+	RenderStats stats;
+};
+
+static const std::chrono::steady_clock::time_point profile_start = std::chrono::steady_clock::now();
+
+// ̵߳¼б̵߳һμʱʱע᣻߳˳бʱܿ¼
+static std::mutex profile_mutex;
+static std::vector<std::unique_ptr<ProfileThread>> profile_threads;
+static std::vector<ProfileFrameRecord> profile_frames;
+
+static thread_local ProfileThread* current_thread = nullptr;
+
+int64_t ProfileNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profile_start).count();
+}
+
+static ProfileThread* RegisterThread()
+{
+	std::lock_guard<std::mutex> lock(profile_mutex);
+	profile_threads.push_back(std::make_unique<ProfileThread>());
+	ProfileThread* thread = profile_threads.back().get();
+	thread->id = (int)profile_threads.size() - 1;
+	thread->events.reserve(4096);
+	return thread;
+}
+
+void ProfileRecord(const char* name, int64_t begin, int64_t end)
+{
+	if (current_thread == nullptr)
+	{
+		current_thread = RegisterThread();
+	}
+
+	if (current_thread->events.size() < PROFILE_MAX_EVENTS)
+	{
+		current_thread->events.push_back({ name, begin, end });
+	}
+}
+
+void ProfileFrame(const RenderStats& stats)
+{
+	std::lock_guard<std::mutex> lock(profile_mutex);
+	if (profile_frames.size() < PROFILE_MAX_EVENTS)
+	{
+		profile_frames.push_back({ ProfileNow(), stats });
+	}
+}
+
+// ʱ߳Ӧڿ״̬ Render ֮䣩ʱǲд¼б
+bool WriteChromeTrace(const char* filename)
+{
+	std::ofstream out(filename);
+	if (!out)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(profile_mutex);
+
+	// Chrome trace ʱ䵥λ΢
+	out.setf(std::ios::fixed);
+	out.precision(3);
+	out << "{\"traceEvents\":[" << std::endl;
+
+	bool first = true;
+	auto separator = [&]()
+	{
+		if (!first)
+		{
+			out << "," << std::endl;
+		}
+		first = false;
+	};
+
+	for (const auto& thread : profile_threads)
+	{
+		separator();
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread->id << ",\"args\":{\"name\":\"Thread " << thread->id << "\"}}";
+
+		for (const ProfileEvent& e : thread->events)
+		{
+			separator();
+			out << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread->id
+				<< ",\"ts\":" << e.begin / 1000.0 << ",\"dur\":" << (e.end - e.begin) / 1000.0 << "}";
+		}
+	}
+
+	// ֡Chrome trace ʾΪʱ仯
+	for (size_t i = 0; i < profile_frames.size(); i++)
+	{
+		const ProfileFrameRecord& f = profile_frames[i];
+		double ts = f.time / 1000.0;
+
+		separator();
+		out << "{\"name\":\"Frame " << i << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":" << ts << "}";
+
+		separator();
+		out << "{\"name\":\"Triangles\",\"ph\":\"C\",\"pid\":0,\"ts\":" << ts << ",\"args\":{"
+			<< "\"submitted\":" << f.stats.triangles_submitted
+			<< ",\"lod_skipped\":" << f.stats.triangles_lod_skipped
+			<< ",\"frustum_culled\":" << f.stats.triangles_frustum_culled
+			<< ",\"guard_clipped\":" << f.stats.triangles_guard_clipped
+			<< ",\"backface_culled\":" << f.stats.triangles_backface_culled
+			<< ",\"clipped_one\":" << f.stats.triangles_clipped_one
+			<< ",\"clipped_two\":" << f.stats.triangles_clipped_two
+			<< ",\"occluded\":" << f.stats.triangles_occluded << "}}";
+
+		separator();
+		out << "{\"name\":\"Pixels\",\"ph\":\"C\",\"pid\":0,\"ts\":" << ts << ",\"args\":{"
+			<< "\"tested\":" << f.stats.pixels_tested
+			<< ",\"depth_passed\":" << f.stats.pixels_depth_passed
+			<< ",\"shaded\":" << f.stats.pixels_shaded << "}}";
+	}
+
+	out << std::endl << "]}" << std::endl;
+	return (bool)out;
+}
+
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include "RenderData.h"
+
+// Ⱦߵķֽ׶μʱؼʱأ RENDERER_PROFILE=1 Ż¼
+// رʱ PROFILE_SCOPE չΪգPROFILE_COUNT ֵProfileFrame Ⱥǿյκδ
+#ifndef RENDERER_PROFILE
+#define RENDERER_PROFILE 0
+#endif
+
+// ÿ߳ౣļʱ¼µ¼ⳤʱʱڴ
+const size_t PROFILE_MAX_EVENTS = 1 << 20;
+
+#if RENDERER_PROFILE
+
+// һμʱʱԳ
+struct ProfileEvent
+{
+	const char* name;// ָֻ룬ַ
+	int64_t begin;
+	int64_t end;
+};
+
+int64_t ProfileNow();
+void ProfileRecord(const char* name, int64_t begin, int64_t end);
+
+// ʱʱ¿ʼʱ䣬ʱһдǰ̵߳¼б
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name) : name(name), begin(ProfileNow()) {}
+	~ProfileScope() { ProfileRecord(name, begin, ProfileNow()); }
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* name;
+	int64_t begin;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+
+// դɫڲѭļRenderStats ءؿͳƣÿλƵļֱۼӣ
+#define PROFILE_COUNT(counter, n) ((counter) += (n))
+
+// һ֡ʱã¼߽֡һ֡ܺļCollectRenderStats Ľ
+void ProfileFrame(const RenderStats& stats);
+
+// Ѽ¼мʱͼд Chrome trace JSONchrome://tracing  Perfetto Դ򿪣
+bool WriteChromeTrace(const char* filename);
+
+#else
+
+#define PROFILE_SCOPE(name)
+
+// sizeof ıʽֵֻòеıʹ
+#define PROFILE_COUNT(counter, n) ((void)sizeof((counter) += (n)))
+
+inline void ProfileFrame(const RenderStats&) {}
+inline bool WriteChromeTrace(const char*) { return false; }
+
+#endif
@@ -0,0 +1,715 @@
+using namespace std;
+
+#include <array>
+#include <utility>
+
+#include "RasterSIMD.h"
+#include "Renderer.h"
+#include "FastMath.h"
+#include "Profiler.h"
+
+#if RENDERER_HAS_SSE41
+
+bool CpuSupportsSSE41()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 19)) != 0;
+#else
+	return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+// 4 صάֿţÿռһ SSE Ĵ
+struct Vec3x4
+{
+	__m128 x, y, z;
+};
+
+static inline SSE41_TARGET Vec3x4 Broadcast(const Vec3& v)
+{
+	return { _mm_set1_ps(v.x), _mm_set1_ps(v.y), _mm_set1_ps(v.z) };
+}
+
+static inline SSE41_TARGET Vec3x4 Add(const Vec3x4& a, const Vec3x4& b)
+{
+	return { _mm_add_ps(a.x, b.x), _mm_add_ps(a.y, b.y), _mm_add_ps(a.z, b.z) };
+}
+
+static inline SSE41_TARGET Vec3x4 Sub(const Vec3x4& a, const Vec3x4& b)
+{
+	return { _mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z) };
+}
+
+static inline SSE41_TARGET Vec3x4 Scale(const Vec3x4& v, __m128 s)
+{
+	return { _mm_mul_ps(v.x, s), _mm_mul_ps(v.y, s), _mm_mul_ps(v.z, s) };
+}
+
+static inline SSE41_TARGET __m128 Dot(const Vec3x4& a, const Vec3x4& b)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+}
+
+//  normalize ͬȽӽ 0 ʱ
+static inline SSE41_TARGET Vec3x4 Normalize(const Vec3x4& v)
+{
+	__m128 len = _mm_sqrt_ps(Dot(v, v));
+	__m128 valid = _mm_cmpgt_ps(len, _mm_set1_ps(1e-6f));
+	__m128 inv_len = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), len), valid);
+	return Scale(v, inv_len);
+}
+
+//  FastRsqrt4 濪ͳȵ < 1e-6
+static inline SSE41_TARGET Vec3x4 FastNormalize(const Vec3x4& v)
+{
+	__m128 len2 = Dot(v, v);
+	__m128 valid = _mm_cmpgt_ps(len2, _mm_set1_ps(1e-12f));
+	return Scale(v, _mm_and_ps(FastRsqrt4(len2), valid));
+}
+
+// ѡĹһ͸߹ݺ normalize(v, accuracy)SpecularPow Ӧ
+static inline SSE41_TARGET Vec3x4 Normalize(const Vec3x4& v, MathAccuracy accuracy)
+{
+	return accuracy == MathFast ? FastNormalize(v) : Normalize(v);
+}
+
+static inline SSE41_TARGET __m128 SpecularPow4(__m128 x, float p, MathAccuracy accuracy)
+{
+	return accuracy == MathFast ? FastPow4(x, p) : Pow4(x, p);
+}
+
+// Բֵ
+static inline SSE41_TARGET __m128 Interpolate(__m128 b0, __m128 b1, __m128 b2, float a0, float a1, float a2)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a0), b0), _mm_mul_ps(_mm_set1_ps(a1), b1)), _mm_mul_ps(_mm_set1_ps(a2), b2));
+}
+
+//  TextureLod ͬ uv ĵ lod
+static inline SSE41_TARGET __m128 TextureLod4(__m128 du_dx, __m128 dv_dx, __m128 du_dy, __m128 dv_dy)
+{
+	__m128 footprint_x = _mm_add_ps(_mm_mul_ps(du_dx, du_dx), _mm_mul_ps(dv_dx, dv_dx));
+	__m128 footprint_y = _mm_add_ps(_mm_mul_ps(du_dy, du_dy), _mm_mul_ps(dv_dy, dv_dy));
+
+	//  NaN ʱ _mm_max_ps صڶ
+	__m128 footprint = _mm_max_ps(_mm_max_ps(footprint_x, footprint_y), _mm_set1_ps(1e-20f));
+
+	// 0.5 * log2(x) = ln(x) * 0.5 / ln2
+	return _mm_mul_ps(Log4(footprint), _mm_set1_ps(0.72134752044448170f));
+}
+
+// 4 ظڵĹԴأ mask еҪĹԴ֮
+static SSE41_TARGET int QuadClusters(const LightClusters& clusters, int x, int y, const Vec3x4& world_pos, int mask, int lane_clusters[4])
+{
+	float px[4], py[4], pz[4];
+	_mm_storeu_ps(px, world_pos.x);
+	_mm_storeu_ps(py, world_pos.y);
+	_mm_storeu_ps(pz, world_pos.z);
+
+	int light_count = 0;
+	for (int k = 0; k < 4; k++)
+	{
+		lane_clusters[k] = -1;
+		if (mask & (1 << k))
+		{
+			lane_clusters[k] = clusters.Cluster(x + k, y, Vec3(px[k], py[k], pz[k]));
+			light_count += clusters.LightCount(lane_clusters[k]);
+		}
+	}
+	return light_count;
+}
+
+//  mask ĵ 4 λչ 4 ͨȫ 1 / ȫ 0
+static inline SSE41_TARGET __m128 LaneMask(int mask)
+{
+	const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(mask), bits), bits));
+}
+
+// mask ÿرӰͼĹԴյıѯͼô棬ؽУΪ 0
+static SSE41_TARGET __m128 QuadShadow(const ShadowMap& map, const Vec3x4& world_pos, const Vec3x4& N, int mask)
+{
+	float px[4], py[4], pz[4], nx[4], ny[4], nz[4];
+	_mm_storeu_ps(px, world_pos.x);
+	_mm_storeu_ps(py, world_pos.y);
+	_mm_storeu_ps(pz, world_pos.z);
+	_mm_storeu_ps(nx, N.x);
+	_mm_storeu_ps(ny, N.y);
+	_mm_storeu_ps(nz, N.z);
+
+	float visibility[4] = {};
+	for (int k = 0; k < 4; k++)
+	{
+		if (mask & (1 << k))
+		{
+			visibility[k] = ShadowVisibility(map, Vec3(px[k], py[k], pz[k]), Vec3(nx[k], ny[k], nz[k]));
+		}
+	}
+	return _mm_loadu_ps(visibility);
+}
+
+//  mask еͼ Blinn-Phong գ 4  ARGB 
+// TB ǲֵߺ͸ߣֻзͼʱʹãlane_clusters ÿڵĹԴأshadows Ϊ NULL ʱӰ
+// FEATURES ɫϣShaderFeature ShadePixel ͬ
+template <int FEATURES>
+static SSE41_TARGET __m128i ShadeQuad(const SurfaceMaterial& surface, const Vec3x4& world_pos, __m128 true_u, __m128 true_v, __m128 lod, const Vec3x4& N, const Vec3x4& T, const Vec3x4& B, int mask, const Vec3x4& cam_pos,
+	const std::vector<Light>& lights, const ShadowMap* shadows, const LightClusters& clusters, const int lane_clusters[4])
+{
+	const Material& material = surface.material;
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 ambient = _mm_set1_ps(material.ambient);
+	const float spec_power = material.shininess * 4.0f;
+	const __m128 F0 = _mm_set1_ps(0.04f);
+
+	// ػʱʱѯȵ
+	bool fast_math = FEATURES == SHADER_DYNAMIC ? IsFastMathEnabled() : (FEATURES & FeatureFastMath) != 0;
+	MathAccuracy accuracy = fast_math ? MathFast : MathExact;
+
+	// ô棬ؽ
+	float us[4], vs[4], lods[4];
+	_mm_storeu_ps(us, true_u);
+	_mm_storeu_ps(vs, true_v);
+	_mm_storeu_ps(lods, lod);
+
+	bool has_diffuse_map = ShaderHas<FEATURES>(FeatureDiffuseMap, surface.texture != NULL);
+	bool has_normal_map = ShaderHas<FEATURES>(FeatureNormalMap, surface.normal_map != NULL);
+	float tex_r[4] = {}, tex_g[4] = {}, tex_b[4] = {};
+	float nor_x[4] = {}, nor_y[4] = {}, nor_z[4] = {};
+	for (int k = 0; k < 4; k++)
+	{
+		if (!(mask & (1 << k)))
+		{
+			continue;
+		}
+
+		// ûͼʱ̸
+		Vec3 c = has_diffuse_map ? surface.texture->Sample(us[k], vs[k], lods[k], surface.filter) : SampleDiffuse(NULL, us[k], vs[k], lods[k], surface.filter);
+		tex_r[k] = c.x;
+		tex_g[k] = c.y;
+		tex_b[k] = c.z;
+
+		if (has_normal_map)
+		{
+			Vec3 n = surface.normal_map->Sample(us[k], vs[k], lods[k], surface.filter);
+			nor_x[k] = n.x;
+			nor_y[k] = n.y;
+			nor_z[k] = n.z;
+		}
+	}
+	Vec3x4 texColor = { _mm_loadu_ps(tex_r), _mm_loadu_ps(tex_g), _mm_loadu_ps(tex_b) };
+
+	// ߿ռķ߳ TBN 任ռ
+	Vec3x4 normal = N;
+	if (has_normal_map)
+	{
+		__m128 two = _mm_set1_ps(2.0f);
+		__m128 tx = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(nor_x), two), one);
+		__m128 ty = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(nor_y), two), one);
+		__m128 tz = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(nor_z), two), one);
+
+		normal = Normalize(Add(Add(Scale(T, tx), Scale(B, ty)), Scale(N, tz)), accuracy);
+	}
+
+	Vec3x4 total_diffuse = { zero, zero, zero };
+	Vec3x4 total_specular = { zero, zero, zero };
+
+	// ߹ϵΪ 0 Ĳʲ߷򡢷͸߹
+	bool specular = ShaderHas<FEATURES>(FeatureSpecular, true);
+	Vec3x4 V = { zero, zero, zero };
+	__m128 fresnel = zero;
+	if (specular)
+	{
+		V = Normalize(Sub(cam_pos, world_pos), accuracy);
+
+		// ƣ(1 - cosTheta)^5 ֱó˷־ͬ
+		__m128 cosTheta = _mm_min_ps(_mm_max_ps(Dot(V, N), zero), one);
+		__m128 t = _mm_sub_ps(one, cosTheta);
+		__m128 t2 = _mm_mul_ps(t, t);
+		fresnel = _mm_add_ps(F0, _mm_mul_ps(_mm_sub_ps(one, F0), _mm_mul_ps(_mm_mul_ps(t2, t2), t)));
+	}
+
+	// ڵ 4 ͨͬһصı߽ʱط飬ÿֻԼĹԴۼӵڵ
+	// ûйԴȥ
+	int pending = ShaderHas<FEATURES>(FeatureDirectional | FeaturePoint, true) ? mask : 0;
+	while (pending != 0)
+	{
+		int cluster = -1;
+		int group = 0;
+		for (int k = 0; k < 4; k++)
+		{
+			if (!(pending & (1 << k)))
+			{
+				continue;
+			}
+			if (cluster < 0)
+			{
+				cluster = lane_clusters[k];
+			}
+			if (lane_clusters[k] == cluster)
+			{
+				group |= 1 << k;
+			}
+		}
+		pending &= ~group;
+
+		bool partial = group != mask;
+		__m128 group_mask = LaneMask(group);
+		const uint32_t* light_indices = clusters.Lights(cluster);
+		int light_count = clusters.LightCount(cluster);
+
+		for (int i = 0; i < light_count; i++)
+		{
+			const Light& light = lights[light_indices[i]];
+			const ShadowMap* shadow = ShaderHas<FEATURES>(FeatureShadows, shadows != NULL) && shadows[light_indices[i]].faces > 0 ? &shadows[light_indices[i]] : NULL;
+			Vec3x4 color = Broadcast(light.color);
+			__m128 intensity = _mm_set1_ps(light.intensity);
+
+			if (ShaderIsDirectional<FEATURES>(light))
+			{
+				if (partial)
+				{
+					intensity = _mm_and_ps(intensity, group_mask);
+				}
+				if (shadow != NULL)
+				{
+					intensity = _mm_mul_ps(intensity, QuadShadow(*shadow, world_pos, N, group));
+				}
+
+				// 
+				__m128 diff = _mm_max_ps(Dot(normal, Broadcast(light.dir_inv)), zero);
+				total_diffuse = Add(total_diffuse, Scale(color, _mm_mul_ps(_mm_mul_ps(diff, intensity), _mm_set1_ps(material.diffuse))));
+
+				// ߹
+				if (specular)
+				{
+					Vec3x4 H = Normalize(Add(Broadcast(light.dir_inv), V), accuracy);
+					__m128 spec = SpecularPow4(_mm_max_ps(Dot(normal, H), zero), spec_power, accuracy);
+					total_specular = Add(total_specular, Scale(color, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(spec, intensity), _mm_set1_ps(material.specular)), fresnel)));
+				}
+			}
+			else
+			{
+				// Դصλùϵ4 ضð뾶ʱԴ
+				Vec3x4 light_vector = Sub(Broadcast(light.position), world_pos);
+				__m128 distance2 = Dot(light_vector, light_vector);
+				__m128 in_range = _mm_cmple_ps(distance2, _mm_set1_ps(light.range * light.range));
+				if (partial)
+				{
+					in_range = _mm_and_ps(in_range, group_mask);
+				}
+				if ((_mm_movemask_ps(in_range) & group) == 0)
+				{
+					continue;
+				}
+
+				// ٽʱͷһ FastRsqrt4
+				__m128 distance;
+				Vec3x4 L;
+				if (accuracy == MathFast)
+				{
+					__m128 inv_distance = _mm_and_ps(FastRsqrt4(distance2), _mm_cmpgt_ps(distance2, _mm_set1_ps(1e-12f)));
+					distance = _mm_mul_ps(distance2, inv_distance);
+					L = Scale(light_vector, inv_distance);
+				}
+				else
+				{
+					distance = _mm_sqrt_ps(distance2);
+					L = Normalize(light_vector);
+				}
+
+				// ֻѯ÷Χڵ
+				if (shadow != NULL)
+				{
+					intensity = _mm_mul_ps(intensity, QuadShadow(*shadow, world_pos, N, _mm_movemask_ps(in_range) & group));
+				}
+
+				// ˥ϵð뾶Ϊ 0
+				__m128 falloff = _mm_add_ps(_mm_add_ps(_mm_set1_ps(light.Kc), _mm_mul_ps(_mm_set1_ps(light.Kl), distance)), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(light.Kq), distance), distance));
+				__m128 attenuation = _mm_and_ps(_mm_div_ps(one, falloff), in_range);
+
+				// 
+				__m128 diff = _mm_max_ps(Dot(normal, L), zero);
+				total_diffuse = Add(total_diffuse, Scale(color, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(diff, intensity), _mm_set1_ps(material.diffuse)), attenuation)));
+
+				// ߹
+				if (specular)
+				{
+					Vec3x4 H = Normalize(Add(L, V), accuracy);
+					__m128 spec = SpecularPow4(_mm_max_ps(Dot(normal, H), zero), spec_power, accuracy);
+					__m128 k = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(spec, intensity), _mm_set1_ps(material.specular)), attenuation), fresnel);
+					total_specular = Add(total_specular, Scale(color, k));
+				}
+			}
+		}
+	}
+
+	// ɫ = ɫ *  + ⣩ + ߹
+	Vec3x4 lit = { _mm_add_ps(ambient, total_diffuse.x), _mm_add_ps(ambient, total_diffuse.y), _mm_add_ps(ambient, total_diffuse.z) };
+	Vec3x4 final_color = Add(Vec3x4{ _mm_mul_ps(texColor.x, lit.x), _mm_mul_ps(texColor.y, lit.y), _mm_mul_ps(texColor.z, lit.z) }, total_specular);
+
+	//  Vec3ToUint32 ͬǯƵ [0, 1] 255 ض
+	__m128 scale = _mm_set1_ps(255.0f);
+	__m128i r = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(final_color.x, zero), one), scale));
+	__m128i g = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(final_color.y, zero), one), scale));
+	__m128i b = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(final_color.z, zero), one), scale));
+	return _mm_or_si128(_mm_or_si128(_mm_set1_epi32((int)0xff000000), _mm_slli_epi32(r, 16)), _mm_or_si128(_mm_slli_epi32(g, 8), b));
+}
+
+// mask бѡеظ POPCNT ָ
+static inline int BitCount(int mask)
+{
+	static const int counts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+	return counts[mask & 15];
+}
+
+// ֻд mask е
+static inline SSE41_TARGET void StorePixels(Uint32* dst, __m128i argb, int mask)
+{
+	Uint32 pixels[4];
+	_mm_storeu_si128((__m128i*)pixels, argb);
+	for (int k = 0; k < 4; k++)
+	{
+		if (mask & (1 << k))
+		{
+			dst[k] = pixels[k];
+		}
+	}
+}
+
+// ÿɫ FEATURES ʵһݣ SelectRasterizeBlockSSE41 ѡ
+template <int FEATURES>
+static SSE41_TARGET int RasterizeBlockSSE41(const Triangle& tri, const float* varyings, const TriangleSetup& setup, const Tile& block, bool full, const DrawContext& ctx, RenderStats& stats)
+{
+	int x_min = block.x0, x_max = block.x1;
+	int y_min = block.y0, y_max = block.y1;
+	int width = ctx.width;
+	float* z_buffer = ctx.z_buffer;
+	int written = 0;
+
+	const EdgeEquation& e0 = setup.edge[0];
+	const EdgeEquation& e1 = setup.edge[1];
+	const EdgeEquation& e2 = setup.edge[2];
+
+	const __m128 inv_area = _mm_set1_ps(setup.inv_area);
+
+	// ͸ӽõ /wÿֻһΣ SoA еģÿ
+	const float* inv_w_v = tri.inv_w;
+	float attr_w[VaryingNormalX][3];// 
+	for (int a = VaryingU; a < VaryingNormalX; a++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			attr_w[a][k] = varyings[a * 3 + k] * inv_w_v[k];
+		}
+	}
+	const float* u_w = attr_w[VaryingU];
+	const float* v_w = attr_w[VaryingV];
+	const float* normal = varyings + VaryingNormalX * 3;
+
+	const Vec3x4 cam_pos = Broadcast(ctx.camera->position);
+
+	// ûͼʱҪ lodûзͼʱҪ
+	bool has_texture = ShaderHas<FEATURES>(FeatureDiffuseMap | FeatureNormalMap, ctx.surface.SampleCount() > 0);
+	bool has_normal_map = ShaderHas<FEATURES>(FeatureNormalMap, ctx.surface.normal_map != NULL);
+	bool write_gbuffer = ShaderHas<FEATURES>(FeatureGBuffer, ctx.gbuffer != NULL);
+
+	int64_t row0 = e0.Evaluate(x_min, y_min);
+	int64_t row1 = e1.Evaluate(x_min, y_min);
+	int64_t row2 = e2.Evaluate(x_min, y_min);
+
+	int64_t step_x0 = e0.StepX(), step_x1 = e1.StepX(), step_x2 = e2.StepX();
+	int64_t step_y0 = e0.StepY(), step_y1 = e1.StepY(), step_y2 = e2.StepY();
+
+	for (int y = y_min; y <= y_max; y++, row0 += step_y0, row1 += step_y1, row2 += step_y2)
+	{
+		int64_t w0 = row0, w1 = row1, w2 = row2;
+
+		for (int x = x_min; x <= x_max; x += 4, w0 += 4 * step_x0, w1 += 4 * step_x1, w2 += 4 * step_x2)
+		{
+			// ǲþȷĶߺ֤Ϲ·ȫһ
+			float lane_w0[4], lane_w1[4], lane_w2[4];
+			int mask = 0;
+			for (int k = 0; k < 4; k++)
+			{
+				int64_t a = w0 + k * step_x0;
+				int64_t b = w1 + k * step_x1;
+				int64_t c = w2 + k * step_x2;
+				lane_w0[k] = (float)a;
+				lane_w1[k] = (float)b;
+				lane_w2[k] = (float)c;
+
+				if (x + k <= x_max && (full || (e0.Inside(a) && e1.Inside(b) && e2.Inside(c))))
+				{
+					mask |= 1 << k;
+				}
+			}
+
+			if (mask == 0)
+			{
+				continue;
+			}
+
+			__m128 b0 = _mm_mul_ps(_mm_loadu_ps(lane_w0), inv_area);
+			__m128 b1 = _mm_mul_ps(_mm_loadu_ps(lane_w1), inv_area);
+			__m128 b2 = _mm_mul_ps(_mm_loadu_ps(lane_w2), inv_area);
+
+			// ȲԣֻдǵأԽһеı߽
+			int index = y * width + x;
+			float depth[4];
+			_mm_storeu_ps(depth, Interpolate(b0, b1, b2, tri.z[0], tri.z[1], tri.z[2]));
+			for (int k = 0; k < 4; k++)
+			{
+				if (!(mask & (1 << k)))
+				{
+					continue;
+				}
+
+				PROFILE_COUNT(stats.pixels_tested, 1);
+				if (depth[k] < z_buffer[index + k])
+				{
+					z_buffer[index + k] = depth[k];
+					written++;
+				}
+				else
+				{
+					mask &= ~(1 << k);
+				}
+			}
+
+			if (mask == 0)
+			{
+				continue;
+			}
+
+			// ͸ӽֵ
+			__m128 inv_w = Interpolate(b0, b1, b2, inv_w_v[0], inv_w_v[1], inv_w_v[2]);
+			__m128 true_u = _mm_div_ps(Interpolate(b0, b1, b2, u_w[0], u_w[1], u_w[2]), inv_w);
+			__m128 true_v = _mm_div_ps(Interpolate(b0, b1, b2, v_w[0], v_w[1], v_w[2]), inv_w);
+
+			// ĵdu/dx = (d(u/w)/dx - u * d(1/w)/dx) * w·ͬ
+			__m128 lod = _mm_setzero_ps();
+			if (has_texture)
+			{
+				__m128 w = _mm_div_ps(_mm_set1_ps(1.0f), inv_w);
+				__m128 inv_w_dx = _mm_set1_ps(setup.inv_w_dx);
+				__m128 inv_w_dy = _mm_set1_ps(setup.inv_w_dy);
+				__m128 du_dx = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(setup.uw_dx), _mm_mul_ps(true_u, inv_w_dx)), w);
+				__m128 dv_dx = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(setup.vw_dx), _mm_mul_ps(true_v, inv_w_dx)), w);
+				__m128 du_dy = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(setup.uw_dy), _mm_mul_ps(true_u, inv_w_dy)), w);
+				__m128 dv_dy = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(setup.vw_dy), _mm_mul_ps(true_v, inv_w_dy)), w);
+				lod = TextureLod4(du_dx, dv_dx, du_dy, dv_dy);
+			}
+
+			Vec3x4 world_pos;
+			world_pos.x = _mm_div_ps(Interpolate(b0, b1, b2, attr_w[VaryingWorldX][0], attr_w[VaryingWorldX][1], attr_w[VaryingWorldX][2]), inv_w);
+			world_pos.y = _mm_div_ps(Interpolate(b0, b1, b2, attr_w[VaryingWorldY][0], attr_w[VaryingWorldY][1], attr_w[VaryingWorldY][2]), inv_w);
+			world_pos.z = _mm_div_ps(Interpolate(b0, b1, b2, attr_w[VaryingWorldZ][0], attr_w[VaryingWorldZ][1], attr_w[VaryingWorldZ][2]), inv_w);
+
+			// ֵ
+			Vec3x4 N;
+			N.x = Interpolate(b0, b1, b2, normal[0], normal[1], normal[2]);
+			N.y = Interpolate(b0, b1, b2, normal[3], normal[4], normal[5]);
+			N.z = Interpolate(b0, b1, b2, normal[6], normal[7], normal[8]);
+			N = Normalize(N);
+
+			// ֵߺ͸
+			Vec3x4 T = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+			Vec3x4 B = T;
+			if (has_normal_map)
+			{
+				const float* tangent = varyings + VaryingTangentX * 3;
+				const float* bitangent = varyings + VaryingBitangentX * 3;
+				T.x = Interpolate(b0, b1, b2, tangent[0], tangent[1], tangent[2]);
+				T.y = Interpolate(b0, b1, b2, tangent[3], tangent[4], tangent[5]);
+				T.z = Interpolate(b0, b1, b2, tangent[6], tangent[7], tangent[8]);
+				B.x = Interpolate(b0, b1, b2, bitangent[0], bitangent[1], bitangent[2]);
+				B.y = Interpolate(b0, b1, b2, bitangent[3], bitangent[4], bitangent[5]);
+				B.z = Interpolate(b0, b1, b2, bitangent[6], bitangent[7], bitangent[8]);
+			}
+
+			// ӳɫֻ¼ԣս׶
+			if (write_gbuffer)
+			{
+				float px[4], py[4], pz[4], us[4], vs[4], lods[4], nx[4], ny[4], nz[4];
+				_mm_storeu_ps(px, world_pos.x);
+				_mm_storeu_ps(py, world_pos.y);
+				_mm_storeu_ps(pz, world_pos.z);
+				_mm_storeu_ps(us, true_u);
+				_mm_storeu_ps(vs, true_v);
+				_mm_storeu_ps(lods, lod);
+				_mm_storeu_ps(nx, N.x);
+				_mm_storeu_ps(ny, N.y);
+				_mm_storeu_ps(nz, N.z);
+				for (int k = 0; k < 4; k++)
+				{
+					if (mask & (1 << k))
+					{
+						ctx.gbuffer->Write(index + k, Vec3(px[k], py[k], pz[k]), us[k], vs[k], lods[k], Vec3(nx[k], ny[k], nz[k]), ctx.material_id);
+					}
+				}
+
+				if (has_normal_map)
+				{
+					float tx[4], ty[4], tz[4], bx[4], by[4], bz[4];
+					_mm_storeu_ps(tx, T.x);
+					_mm_storeu_ps(ty, T.y);
+					_mm_storeu_ps(tz, T.z);
+					_mm_storeu_ps(bx, B.x);
+					_mm_storeu_ps(by, B.y);
+					_mm_storeu_ps(bz, B.z);
+					for (int k = 0; k < 4; k++)
+					{
+						if (mask & (1 << k))
+						{
+							ctx.gbuffer->WriteTangentFrame(index + k, Vec3(tx[k], ty[k], tz[k]), Vec3(bx[k], by[k], bz[k]));
+						}
+					}
+				}
+				continue;
+			}
+
+			int lane_clusters[4];
+			int quad_lights = QuadClusters(*ctx.clusters, x, y, world_pos, mask, lane_clusters);
+			PROFILE_COUNT(stats.pixels_shaded, BitCount(mask));
+			PROFILE_COUNT(stats.texture_samples, BitCount(mask) * ctx.surface.SampleCount());
+			PROFILE_COUNT(stats.pixel_lights, quad_lights);
+			StorePixels(ctx.frame_buffer + index, ShadeQuad<FEATURES == SHADER_DYNAMIC ? SHADER_DYNAMIC : (FEATURES & ~FeatureGBuffer)>(ctx.surface, world_pos, true_u, true_v, lod, N, T, B, mask, cam_pos,
+				*ctx.lights, ctx.shadows, *ctx.clusters, lane_clusters), mask);
+		}
+	}
+
+	return written;
+}
+
+// ÿϵĺ SelectRasterizeBlock ͬ
+template <int BASE, int... F>
+static constexpr std::array<RasterizeBlockFunc, sizeof...(F)> RasterizeBlockTableSSE41(std::integer_sequence<int, F...>)
+{
+	return { { &RasterizeBlockSSE41<BASE | F>... } };
+}
+
+static constexpr std::array<RasterizeBlockFunc, SHADER_PERMUTATIONS> rasterize_block_table = RasterizeBlockTableSSE41<0>(std::make_integer_sequence<int, SHADER_PERMUTATIONS>());
+static constexpr std::array<RasterizeBlockFunc, 4> rasterize_block_gbuffer_table = RasterizeBlockTableSSE41<FeatureGBuffer>(std::make_integer_sequence<int, 4>());
+
+RasterizeBlockFunc SelectRasterizeBlockSSE41(int features)
+{
+	if (features == SHADER_DYNAMIC)
+	{
+		return &RasterizeBlockSSE41<SHADER_DYNAMIC>;
+	}
+	if (features & FeatureGBuffer)
+	{
+		return rasterize_block_gbuffer_table[features & (FeatureDiffuseMap | FeatureNormalMap)];
+	}
+	return rasterize_block_table[features];
+}
+
+// ӳɫս׶ΰصĲѡõɫ
+typedef __m128i (*ShadeQuadFunc)(const SurfaceMaterial& surface, const Vec3x4& world_pos, __m128 true_u, __m128 true_v, __m128 lod, const Vec3x4& N, const Vec3x4& T, const Vec3x4& B, int mask, const Vec3x4& cam_pos,
+	const std::vector<Light>& lights, const ShadowMap* shadows, const LightClusters& clusters, const int lane_clusters[4]);
+
+//  __m128iŽ std::array ᶪ͵ԣͨ
+template <int... F>
+struct ShadeQuadTable
+{
+	static constexpr ShadeQuadFunc table[sizeof...(F)] = { &ShadeQuad<F>... };
+};
+
+template <int... F>
+static ShadeQuadTable<F...> MakeShadeQuadTable(std::integer_sequence<int, F...>);
+
+typedef decltype(MakeShadeQuadTable(std::make_integer_sequence<int, SHADER_PERMUTATIONS>())) ShadeQuadPermutations;
+
+void SSE41_TARGET ResolveRowSSE41(GBuffer& gbuffer, const std::vector<SurfaceMaterial>& materials, int y, const Vec3& camera_pos, const std::vector<Light>& lights, const ShadowMap* shadows, int scene_features, const LightClusters& clusters, Uint32* frame_buffer, RenderStats& stats)
+{
+	const Vec3x4 cam_pos = Broadcast(camera_pos);
+	int width = gbuffer.width;
+	uint16_t* ids = gbuffer.material_id.data();
+
+	for (int x = 0; x < width; x += 4)
+	{
+		int index = y * width + x;
+
+		// мأĩ 4 ʱȥԽһеĲ
+		int mask = 0;
+		for (int k = 0; k < 4 && x + k < width; k++)
+		{
+			if (ids[index + k] != 0)
+			{
+				mask |= 1 << k;
+			}
+		}
+
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		Vec3x4 world_pos = { _mm_loadu_ps(&gbuffer.pos_x[index]), _mm_loadu_ps(&gbuffer.pos_y[index]), _mm_loadu_ps(&gbuffer.pos_z[index]) };
+		Vec3x4 N = { _mm_loadu_ps(&gbuffer.nor_x[index]), _mm_loadu_ps(&gbuffer.nor_y[index]), _mm_loadu_ps(&gbuffer.nor_z[index]) };
+		Vec3x4 T = { _mm_loadu_ps(&gbuffer.tan_x[index]), _mm_loadu_ps(&gbuffer.tan_y[index]), _mm_loadu_ps(&gbuffer.tan_z[index]) };
+		Vec3x4 B = { _mm_loadu_ps(&gbuffer.bit_x[index]), _mm_loadu_ps(&gbuffer.bit_y[index]), _mm_loadu_ps(&gbuffer.bit_z[index]) };
+		__m128 true_u = _mm_loadu_ps(&gbuffer.tex_u[index]);
+		__m128 true_v = _mm_loadu_ps(&gbuffer.tex_v[index]);
+		__m128 lod = _mm_loadu_ps(&gbuffer.tex_lod[index]);
+
+		int lane_clusters[4];
+		int quad_lights = QuadClusters(clusters, x, y, world_pos, mask, lane_clusters);
+		PROFILE_COUNT(stats.pixel_lights, quad_lights);
+
+		//  4 ؿڲͬʣÿֲʸɫһΣͨ 4 ضͬһֲ
+		PROFILE_COUNT(stats.pixels_shaded, BitCount(mask));
+		while (mask != 0)
+		{
+			uint16_t id = 0;
+			int same = 0;
+			for (int k = 0; k < 4; k++)
+			{
+				if (!(mask & (1 << k)))
+				{
+					continue;
+				}
+
+				if (id == 0)
+				{
+					id = ids[index + k];
+				}
+				if (ids[index + k] == id)
+				{
+					same |= 1 << k;
+				}
+			}
+
+			PROFILE_COUNT(stats.texture_samples, BitCount(same) * materials[id - 1].SampleCount());
+			ShadeQuadFunc shade = scene_features == SHADER_DYNAMIC ? &ShadeQuad<SHADER_DYNAMIC> : ShadeQuadPermutations::table[materials[id - 1].Features() | scene_features];
+			StorePixels(frame_buffer + index, shade(materials[id - 1], world_pos, true_u, true_v, lod, N, T, B, same, cam_pos, lights, shadows, clusters, lane_clusters), same);
+			mask &= ~same;
+		}
+
+		// գһ֡ G-Buffer
+		for (int k = 0; k < 4 && x + k < width; k++)
+		{
+			ids[index + k] = 0;
+		}
+	}
+}
+
+#else
+
+bool CpuSupportsSSE41()
+{
+	return false;
+}
+
+RasterizeBlockFunc SelectRasterizeBlockSSE41(int features)
+{
+	return SelectRasterizeBlock(features);
+}
+
+void ResolveRowSSE41(GBuffer& gbuffer, const std::vector<SurfaceMaterial>& materials, int y, const Vec3& camera_pos, const std::vector<Light>& lights, const ShadowMap* shadows, int scene_features, const LightClusters& clusters, Uint32* frame_buffer, RenderStats& stats)
+{
+}
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include <SDL3/SDL.h>
+#include "RenderData.h"
+
+// x86 ƽ̨ű SSE4.1 ںˣƽ̨ʼ߱·
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define RENDERER_HAS_SSE41 1
+#else
+#define RENDERER_HAS_SSE41 0
+#endif
+
+#if RENDERER_HAS_SSE41
+#include <smmintrin.h>
+
+// MSVC ֱʹ SSE4.1 ָGCC/Clang Ҫָ
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SSE41_TARGET
+#else
+#define SSE41_TARGET __attribute__((target("sse4.1")))
+#endif
+#endif
+
+// ʱ CPU Ƿ֧ SSE4.1
+bool CpuSupportsSSE41();
+
+//  features Ӧ SSE4.1 դ SelectRasterizeBlock ֧ͬ SSE4.1 ƽ̨ر汾
+// դһؿ飨full ʾ鶼ڣǲԣдȵ
+// һδһڵ 4 أǲԡȲԡ͸ӽֵ Blinn-Phong ն 4 ·
+// ȻؽУ·ںСһ
+RasterizeBlockFunc SelectRasterizeBlockSSE41(int features);
+
+// ӳɫս׶ε SSE4.1 汾4 һɫ ResolveRow һ
+void ResolveRowSSE41(GBuffer& gbuffer, const std::vector<SurfaceMaterial>& materials, int y, const Vec3& camera_pos, const std::vector<Light>& lights, const ShadowMap* shadows, int scene_features, const LightClusters& clusters, Uint32* frame_buffer, RenderStats& stats);
@@ -1,40 +1,287 @@
 #pragma once
 
+#include <cstdint>
+#include <cmath>
+#include <cfloat>
+#include <vector>
+#include <algorithm>
+#include <SDL3/SDL.h>
 #include "Math.h"
+#include "Texture.h"
 
-struct Vertex
+// Ĳֵԣvaryingÿռһλã VaryingSlot ˳
+// ÿλֻ㡢洢Ͳֵõǰ varying_count ͼһҪûзͼʱҪߺ͸
+enum VaryingSlot
 {
-	Vec3 position;
-	float inv_w;//͸ӽ
-	Vec3 color;
-	Vec2 texcoord;
-	Vec3 normal;
-	Vec3 world_pos;
-	float pos_clip_w;
+	VaryingU, VaryingV,
+	VaryingWorldX, VaryingWorldY, VaryingWorldZ,
+	VaryingNormalX, VaryingNormalY, VaryingNormalZ,
+	VaryingTangentX, VaryingTangentY, VaryingTangentZ,// ռߺ͸ߣ뷨һ𹹳ɷͼ߿ռ
+	VaryingBitangentX, VaryingBitangentY, VaryingBitangentZ,
+	VARYING_MAX,
+};
+
+const int VARYINGS_SURFACE = VaryingTangentX;// ꡢͷ
+const int VARYINGS_TANGENT_FRAME = VARYING_MAX;// ټߺ͸
+
+// ελò֣ͬһţSoA
+// üʱ xyzw ǲüռꣻTransformToScreen ֮ xy Ļ꣬z ȣinv_w = 1 / w ͸ӽ
+// ֵţ s ڶ k ϵֵ varyings[s * 3 + k]νֿ Hi-Z ޳
+struct Triangle
+{
+	float x[3], y[3], z[3], w[3];
+	float inv_w[3];
+};
+
+// βֵд slot ʼڶ k ɵ
+inline Vec3 VaryingVec3(const float* varyings, int slot, int k)
+{
+	return Vec3(varyings[slot * 3 + k], varyings[(slot + 1) * 3 + k], varyings[(slot + 2) * 3 + k]);
+}
 
-	Vertex() : position(), inv_w(), color(), texcoord(), normal(), world_pos(), pos_clip_w() {}
-	Vertex(const Vec3& p, const float w, const Vec3& c, const Vec2& t, const Vec3& n, const Vec3& wp, const float pcw) : position(p), inv_w(w), color(c), texcoord(t), normal(n), world_pos(wp), pos_clip_w(pcw) {}
+// βüʱһ㣺üռͲֵԣֻǰ varying_count Ч
+struct ClipVertex
+{
+	float x, y, z, w;
+	float varying[VARYING_MAX];
 
-	static Vertex lerp(const Vertex& a, const Vertex& b, float t)
+	// Բֵֵķߡߺ͸¹һ
+	static ClipVertex lerp(const ClipVertex& a, const ClipVertex& b, float t, int varying_count)
 	{
-		Vertex v;
-		v.position = a.position + (b.position - a.position) * t;
-		v.color = a.color + (b.color - a.color) * t;
-		v.texcoord = a.texcoord + (b.texcoord - a.texcoord) * t;
-		v.normal = normalize(a.normal + (b.normal - a.normal) * t);
-		v.world_pos = a.world_pos + (b.world_pos - a.world_pos) * t;
-		v.pos_clip_w = a.pos_clip_w + (b.pos_clip_w - a.pos_clip_w) * t;
-		v.inv_w = 1.0f / v.pos_clip_w;
+		ClipVertex v;
+		v.x = a.x + (b.x - a.x) * t;
+		v.y = a.y + (b.y - a.y) * t;
+		v.z = a.z + (b.z - a.z) * t;
+		v.w = a.w + (b.w - a.w) * t;
+		for (int i = 0; i < varying_count; i++)
+		{
+			v.varying[i] = a.varying[i] + (b.varying[i] - a.varying[i]) * t;
+		}
+		for (int i = VaryingNormalX; i + 2 < varying_count; i += 3)
+		{
+			Vec3 n = normalize(Vec3(v.varying[i], v.varying[i + 1], v.varying[i + 2]));
+			v.varying[i] = n.x;
+			v.varying[i + 1] = n.y;
+			v.varying[i + 2] = n.z;
+		}
 
 		return v;
 	}
 };
 
-struct Triangle
+// 任棺ģ͵ÿÿֻ֡任һΣΰ±ȡ
+struct VertexCache
+{
+	std::vector<Vec4> clip_pos;// üռ
+	std::vector<Vec3> world_pos;// 
+	std::vector<Vec3> world_normal;// ռйһķ
+	std::vector<Vec3> world_tangent;// ռйһߣֻҪߵĻм
+	std::vector<Vec3> world_bitangent;// ռĸߣѾߵķ
+	std::vector<uint8_t> clip_flags;// ЩüƽࣨClipFlags ϣ
+};
+
+// üռжԸüƽλãÿƽһλ
+// ǰ 6 λ׶ 6 ƽ棺㶼ͬһƽʱɼֱ޳
+//  2 λǷſguard bandҡƽ棺ֻгβҪü
+// ೬ĻĲֽդʱİΧǯƣµ
+enum ClipFlags : uint8_t
+{
+	ClipLeft = 1 << 0, ClipRight = 1 << 1, ClipBottom = 1 << 2, ClipTop = 1 << 3, ClipNear = 1 << 4, ClipFar = 1 << 5,
+	ClipGuardX = 1 << 6, ClipGuardY = 1 << 7,
+	ClipFrustum = ClipLeft | ClipRight | ClipBottom | ClipTop | ClipNear | ClipFar,
+};
+
+// դʹ 8 λؾȵĶ꣬ߺûۼ
+const int SUBPIXEL_BITS = 8;
+const int64_t SUBPIXEL_ONE = 1 << SUBPIXEL_BITS;
+const float SCREEN_COORD_LIMIT = (float)(1 << 20);// ĻǯƷΧ֤ߺ int64üβᳬΧ
+
+// һߵıߺ E(x, y) = A * (x - x0) + B * (y - y0)ڲ E > 0
+struct EdgeEquation
+{
+	int64_t A, B;// 
+	int64_t x0, y0;// Ķ
+	bool top_left;// Ƿϱ߻ߣǡڱϵֻϱߺڵ
+
+	//  (x, y) Ĵֵ
+	int64_t Evaluate(int x, int y) const
+	{
+		int64_t px = ((int64_t)x << SUBPIXEL_BITS) + SUBPIXEL_ONE / 2;
+		int64_t py = ((int64_t)y << SUBPIXEL_BITS) + SUBPIXEL_ONE / 2;
+		return A * (px - x0) + B * (py - y0);
+	}
+
+	// ҡƶһʱߺ
+	int64_t StepX() const { return A * SUBPIXEL_ONE; }
+	int64_t StepY() const { return B * SUBPIXEL_ONE; }
+
+	// 򣺹ϵؼȲửҲ©
+	bool Inside(int64_t value) const { return value > 0 || (value == 0 && top_left); }
+};
+
+// ν׶εĽÿֻһ
+struct TriangleSetup
+{
+	EdgeEquation edge[3];// edge[i] Ƕ i ıߣֵ붥 i 
+	float inv_area;// ĵڰѱߺֵת
+	float min_z;// ȣ Hi-Z ޳
+	float z_dx, z_dy;//  xy ƶһص
+	float uw_dx, uw_dy, vw_dx, vw_dy;// u/wv/w  xy ƶһصڼĵ
+	float inv_w_dx, inv_w_dy;// 1/w  xy ƶһص
+};
+
+// Ļֿ飬[x0, x1] x [y0, y1] Ǳ
+struct Tile
+{
+	int x0, y0;
+	int x1, y1;
+};
+
+// Ľ t ֿ± indices е [offsets[t], offsets[t + 1])ύ˳
+// зֿ鹲һ飬ֻȡڷֿ֮ƶԴڶʱҪ·ڴ
+struct TileBins
+{
+	std::vector<uint32_t> offsets;
+	std::vector<int> indices;
+};
+
+// ֲȻ壨Hi-ZȻ֮ϼ¼ÿ 8x8 ؿÿĻֿ
+// Σؿ飩ȶֵԶʱ治ͨȲ
+struct HiZBuffer
+{
+	int blocks_x, blocks_y;
+	int tiles_x, tiles_y;
+	std::vector<float> block_max;
+	std::vector<float> tile_max;
+
+	HiZBuffer() : blocks_x(0), blocks_y(0), tiles_x(0), tiles_y(0) {}
+
+	void Resize(int width, int height, int block_size, int tile_size)
+	{
+		blocks_x = (width + block_size - 1) / block_size;
+		blocks_y = (height + block_size - 1) / block_size;
+		tiles_x = (width + tile_size - 1) / tile_size;
+		tiles_y = (height + tile_size - 1) / tile_size;
+		block_max.assign(blocks_x * blocks_y, 1.0f);
+		tile_max.assign(tiles_x * tiles_y, 1.0f);
+	}
+};
+
+// ӳɫ G-Bufferν׶μ¼ÿԣս׶ٶÿɼɫһ
+// ֱʹȻ壻԰ֿţս׶οһζȡһڵ 4 
+struct GBuffer
+{
+	int width, height;
+	std::vector<float> pos_x, pos_y, pos_z;// ص
+	std::vector<float> tex_u, tex_v;// ͸ӽ
+	std::vector<float> tex_lod;//  lodС޹أս׶ûص uvֻڼν׶
+	std::vector<float> nor_x, nor_y, nor_z;// ֵһĶ㷨
+	std::vector<float> tan_x, tan_y, tan_z;// ֵߺ͸ߣֻдͼĲʲŻд
+	std::vector<float> bit_x, bit_y, bit_z;
+	std::vector<uint16_t> material_id;// ʱе± 10 ʾûм
+
+	GBuffer() : width(0), height(0) {}
+
+	void Resize(int w, int h)
+	{
+		width = w;
+		height = h;
+
+		//  3 Ԫأһа 4 һȡʱԽ
+		size_t count = (size_t)w * h + 3;
+		pos_x.assign(count, 0.0f);
+		pos_y.assign(count, 0.0f);
+		pos_z.assign(count, 0.0f);
+		tex_u.assign(count, 0.0f);
+		tex_v.assign(count, 0.0f);
+		tex_lod.assign(count, 0.0f);
+		nor_x.assign(count, 0.0f);
+		nor_y.assign(count, 0.0f);
+		nor_z.assign(count, 0.0f);
+		tan_x.assign(count, 0.0f);
+		tan_y.assign(count, 0.0f);
+		tan_z.assign(count, 0.0f);
+		bit_x.assign(count, 0.0f);
+		bit_y.assign(count, 0.0f);
+		bit_z.assign(count, 0.0f);
+		material_id.assign(count, 0);
+	}
+
+	void Write(int index, const Vec3& world_pos, float u, float v, float lod, const Vec3& normal, uint16_t id)
+	{
+		pos_x[index] = world_pos.x;
+		pos_y[index] = world_pos.y;
+		pos_z[index] = world_pos.z;
+		tex_u[index] = u;
+		tex_v[index] = v;
+		tex_lod[index] = lod;
+		nor_x[index] = normal.x;
+		nor_y[index] = normal.y;
+		nor_z[index] = normal.z;
+		material_id[index] = id;
+	}
+
+	void WriteTangentFrame(int index, const Vec3& tangent, const Vec3& bitangent)
+	{
+		tan_x[index] = tangent.x;
+		tan_y[index] = tangent.y;
+		tan_z[index] = tangent.z;
+		bit_x[index] = bitangent.x;
+		bit_y[index] = bitangent.y;
+		bit_z[index] = bitangent.z;
+	}
+};
+
+// Ⱦͳƣÿ̸߳ۼӣȡʱٻ
+// pixels_testedpixels_shadedblocks_*texture_samplespixel_lights ڲѭۼӣ PROFILE_COUNT ֻ RENDERER_PROFILE=1 ʱͳƣһֱ 0
+struct RenderStats
 {
-	Vertex v[3];
+	uint64_t pixels_tested;// θǡȲԵ
+	uint64_t pixels_shaded;// ɹռӳɫʱڹս׶ͳƣ
+	uint64_t blocks_rejected;// ֹդȫ⡢ֱؿ
+	uint64_t blocks_accepted;// ȫڡظǲԵؿ
+	uint64_t blocks_partial;// ָǡҪزԵؿ
+	uint64_t blocks_occluded;//  Hi-Z ޳ؿ
+	uint64_t triangles_occluded;//  Hi-Z ĳĻֿ޳
+	uint64_t vertices_transformed;// 㴦׶α任Ķ
+	uint64_t triangles_submitted;// ޳ͽƽüȥդ
+	uint64_t models_culled;// Χ׶⡢ Render 
+	uint64_t triangles_lod_skipped;// ѡýϴֵ LOD ԭʼٴ
+	uint64_t triangles_frustum_culled;// 㶼׶ͬһƽࡢֱ޳
+	uint64_t triangles_guard_clipped;// βü
+	uint64_t triangles_backface_culled;// νʱĻռĳ޳ı棨CullFront ʱ棩Σƽüθһ
+	uint64_t triangles_clipped_one;// ƽüʱֻһڲࡢóһСε
+	uint64_t triangles_clipped_two;// ƽüʱڲࡢε
+	uint64_t pixels_depth_passed;// ͨȲԡдȵ
+	uint64_t texture_samples;// ͼͷͼһΣ
+	uint64_t pixel_lights;// ɫʱĹԴ֮ͣ pixels_shaded ÿƽĹԴ
+
+	RenderStats() : pixels_tested(0), pixels_shaded(0), blocks_rejected(0), blocks_accepted(0), blocks_partial(0), blocks_occluded(0), triangles_occluded(0), vertices_transformed(0), triangles_submitted(0),
+		models_culled(0), triangles_lod_skipped(0), triangles_frustum_culled(0), triangles_guard_clipped(0), triangles_backface_culled(0), triangles_clipped_one(0), triangles_clipped_two(0), pixels_depth_passed(0), texture_samples(0), pixel_lights(0) {}
 
-	Triangle() : v() {}
+	RenderStats& operator+=(const RenderStats& s)
+	{
+		pixels_tested += s.pixels_tested;
+		pixels_shaded += s.pixels_shaded;
+		blocks_rejected += s.blocks_rejected;
+		blocks_accepted += s.blocks_accepted;
+		blocks_partial += s.blocks_partial;
+		blocks_occluded += s.blocks_occluded;
+		triangles_occluded += s.triangles_occluded;
+		vertices_transformed += s.vertices_transformed;
+		triangles_submitted += s.triangles_submitted;
+		models_culled += s.models_culled;
+		triangles_lod_skipped += s.triangles_lod_skipped;
+		triangles_frustum_culled += s.triangles_frustum_culled;
+		triangles_guard_clipped += s.triangles_guard_clipped;
+		triangles_backface_culled += s.triangles_backface_culled;
+		triangles_clipped_one += s.triangles_clipped_one;
+		triangles_clipped_two += s.triangles_clipped_two;
+		pixels_depth_passed += s.pixels_depth_passed;
+		texture_samples += s.texture_samples;
+		pixel_lights += s.pixel_lights;
+		return *this;
+	}
 };
 
 struct Camera
@@ -58,32 +305,63 @@ struct Camera
 
 enum LightType { Directional = 0, Point = 1 };
 
+// Դ˥ȵֵͲټ㣬ð뾶Ĺײ 8 λɫһ
+const float LIGHT_CUTOFF = 1.0f / 256.0f;
+
 struct Light
 {
 	LightType type;
 
 	Vec3 direction;
-	Vec3 dir_inv;//շ
+	Vec3 dir_inv;// շָԴĵλԴʱãɫʱٹһ
 	Vec3 color;
 	float intensity;
 
 	Vec3 position;
 	float Kc, Kl, Kq;
+	float range;// ð뾶ƽйΪ FLT_MAX˵ԴɫǿȻ˥ϵҪ UpdateRange
+	int shadow_size;// Ӱͼı߳Դͼÿı߳0 ʾͶӰ
 
+	// ˥ intensity * max(color) / (Kc + Kl * d + Kq * d^2)  LIGHT_CUTOFF ʱľ d
+	void UpdateRange()
+	{
+		float brightness = intensity * std::max(color.x, std::max(color.y, color.z));
+		float c = Kc - brightness / LIGHT_CUTOFF;
+		if (type == LightType::Directional || (Kq <= 0.0f && Kl <= 0.0f))
+		{
+			range = FLT_MAX;
+		}
+		else if (c >= 0.0f)
+		{
+			range = 0.0f;// ڹԴҲղκζ
+		}
+		else if (Kq <= 0.0f)
+		{
+			range = -c / Kl;
+		}
+		else
+		{
+			range = (-Kl + std::sqrt(Kl * Kl - 4.0f * Kq * c)) / (2.0f * Kq);
+		}
+	}
+
+	// ȰгԱ㣬òĲƽйλú˥ϵҲȷֵ
 	static Light Directional(Vec3 dir, Vec3 col, float intens)
 	{
-		Light l;
+		Light l{};
 		l.type = LightType::Directional;
 		l.direction = normalize(dir);
-		l.dir_inv = dir * -1.0f;
+		l.dir_inv = l.direction * -1.0f;
 		l.color = col;
 		l.intensity = intens;
+		l.range = FLT_MAX;
+		l.shadow_size = 0;
 		return l;
 	}
 
 	static Light Point(Vec3 pos, Vec3 col, float intens, float kl = 0.09f, float kq = 0.032f)
 	{
-		Light l;
+		Light l{};
 		l.type = LightType::Point;
 		l.position = pos;
 		l.color = col;
@@ -91,14 +369,164 @@ struct Light
 		l.Kc = 1.0f;
 		l.Kl = kl;
 		l.Kq = kq;
+		l.UpdateRange();
+		l.shadow_size = 0;
 		return l;
 	}
 };
 
+// ɫõԣÿ϶ʵһרŵĹդɫ루ɫУRender ÿλưʺ͹Դѡһ
+// ûеڱھͱȥصѭﲻжͼǷڡԴһ
+enum ShaderFeature
+{
+	FeatureDiffuseMap = 1 << 0,// ͼ̸
+	FeatureNormalMap = 1 << 1,
+	FeatureSpecular = 1 << 2,// ߹ϵΪ 0Ҫ͸߹
+	FeatureDirectional = 1 << 3,// Դƽй
+	FeaturePoint = 1 << 4,// ԴеԴ
+	FeatureShadows = 1 << 5,// йԴӰͼ
+	FeatureFastMath = 1 << 6,//  FastMath.h ĿٽƣMathFastþȷ㷨
+	FeatureGBuffer = 1 << 7,// ӳɫļν׶Σֻд G-Bufferֻͼλ
+};
+
+const int SHADER_PERMUTATIONS = 1 << 7;// ǰɫ FeatureGBuffer
+const int SHADER_DYNAMIC = -1;// ػÿԶʱжϣػ֮ǰĴͬڶԱ
+
+// Ƿ򿪣FEATURES Ǳڵʱǳòķ֧ȥSHADER_DYNAMIC ʱʱ dynamic
+template <int FEATURES>
+inline bool ShaderHas(int feature, bool dynamic)
+{
+	return FEATURES == SHADER_DYNAMIC ? dynamic : (FEATURES & feature) != 0;
+}
+
+// Դǲƽй⣺ֻһֹԴʱж
+template <int FEATURES>
+inline bool ShaderIsDirectional(const Light& light)
+{
+	if (FEATURES != SHADER_DYNAMIC && ((FEATURES & FeatureDirectional) == 0 || (FEATURES & FeaturePoint) == 0))
+	{
+		return (FEATURES & FeatureDirectional) != 0;
+	}
+	return light.type == LightType::Directional;
+}
+
 struct Material
 {
 	float ambient;
 	float diffuse;
 	float specular;
 	float shininess;//߹ָ
+};
+
+// ʲõͼӳɫʱ ID Ӳʱȡ
+struct SurfaceMaterial
+{
+	Material material;
+	Texture* texture;
+	Texture* normal_map;
+	TextureFilter filter;
+
+	// ɫһҪ
+	int SampleCount() const { return (texture != NULL) + (normal_map != NULL); }
+
+	// ɲʾɫԣShaderFeatureԴصλ Render 
+	int Features() const
+	{
+		return (texture != NULL ? FeatureDiffuseMap : 0) | (normal_map != NULL ? FeatureNormalMap : 0) | (material.specular != 0.0f ? FeatureSpecular : 0);
+	}
+
+	// ҪЯĲֵԸVaryingSlotֻзͼõߺ͸
+	int VaryingCount() const { return normal_map != NULL ? VARYINGS_TANGENT_FRAME : VARYINGS_SURFACE; }
+};
+
+// ִعԴ޳Ļ CLUSTER_TILE_SIZE طֿ飬ӿռڽƽԶƽ֮䰴ֳָ CLUSTER_SLICES 
+const int CLUSTER_TILE_SIZE = 32;
+const int CLUSTER_SLICES = 32;
+
+// Դأÿؼ¼÷ΧཻĹԴ±ֹ꣨Դԭ˳򣩣ɫʱֻڴصб
+// ƽйеĴأرչԴ޳ʱֻһйԴĴ
+struct LightClusters
+{
+	int width, height;
+	int tile_size;
+	int tiles_x, tiles_y, slices;
+	Vec3 camera_pos;
+	Vec3 forward;// ߷ӿռ = dot(world_pos - camera_pos, forward)
+	float slice_scale, slice_bias;// ڵĲ = log2(depth) * slice_scale + slice_bias
+	std::vector<uint32_t> offsets;//  i صĹԴ± indices е [offsets[i], offsets[i + 1])
+	std::vector<uint32_t> indices;
+
+	LightClusters() : width(0), height(0), tile_size(1), tiles_x(0), tiles_y(0), slices(0), camera_pos(), forward(), slice_scale(0), slice_bias(0) {}
+
+	int Slice(float depth) const
+	{
+		float slice = std::log2(std::max(depth, 1e-6f)) * slice_scale + slice_bias;
+		return std::min(std::max((int)slice, 0), slices - 1);
+	}
+
+	// Ļ (x, y) Ϊ world_pos ڵĴ
+	int Cluster(int x, int y, const Vec3& world_pos) const
+	{
+		int slice = Slice(dot(world_pos - camera_pos, forward));
+		return (slice * tiles_y + y / tile_size) * tiles_x + x / tile_size;
+	}
+
+	const uint32_t* Lights(int cluster) const { return indices.data() + offsets[cluster]; }
+	int LightCount(int cluster) const { return (int)(offsets[cluster + 1] - offsets[cluster]); }
+};
+
+// ӰͼƽйһͶӰͼԴ +X-X+Y-Y+Z-Z 6 ͼ
+// ȻͬͶӰ NDC zûмΪ 1
+struct ShadowMap
+{
+	int size;// ÿı߳
+	int faces;// 0 ʾԴͶӰ
+	Mat4 view_projection[6];// ÿͶӰͼ
+	float texel_scale;// ƽйһռеı߳ԴԴ 1 λı߳ԾõشС
+	bool pcf;// ѯʱǷ PCF 
+	bool valid;// depth ǰ light һεͶȾģ߶ûʱֱ
+	Light light;// ȾͼʱĹԴ
+	std::vector<float> depth;// δţÿ size * size 
+
+	ShadowMap() : size(0), faces(0), texel_scale(0), pcf(false), valid(false), light() {}
+
+	const float* Face(int face) const { return depth.data() + (size_t)face * size * size; }
+	float* Face(int face) { return depth.data() + (size_t)face * size * size; }
+};
+
+// һ UpdateShadowMaps ͳ
+struct ShadowStats
+{
+	int maps_rendered;// ȾӰͼ
+	int maps_cached;// ԴͶ߶û䡢ֱõӰͼ
+	int faces_rendered;// ȾԴһͼ 6 
+	uint64_t casters_culled;// Χĳ׶⡢Ͷ
+	uint64_t vertices_transformed;
+	uint64_t triangles_submitted;// üͱ޳ȥդ
+	uint64_t pixels_tested;//  RenderStats һֻ RENDERER_PROFILE=1 ʱͳ
+	uint64_t pixels_written;// ͨȲԡдȵ
+
+	ShadowStats() : maps_rendered(0), maps_cached(0), faces_rendered(0), casters_culled(0), vertices_transformed(0), triangles_submitted(0), pixels_tested(0), pixels_written(0) {}
+};
+
+struct DrawContext;
+
+// դһؿĺÿɫһдȵ
+typedef int (*RasterizeBlockFunc)(const Triangle& tri, const float* varyings, const TriangleSetup& setup, const Tile& block, bool full, const DrawContext& ctx, RenderStats& stats);
+
+// һ Render ιõĻ״̬
+struct DrawContext
+{
+	int width, height;
+	Camera* camera;
+	Uint32* frame_buffer;
+	float* z_buffer;
+	const std::vector<Light>* lights;
+	const LightClusters* clusters;// lights ػֵĽÿ֡ Render ؽ
+	const ShadowMap* shadows;//  lights һһӦӰͼNULL ʾӰ
+	SurfaceMaterial surface;
+	GBuffer* gbuffer;// Ϊ NULL ʱӳɫļν׶Σֻд G-Buffer ɫ
+	uint16_t material_id;// д G-Buffer Ĳ ID
+	int features;// λƵɫϣShaderFeature
+	RasterizeBlockFunc rasterize_block;//  features Ƿʹ SIMD ѡĹդ
 };
\ No newline at end of file
@@ -4,150 +4,1582 @@ using namespace std;
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <array>
+#include <utility>
+
+#include <SDL3_image/SDL_image.h>
 
 #include "Renderer.h"
+#include "TileScheduler.h"
+#include "RasterSIMD.h"
+#include "FastMath.h"
+#include "Profiler.h"
+
+// ÿ Render õбͷֿбÿ֡·ڴ
+// εĲֵ԰λƵ varying_count  triangle_varyings У i δ i * varying_count * 3 ʼ
+static std::vector<Triangle> triangles;
+static std::vector<float> triangle_varyings;
+static std::vector<TriangleSetup> setups;
+static TileBins tile_bins;
+
+// ÿ߳һͳƣж룬α
+struct alignas(64) WorkerStats
+{
+	RenderStats stats;
+};
+static std::vector<WorkerStats> worker_stats;
+
+// ʱһ CPU֧ SSE4.1 Ĭ SIMD ·
+static bool simd_enabled = CpuSupportsSSE41();
+
+// Hi-Z Ȼͬߴάÿֿɶռ̸߳
+// ڶ Render ֮䱣դʱȻһ£ClearDepth  InvalidateHiZ ֮󡢻Ȼرչ Hi-Z ʱ
+static HiZBuffer hiz;
+static bool hiz_enabled = true;
+static bool hiz_valid = false;
+static const float* hiz_z_buffer = NULL;
+
+// 任棬ÿ Render 
+static VertexCache vertex_cache;
+
+// ӳɫG-Buffer Ļͬߴ磬ʱ¼֡ÿ Render Ĳʣս׶ν
+static GBuffer gbuffer;
+static std::vector<SurfaceMaterial> deferred_materials;
+static bool deferred_enabled = false;
+
+// ˷ʽĬԹˣСʱ־ݺ˸
+static TextureFilter texture_filter = FilterTrilinear;
+
+// ׶޳ͱüرʱֻƽüڶԱȣ
+static bool frustum_culling_enabled = true;
+
+// ϸڲΣͶӰĻϵļѡģ͵ LODرʱʼʹԭʼڶԱȣ
+static bool lod_enabled = true;
+static float lod_error_pixels = 1.0f;
+
+// ԴأԴ仯һ Render ʱؽرչԴ޳ʱÿرйԴڶԱȣ
+static LightClusters light_clusters;
+static bool light_culling_enabled = true;
+
+// Ӱͼ UpdateShadowMaps ĹԴһһӦͼͳ뻭ͳƷֿۼ
+static std::vector<ShadowMap> shadow_maps;
+static std::vector<ShadowCaster> shadow_casters;// һȾӰͼʱͶߣжϼǷƶ
+static std::vector<WorkerStats> shadow_worker_stats;
+static bool shadow_mapping_enabled = true;
+static bool shadow_pcf_enabled = true;
+static bool shadow_cache_enabled = true;
+
+// ɫѡػĹդɫ룬رʱʹʱжÿԵͨð汾ڶԱȣ
+static bool shader_specialization_enabled = true;
+
+// ʹ FastMath.h ĿٽƣFeatureFastMathĬϹرգʹ׼ͬľȷ㷨
+static bool fast_math_enabled = false;
+
+// ѯӰͼǰѱطƳľͳԴƳľ룬λ
+const float SHADOW_NORMAL_OFFSET = 1.5f;
+const float SHADOW_LIGHT_OFFSET = 1.0f;
+
+// ƽԶƽ wͶӰĽƽ桢Զƽͬ
+const float NEAR_W = 0.1f;
+const float FAR_W = 100.0f;
+
+// ֱӳǣȣ
+static const float FIELD_OF_VIEW = (45.0f * atan(1.0f) * 4) / 180;
+
+// üռԸüƽλãClipFlagsguard_band Ǳ NDC еİ
+static inline uint8_t ComputeClipFlags(const Vec4& p, float guard_band)
+{
+	uint8_t flags = 0;
+	if (p.x < -p.w) flags |= ClipLeft;
+	if (p.x > p.w) flags |= ClipRight;
+	if (p.y < -p.w) flags |= ClipBottom;
+	if (p.y > p.w) flags |= ClipTop;
+	if (p.w < NEAR_W) flags |= ClipNear;
+	if (p.z > p.w) flags |= ClipFar;
+	if (std::fabs(p.x) > guard_band * p.w) flags |= ClipGuardX;
+	if (std::fabs(p.y) > guard_band * p.w) flags |= ClipGuardY;
+	return flags;
+}
+
+// 8 ǵ㶼ͬһƽʱΧκζɼнǵ㶼κƽʱΧ׶
+FrustumCoverage ClassifyBox(const Vec3& bounds_min, const Vec3& bounds_max, const Mat4& mvp)
+{
+	uint8_t outside_all = ClipFrustum;
+	uint8_t outside_any = 0;
+	for (int i = 0; i < 8; i++)
+	{
+		Vec3 corner((i & 1) ? bounds_max.x : bounds_min.x, (i & 2) ? bounds_max.y : bounds_min.y, (i & 4) ? bounds_max.z : bounds_min.z);
+		uint8_t flags = ComputeClipFlags(mvp * corner, FLT_MAX) & ClipFrustum;
+		outside_all &= flags;
+		outside_any |= flags;
+	}
+
+	if (outside_all != 0)
+	{
+		return FrustumOutside;
+	}
+	return outside_any != 0 ? FrustumPartial : FrustumInside;
+}
+
+Mat4 CreateViewProjection(int width, int height, const Camera* camera)
+{
+	Mat4 projection = CreatePerspective(FIELD_OF_VIEW, (float)(width) / (float)(height), NEAR_W, FAR_W);
+	Mat4 view = CreateView(camera->position, camera->target, Vec3(0, 1, 0));
+	return projection * view;
+}
+
+// ðΧĵƵλͶӰĻϵģֵѡ LOD Ǳص
+// ģ;ʱģͿռŷŴ
+int SelectLod(const Model* model, const Mat4& model_mat, int height, const Camera* camera)
+{
+	int lod_count = (int)model->lods.size();
+	if (lod_count <= 1)
+	{
+		return 0;
+	}
+
+	const MeshView& mesh = model->mesh;
+	float scale = 0.0f;
+	for (int i = 0; i < 3; i++)
+	{
+		scale = std::max(scale, length(Vec3(model_mat.m[0][i], model_mat.m[1][i], model_mat.m[2][i])));
+	}
+
+	Vec3 center = model_mat * ((mesh.bounds_min + mesh.bounds_max) * 0.5f);
+	float radius = length(mesh.bounds_max - mesh.bounds_min) * 0.5f * scale;
+	float distance = length(center - camera->position) - radius;
+	if (distance <= NEAR_W)
+	{
+		return 0;
+	}
+
+	float pixels_per_unit = height * 0.5f / tan(FIELD_OF_VIEW * 0.5f) / distance;
+	for (int lod = lod_count - 1; lod > 0; lod--)
+	{
+		if (model->lods[lod].error * scale * pixels_per_unit <= lod_error_pixels)
+		{
+			return lod;
+		}
+	}
+	return 0;
+}
+
+// һԴǵĴأĻֿľ [x0, x1] x [y0, y1] Ȳ [z0, z1]x0 > x1 ʾκδ
+struct ClusterRange
+{
+	int x0, x1, y0, y1, z0, z1;
+};
+
+// Դ׶󽻣ȷΧĵӿռȼӼ뾶ĻΧȡİΧ 8 ǵͶӰľ
+// ǵܵƽʱͶӰɿֱӸĻ
+static ClusterRange LightClusterRange(const LightClusters& clusters, const Light& light, const Mat4& view_projection, bool culling)
+{
+	ClusterRange range = { 0, clusters.tiles_x - 1, 0, clusters.tiles_y - 1, 0, clusters.slices - 1 };
+	if (!culling || light.type != LightType::Point || light.range == FLT_MAX)
+	{
+		return range;
+	}
+
+	float r = light.range;
+	float depth = dot(light.position - clusters.camera_pos, clusters.forward);
+	if (r <= 0.0f || depth + r < NEAR_W || depth - r > FAR_W)
+	{
+		range.x0 = 1;
+		range.x1 = 0;
+		return range;
+	}
+	range.z0 = clusters.Slice(depth - r);
+	range.z1 = clusters.Slice(depth + r);
+
+	if (depth - r * 1.7320508f <= NEAR_W)
+	{
+		return range;
+	}
+
+	float x_min = FLT_MAX, x_max = -FLT_MAX, y_min = FLT_MAX, y_max = -FLT_MAX;
+	for (int i = 0; i < 8; i++)
+	{
+		Vec3 corner = light.position + Vec3((i & 1) ? r : -r, (i & 2) ? r : -r, (i & 4) ? r : -r);
+		Vec4 clip = view_projection * corner;
+		float x = (clip.x / clip.w + 1.0f) * 0.5f * clusters.width;
+		float y = (1.0f - clip.y / clip.w) * 0.5f * clusters.height;
+		x_min = std::min(x_min, x);
+		x_max = std::max(x_max, x);
+		y_min = std::min(y_min, y);
+		y_max = std::max(y_max, y);
+	}
+
+	if (x_max < 0 || y_max < 0 || x_min >= clusters.width || y_min >= clusters.height)
+	{
+		range.x0 = 1;
+		range.x1 = 0;
+		return range;
+	}
+	range.x0 = std::max((int)x_min, 0) / clusters.tile_size;
+	range.x1 = std::min((int)x_max, clusters.width - 1) / clusters.tile_size;
+	range.y0 = std::max((int)y_min, 0) / clusters.tile_size;
+	range.y1 = std::min((int)y_max, clusters.height - 1) / clusters.tile_size;
+	return range;
+}
+
+// ǰ͹ԴؽԴأһͳÿصĹԴǰ׺͵õÿص㣬ڶ鰴Դ˳±
+// 鶼һ֡Դʱڴ
+static void BuildLightClusters(LightClusters& clusters, int width, int height, const Camera* camera, const std::vector<Light>& lights, bool culling)
+{
+	PROFILE_SCOPE("Light Clusters");
+
+	clusters.width = width;
+	clusters.height = height;
+	clusters.camera_pos = camera->position;
+	clusters.forward = normalize(camera->target - camera->position);
+	clusters.tile_size = culling ? CLUSTER_TILE_SIZE : std::max(width, height);
+	clusters.tiles_x = (width + clusters.tile_size - 1) / clusters.tile_size;
+	clusters.tiles_y = (height + clusters.tile_size - 1) / clusters.tile_size;
+	clusters.slices = culling ? CLUSTER_SLICES : 1;
+	clusters.slice_scale = clusters.slices / std::log2(FAR_W / NEAR_W);
+	clusters.slice_bias = -std::log2(NEAR_W) * clusters.slice_scale;
+
+	int cluster_count = clusters.tiles_x * clusters.tiles_y * clusters.slices;
+	clusters.offsets.assign(cluster_count + 1, 0);
+
+	static std::vector<ClusterRange> ranges;
+	static std::vector<uint32_t> cursor;
+	ranges.resize(lights.size());
+
+	Mat4 view_projection = CreateViewProjection(width, height, camera);
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		const ClusterRange& r = ranges[i] = LightClusterRange(clusters, lights[i], view_projection, culling);
+		for (int z = r.z0; z <= r.z1 && r.x0 <= r.x1; z++)
+		{
+			for (int y = r.y0; y <= r.y1; y++)
+			{
+				int row = (z * clusters.tiles_y + y) * clusters.tiles_x;
+				for (int x = r.x0; x <= r.x1; x++)
+				{
+					clusters.offsets[row + x + 1]++;
+				}
+			}
+		}
+	}
+
+	for (int i = 0; i < cluster_count; i++)
+	{
+		clusters.offsets[i + 1] += clusters.offsets[i];
+	}
+	clusters.indices.resize(clusters.offsets[cluster_count]);
+	cursor.assign(clusters.offsets.begin(), clusters.offsets.end() - 1);
+
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		const ClusterRange& r = ranges[i];
+		for (int z = r.z0; z <= r.z1 && r.x0 <= r.x1; z++)
+		{
+			for (int y = r.y0; y <= r.y1; y++)
+			{
+				int row = (z * clusters.tiles_y + y) * clusters.tiles_x;
+				for (int x = r.x0; x <= r.x1; x++)
+				{
+					clusters.indices[cursor[row + x]++] = (uint32_t)i;
+				}
+			}
+		}
+	}
+}
+
+// ִֻõԴ͡λúð뾶⼸ûͲؽɫǿȵı仯Ѿӳð뾶
+static bool SameClusterLight(const Light& a, const Light& b)
+{
+	return a.type == b.type && a.range == b.range &&
+		a.position.x == b.position.x && a.position.y == b.position.y && a.position.z == b.position.z;
+}
+
+// ĻС͹ԴûʱһεĽͬһ֡ڵĶ Render  ResolveDeferred ֻؽһ
+static void UpdateLightClusters(int width, int height, const Camera* camera, const std::vector<Light>& lights)
+{
+	static std::vector<Light> built_lights;
+	static Vec3 built_position, built_target;
+	static bool built_culling = false;
+	static bool built = false;
+
+	const Vec3& p = camera->position;
+	const Vec3& t = camera->target;
+	if (built && built_culling == light_culling_enabled && light_clusters.width == width && light_clusters.height == height &&
+		p.x == built_position.x && p.y == built_position.y && p.z == built_position.z &&
+		t.x == built_target.x && t.y == built_target.y && t.z == built_target.z &&
+		std::equal(lights.begin(), lights.end(), built_lights.begin(), built_lights.end(), SameClusterLight))
+	{
+		return;
+	}
+
+	BuildLightClusters(light_clusters, width, height, camera, lights, light_culling_enabled);
+	built_lights.assign(lights.begin(), lights.end());
+	built_position = p;
+	built_target = t;
+	built_culling = light_culling_enabled;
+	built = true;
+}
+
+// ӰͼǰһԴȾĲʹãûе UpdateShadowMaps ߹رӰʱӰ
+static const ShadowMap* ActiveShadowMaps(const std::vector<Light>& lights)
+{
+	if (!shadow_mapping_enabled || lights.empty() || shadow_maps.size() != lights.size())
+	{
+		return NULL;
+	}
+	return shadow_maps.data();
+}
+
+// ޹صɫԣЩ͵ĹԴûйԴӰͼǷʹÿѧ
+static int SceneFeatures(const std::vector<Light>& lights, const ShadowMap* shadows)
+{
+	int features = fast_math_enabled ? FeatureFastMath : 0;
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		features |= lights[i].type == LightType::Directional ? FeatureDirectional : FeaturePoint;
+		if (shadows != NULL && shadows[i].faces > 0)
+		{
+			features |= FeatureShadows;
+		}
+	}
+	return features;
+}
+
+int SelectShaderFeatures(const SurfaceMaterial& surface, const std::vector<Light>& lights)
+{
+	return surface.Features() | SceneFeatures(lights, ActiveShadowMaps(lights));
+}
+
+// һüƽеĲ֣Sutherland-Hodgmandistance Ƕ㵽ƽ룬>= 0 Ϊڲ
+// 㻹ڲüռУλúǰ varying_count Բֵ
+template <typename Distance>
+static int ClipPolygon(const ClipVertex* in, int count, ClipVertex* out, int varying_count, Distance distance)
+{
+	int n = 0;
+	for (int i = 0; i < count; i++)
+	{
+		const ClipVertex& a = in[i];
+		const ClipVertex& b = in[(i + 1) % count];
+		float da = distance(a);
+		float db = distance(b);
+		if (da >= 0)
+		{
+			out[n++] = a;
+		}
+		if ((da >= 0) != (db >= 0))
+		{
+			out[n++] = ClipVertex::lerp(a, b, da / (da - db), varying_count);
+		}
+	}
+	return n;
+}
+
+// ν˻κͰ cull_mode Ҫ޳ֱӶµֵͬ׷ӵбĩβ
+// ı棨CullNone  CullFront ʱѷ߷ӱ濴Ҳһɫͼûз
+static void SubmitTriangle(const Triangle& tri, const float* varyings, int varying_count, CullMode cull_mode, RenderStats& stats)
+{
+	TriangleSetup setup;
+	SetupResult result = SetupTriangle(tri, varying_count > 0 ? varyings : NULL, cull_mode, setup);
+	if (result == SetupCulled)
+	{
+		stats.triangles_backface_culled++;
+	}
+	else if (result != SetupDegenerate)
+	{
+		triangles.push_back(tri);
+		setups.push_back(setup);
+
+		size_t offset = triangle_varyings.size();
+		triangle_varyings.insert(triangle_varyings.end(), varyings, varyings + varying_count * 3);
+		if (result == SetupBackFacing && varying_count > VaryingNormalZ)
+		{
+			for (int i = VaryingNormalX * 3; i < (VaryingNormalZ + 1) * 3; i++)
+			{
+				triangle_varyings[offset + i] *= -1.0f;
+			}
+		}
+	}
+}
+
+// üһΣýƽͳıƽü͹Σβ
+// üֶĻƷ򣬲ԭγͬ޳ĽܲüӰ
+// Ҫüκ٣ SoA չ𶥵 ClipVertexд SoA
+static void ClipTriangle(const Triangle& in_tri, const float* in_varyings, int varying_count, uint8_t flags, float guard_band, int width, int height, CullMode cull_mode, RenderStats& stats)
+{
+	// ÿƽһ
+	ClipVertex polygon[2][9];
+	int count = 3;
+	int current = 0;
+	for (int j = 0; j < 3; j++)
+	{
+		ClipVertex& v = polygon[0][j];
+		v.x = in_tri.x[j];
+		v.y = in_tri.y[j];
+		v.z = in_tri.z[j];
+		v.w = in_tri.w[j];
+		for (int i = 0; i < varying_count; i++)
+		{
+			v.varying[i] = in_varyings[i * 3 + j];
+		}
+	}
+
+	auto clip = [&](auto distance)
+	{
+		count = ClipPolygon(polygon[current], count, polygon[current ^ 1], varying_count, distance);
+		current ^= 1;
+	};
+
+	if (flags & ClipNear)
+	{
+		clip([](const ClipVertex& v) { return v.w - NEAR_W; });
+	}
+	if (flags & ClipGuardX)
+	{
+		clip([=](const ClipVertex& v) { return guard_band * v.w - v.x; });
+		clip([=](const ClipVertex& v) { return guard_band * v.w + v.x; });
+	}
+	if (flags & ClipGuardY)
+	{
+		clip([=](const ClipVertex& v) { return guard_band * v.w - v.y; });
+		clip([=](const ClipVertex& v) { return guard_band * v.w + v.y; });
+	}
+
+	for (int k = 1; k + 1 < count; k++)
+	{
+		const ClipVertex* fan[3] = { &polygon[current][0], &polygon[current][k], &polygon[current][k + 1] };
+		Triangle tri;
+		float varyings[VARYING_MAX * 3];
+		for (int j = 0; j < 3; j++)
+		{
+			tri.x[j] = fan[j]->x;
+			tri.y[j] = fan[j]->y;
+			tri.z[j] = fan[j]->z;
+			tri.w[j] = fan[j]->w;
+			for (int i = 0; i < varying_count; i++)
+			{
+				varyings[i * 3 + j] = fan[j]->varying[i];
+			}
+		}
+		TransformToScreen(tri, width, height);
+		SubmitTriangle(tri, varyings, varying_count, cull_mode, stats);
+	}
+}
+
+// дβֵд slot ʼk Ƕ
+static inline void StoreVarying(float* varyings, int slot, int k, const Vec3& v)
+{
+	varyings[slot * 3 + k] = v.x;
+	varyings[(slot + 1) * 3 + k] = v.y;
+	varyings[(slot + 2) * 3 + k] = v.z;
+}
+
+// װΣȡ任棬޳׶Σƽ棨Ҫʱбü任Ļռ
+// ޳νУͶӰжϣҪռķ
+// ֻȡǰ varying_count ֵԣͼvarying_count Ϊ 0ֻλ
+static void CullAndClipTriangles(const MeshView& mesh, int width, int height, float guard_band, int varying_count, CullMode cull_mode, RenderStats& stats)
+{
+	PROFILE_SCOPE("Cull & Clip");
+
+	// 
+	int face_count = mesh.index_count / 3;
+	for (int i = 0; i < face_count; i++)
+	{
+		const uint32_t* face = &mesh.indices[i * 3];
+
+		// ׶ͬһƽ࣬κμ
+		uint8_t f0 = vertex_cache.clip_flags[face[0]];
+		uint8_t f1 = vertex_cache.clip_flags[face[1]];
+		uint8_t f2 = vertex_cache.clip_flags[face[2]];
+		if (frustum_culling_enabled && (f0 & f1 & f2 & ClipFrustum) != 0)
+		{
+			stats.triangles_frustum_culled++;
+			continue;
+		}
+
+		// 㴦׶Ѿ mvp 任
+		Triangle tri;
+		int in_n = 0;
+		for (int j = 0; j < 3; j++)
+		{
+			const Vec4& pos_clip = vertex_cache.clip_pos[face[j]];
+			tri.x[j] = pos_clip.x;
+			tri.y[j] = pos_clip.y;
+			tri.z[j] = pos_clip.z;
+			tri.w[j] = pos_clip.w;
+
+			//  w ж϶Ƿڽƽڲ
+			in_n += pos_clip.w >= NEAR_W;
+		}
+
+		if (in_n == 0)
+		{
+			continue;// ڽƽ棨ر׶޳ʱŻߵ
+		}
+
+		// ȡòԲҲ
+		float varyings[VARYING_MAX * 3];
+		if (varying_count >= VARYINGS_SURFACE)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				const Vec2& texcoord = mesh.vertices[face[j]].texcoord;
+				varyings[VaryingU * 3 + j] = texcoord.x;
+				varyings[VaryingV * 3 + j] = texcoord.y;
+				StoreVarying(varyings, VaryingWorldX, j, vertex_cache.world_pos[face[j]]);
+				StoreVarying(varyings, VaryingNormalX, j, vertex_cache.world_normal[face[j]]);
+			}
+		}
+		if (varying_count >= VARYINGS_TANGENT_FRAME)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				StoreVarying(varyings, VaryingTangentX, j, vertex_cache.world_tangent[face[j]]);
+				StoreVarying(varyings, VaryingBitangentX, j, vertex_cache.world_bitangent[face[j]]);
+			}
+		}
+
+		// κ٣ͨĴΣͽƽһ𰴶βü
+		if (frustum_culling_enabled && ((f0 | f1 | f2) & (ClipGuardX | ClipGuardY)) != 0)
+		{
+			stats.triangles_guard_clipped++;
+			ClipTriangle(tri, varyings, varying_count, f0 | f1 | f2, guard_band, width, height, cull_mode, stats);
+		}
+		else if (in_n == 3)
+		{
+			// 㶼棬ֱӻƳ
+			TransformToScreen(tri, width, height);
+			SubmitTriangle(tri, varyings, varying_count, cull_mode, stats);
+		}
+		else
+		{
+			// һʱóһСΣʱóһıΣ
+			if (in_n == 1)
+			{
+				stats.triangles_clipped_one++;
+			}
+			else
+			{
+				stats.triangles_clipped_two++;
+			}
+			ClipTriangle(tri, varyings, varying_count, ClipNear, guard_band, width, height, cull_mode, stats);
+		}
+	}
+}
+
+void Render(int width, int height, Model* model, Mat4 model_mat, Texture* texture, Camera* camera, Texture* normal_map, Uint32* frame_buffer, vector<float>& z_buffer, Material material, std::vector<Light>& lights, CullMode cull_mode)
+{
+	PROFILE_SCOPE("Render");
+
+	// mvp
+	Mat4 mvp = CreateViewProjection(width, height, camera) * model_mat;
+
+	TileScheduler& scheduler = TileScheduler::Instance();
+	if ((int)worker_stats.size() < scheduler.WorkerCount())
+	{
+		worker_stats.resize(scheduler.WorkerCount());
+	}
+	RenderStats& main_stats = worker_stats[0].stats;//  Render ߳̾ 0 ߳
+
+	// ģ׶⣺任㣬ҲռӳɫĲʱ
+	if (frustum_culling_enabled && ClassifyBox(model->mesh.bounds_min, model->mesh.bounds_max, mvp) == FrustumOutside)
+	{
+		main_stats.models_culled++;
+		return;
+	}
+
+	// ԽԶѡԽֵ񣬺Ķ㴦װ䶼ֻһ
+	int lod = lod_enabled ? SelectLod(model, model_mat, height, camera) : 0;
+	const MeshView& mesh = model->lods[lod];
+	main_stats.triangles_lod_skipped += (model->mesh.index_count - mesh.index_count) / 3;
+
+	// ֻԴ仯ؽͬһ֡ Render ֱ
+	UpdateLightClusters(width, height, camera, lights);
+
+	// NDC  [-guard_band, guard_band] ķΧ任Ļ󲻳դ귶Χ
+	float guard_band = SCREEN_COORD_LIMIT / std::max(width, height);
+
+	triangles.clear();
+	setups.clear();
+	triangle_varyings.clear();
+
+	DrawContext ctx;
+	ctx.width = width;
+	ctx.height = height;
+	ctx.camera = camera;
+	ctx.frame_buffer = frame_buffer;
+	ctx.z_buffer = z_buffer.data();
+	ctx.lights = &lights;
+	ctx.clusters = &light_clusters;
+	ctx.shadows = ActiveShadowMaps(lights);
+	ctx.surface = { material, texture, normal_map, texture_filter };
+	ctx.gbuffer = NULL;
+	ctx.material_id = 0;
+
+	if (deferred_enabled)
+	{
+		if (gbuffer.width != width || gbuffer.height != height)
+		{
+			gbuffer.Resize(width, height);
+		}
+
+		//  ID  16 λţʱ˾ȰеıɫıḲǵ
+		if (deferred_materials.size() >= 0xffff)
+		{
+			ResolveDeferred(width, height, camera, frame_buffer, lights);
+		}
+
+		deferred_materials.push_back(ctx.surface);
+		ctx.gbuffer = &gbuffer;
+		ctx.material_id = (uint16_t)deferred_materials.size();
+	}
+
+	// ʺ͹ԴѡһιդصѭﲻжЩԣν׶ֻд G-Buffer޹
+	ctx.features = ctx.gbuffer != NULL ? FeatureGBuffer | (ctx.surface.Features() & (FeatureDiffuseMap | FeatureNormalMap)) : SelectShaderFeatures(ctx.surface, lights);
+	int selected = shader_specialization_enabled ? ctx.features : SHADER_DYNAMIC;
+	ctx.rasterize_block = simd_enabled ? SelectRasterizeBlockSSE41(selected) : SelectRasterizeBlock(selected);
+
+	// õĲֵԣ㴦ü͹դֻЩ
+	int varying_count = ctx.surface.VaryingCount();
+
+	// 㴦ģ͵ÿֻ任һΣֱȡý
+	TransformVertices(mesh, model_mat, mvp, guard_band, varying_count, vertex_cache);
+
+	// ׶޳ƽͱü任ĻռΣͬʱ޳
+	CullAndClipTriangles(mesh, width, height, guard_band, varying_count, cull_mode, main_stats);
+
+	// 䣺ѲüΰΧзŽǵĻֿ
+	int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+	int tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+	BinTriangles(triangles, tiles_x, tiles_y, width, height, tile_bins);
+
+	// ÿֻֿᱻһ̴ֿ֮߳زص֡Ȼ嶼Ҫ
+	// ֿڲ԰ύ˳ΣԽ뵥߳ȫһ
+	main_stats.triangles_submitted += triangles.size();
+
+	// úÿȶ 1ܲ޳֮Źդս
+	// ؿ鰴 blocks_x Уȱ˵ֿûʱҲҪãᰴоɵ
+	int blocks_x = (width + RASTER_BLOCK_SIZE - 1) / RASTER_BLOCK_SIZE;
+	int blocks_y = (height + RASTER_BLOCK_SIZE - 1) / RASTER_BLOCK_SIZE;
+	if (hiz_enabled && (!hiz_valid || hiz_z_buffer != ctx.z_buffer || hiz.tiles_x != tiles_x || hiz.tiles_y != tiles_y || hiz.blocks_x != blocks_x || hiz.blocks_y != blocks_y))
+	{
+		hiz.Resize(width, height, RASTER_BLOCK_SIZE, TILE_SIZE);
+		hiz_z_buffer = ctx.z_buffer;
+	}
+	// ر Hi-Z ʱդٴʱ
+	hiz_valid = hiz_enabled;
+	HiZBuffer* hiz_buffer = hiz_enabled ? &hiz : NULL;
+
+	scheduler.Run(tiles_x * tiles_y, [&](int t, int worker)
+	{
+		PROFILE_SCOPE("Rasterize Tile");
+		RenderStats& stats = worker_stats[worker].stats;
+		int tx = t % tiles_x;
+		int ty = t / tiles_x;
+
+		Tile tile;
+		tile.x0 = tx * TILE_SIZE;
+		tile.y0 = ty * TILE_SIZE;
+		tile.x1 = std::min(tile.x0 + TILE_SIZE, width) - 1;
+		tile.y1 = std::min(tile.y0 + TILE_SIZE, height) - 1;
+
+		for (uint32_t i = tile_bins.offsets[t]; i < tile_bins.offsets[t + 1]; i++)
+		{
+			int index = tile_bins.indices[i];
+
+			// ȱȷֿԶȻԶֿȫס
+			if (hiz_buffer != NULL && setups[index].min_z > hiz.tile_max[t])
+			{
+				stats.triangles_occluded++;
+				continue;
+			}
+
+			RasterizeTriangle(triangles[index], triangle_varyings.data() + (size_t)index * varying_count * 3, setups[index], tile, ctx, hiz_buffer, stats);
+		}
+	});
+}
+
+// 任ߡߣֻþϽǵ 3x3 ֣ƽӰ
+static inline Vec3 TransformDirection(const Mat4& m, const Vec3& d)
+{
+	return Vec3(m.m[0][0] * d.x + m.m[0][1] * d.y + m.m[0][2] * d.z,
+				m.m[1][0] * d.x + m.m[1][1] * d.y + m.m[1][2] * d.z,
+				m.m[2][0] * d.x + m.m[2][1] * d.y + m.m[2][2] * d.z);
+}
+
+void TransformVertices(const MeshView& mesh, const Mat4& model_mat, const Mat4& mvp, float guard_band, int varying_count, VertexCache& cache)
+{
+	PROFILE_SCOPE("Transform Vertices");
+	int count = mesh.vertex_count;
+	bool tangent_frame = varying_count >= VARYINGS_TANGENT_FRAME;
+
+	// resize Сͬһģÿ֡·ڴ
+	cache.clip_pos.resize(count);
+	cache.world_pos.resize(count);
+	cache.world_normal.resize(count);
+	if (tangent_frame)
+	{
+		cache.world_tangent.resize(count);
+		cache.world_bitangent.resize(count);
+	}
+	cache.clip_flags.resize(count);
+
+	int batches = (count + VERTEX_BATCH_SIZE - 1) / VERTEX_BATCH_SIZE;
+
+	TileScheduler& scheduler = TileScheduler::Instance();
+	if ((int)worker_stats.size() < scheduler.WorkerCount())
+	{
+		worker_stats.resize(scheduler.WorkerCount());
+	}
+
+	scheduler.Run(batches, [&](int batch, int worker)
+	{
+		int begin = batch * VERTEX_BATCH_SIZE;
+		int end = std::min(begin + VERTEX_BATCH_SIZE, count);
+
+		for (int i = begin; i < end; i++)
+		{
+			const MeshVertex& v = mesh.vertices[i];
+			cache.clip_pos[i] = mvp * v.position;
+			cache.clip_flags[i] = ComputeClipFlags(cache.clip_pos[i], guard_band);
+			cache.world_pos[i] = model_mat * v.position;
+			Vec3 N = normalize(TransformDirection(model_mat, v.normal));
+			cache.world_normal[i] = N;
+			if (tangent_frame)
+			{
+				Vec3 T = normalize(TransformDirection(model_mat, Vec3(v.tangent)));
+				cache.world_tangent[i] = T;
+				cache.world_bitangent[i] = cross(N, T) * v.tangent.w;
+			}
+		}
+
+		worker_stats[worker].stats.vertices_transformed += end - begin;
+	});
+}
+
+// ͼĶ㴦ֻ任üռꡢ ClipFlagsҪꡢߺ
+static void TransformPositions(const MeshView& mesh, const Mat4& mvp, float guard_band, VertexCache& cache)
+{
+	PROFILE_SCOPE("Transform Positions");
+	int count = mesh.vertex_count;
+	cache.clip_pos.resize(count);
+	cache.clip_flags.resize(count);
+
+	int batches = (count + VERTEX_BATCH_SIZE - 1) / VERTEX_BATCH_SIZE;
+	TileScheduler::Instance().Run(batches, [&](int batch, int worker)
+	{
+		int begin = batch * VERTEX_BATCH_SIZE;
+		int end = std::min(begin + VERTEX_BATCH_SIZE, count);
+
+		for (int i = begin; i < end; i++)
+		{
+			cache.clip_pos[i] = mvp * mesh.vertices[i].position;
+			cache.clip_flags[i] = ComputeClipFlags(cache.clip_pos[i], guard_band);
+		}
+
+		shadow_worker_stats[worker].stats.vertices_transformed += end - begin;
+	});
+}
+
+// һͶ߻ͼһ棺üνͷֿ Render ͬդֻд
+// Ӱͼԭʼѡõ LOD ޹
+static void RenderDepth(const ShadowCaster& caster, const Mat4& view_projection, float* depth, int size)
+{
+	const MeshView& mesh = caster.model->mesh;
+	Mat4 mvp = view_projection * caster.model_mat;
+	float guard_band = SCREEN_COORD_LIMIT / size;
+	RenderStats& main_stats = shadow_worker_stats[0].stats;
+
+	triangles.clear();
+	setups.clear();
+	triangle_varyings.clear();
+
+	TransformPositions(mesh, mvp, guard_band, vertex_cache);
+	CullAndClipTriangles(mesh, size, size, guard_band, 0, caster.cull_mode, main_stats);
+
+	int tiles = (size + TILE_SIZE - 1) / TILE_SIZE;
+	BinTriangles(triangles, tiles, tiles, size, size, tile_bins);
+	main_stats.triangles_submitted += triangles.size();
+
+	TileScheduler::Instance().Run(tiles * tiles, [&](int t, int worker)
+	{
+		PROFILE_SCOPE("Rasterize Shadow Tile");
+		Tile tile;
+		tile.x0 = (t % tiles) * TILE_SIZE;
+		tile.y0 = (t / tiles) * TILE_SIZE;
+		tile.x1 = std::min(tile.x0 + TILE_SIZE, size) - 1;
+		tile.y1 = std::min(tile.y0 + TILE_SIZE, size) - 1;
+
+		for (uint32_t i = tile_bins.offsets[t]; i < tile_bins.offsets[t + 1]; i++)
+		{
+			int index = tile_bins.indices[i];
+			RasterizeTriangleDepth(triangles[index], setups[index], tile, depth, size, shadow_worker_stats[worker].stats);
+		}
+	});
+}
+
+// ͼ 6 ߷Ϸ˳ +X-X+Y-Y+Z-Z
+static const Vec3 CUBE_FACE_FORWARD[6] = { Vec3(1, 0, 0), Vec3(-1, 0, 0), Vec3(0, 1, 0), Vec3(0, -1, 0), Vec3(0, 0, 1), Vec3(0, 0, -1) };
+static const Vec3 CUBE_FACE_UP[6] = { Vec3(0, 1, 0), Vec3(0, 1, 0), Vec3(0, 0, 1), Vec3(0, 0, 1), Vec3(0, 1, 0), Vec3(0, 1, 0) };
+
+// ӹԴָ d ķͼĸϣֵķ
+static int CubeFace(const Vec3& d)
+{
+	float ax = std::fabs(d.x), ay = std::fabs(d.y), az = std::fabs(d.z);
+	if (ax >= ay && ax >= az)
+	{
+		return d.x >= 0.0f ? 0 : 1;
+	}
+	if (ay >= az)
+	{
+		return d.y >= 0.0f ? 2 : 3;
+	}
+	return d.z >= 0.0f ? 4 : 5;
+}
+
+// ƽй⣺Ͷ߰ΧеعշģͶӰķΧȡΧ 8 ǵڹԴӿռеķΧ
+static void SetupDirectionalShadow(ShadowMap& map, const Light& light, const Vec3& bounds_min, const Vec3& bounds_max)
+{
+	Vec3 center = (bounds_min + bounds_max) * 0.5f;
+	float radius = length(bounds_max - bounds_min) * 0.5f;
+	Vec3 up = std::fabs(light.direction.y) > 0.99f ? Vec3(1, 0, 0) : Vec3(0, 1, 0);
+	Mat4 view = CreateView(center - light.direction * (radius + 1.0f), center, up);
+
+	Vec3 view_min(FLT_MAX, FLT_MAX, FLT_MAX), view_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (int i = 0; i < 8; i++)
+	{
+		Vec3 corner((i & 1) ? bounds_max.x : bounds_min.x, (i & 2) ? bounds_max.y : bounds_min.y, (i & 4) ? bounds_max.z : bounds_min.z);
+		Vec3 p = view * corner;
+		view_min = Vec3(std::min(view_min.x, p.x), std::min(view_min.y, p.y), std::min(view_min.z, p.z));
+		view_max = Vec3(std::max(view_max.x, p.x), std::max(view_max.y, p.y), std::max(view_max.z, p.z));
+	}
+
+	// ߷ -zƽԶƽһŰΧеβᱻõ
+	float margin = radius * 0.01f + 0.01f;
+	Mat4 projection = CreateOrthographic(view_min.x, view_max.x, view_min.y, view_max.y, -view_max.z - margin, -view_min.z + margin);
+	map.view_projection[0] = projection * view;
+	map.texel_scale = std::max(view_max.x - view_min.x, view_max.y - view_min.y) / map.size;
+}
+
+// Դ6  90 ӳǵ͸ͶӰԶƽȡð뾶ͶԶĽǵнϽһȵľȸ
+static void SetupPointShadow(ShadowMap& map, const Light& light, const Vec3& bounds_min, const Vec3& bounds_max)
+{
+	float farthest = 0.0f;
+	for (int i = 0; i < 8; i++)
+	{
+		Vec3 corner((i & 1) ? bounds_max.x : bounds_min.x, (i & 2) ? bounds_max.y : bounds_min.y, (i & 4) ? bounds_max.z : bounds_min.z);
+		farthest = std::max(farthest, length(corner - light.position));
+	}
+	float far_w = std::max(std::min(light.range, farthest), NEAR_W * 2.0f);
+
+	Mat4 projection = CreatePerspective(2.0f * atan(1.0f), 1.0f, NEAR_W, far_w);
+	for (int face = 0; face < 6; face++)
+	{
+		map.view_projection[face] = projection * CreateView(light.position, light.position + CUBE_FACE_FORWARD[face], CUBE_FACE_UP[face]);
+	}
+	map.texel_scale = 2.0f / map.size;
+}
+
+static bool SameCasters(const std::vector<ShadowCaster>& a, const std::vector<ShadowCaster>& b)
+{
+	if (a.size() != b.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (a[i].model != b[i].model || a[i].cull_mode != b[i].cull_mode || memcmp(&a[i].model_mat, &b[i].model_mat, sizeof(Mat4)) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// ӰͼֻȡڹԴ͡ͼСƽй⣩λúð뾶ԴɫǿȺ˥ϵ˲ػ
+static bool SameShadowLight(const Light& a, const Light& b)
+{
+	return a.type == b.type && a.shadow_size == b.shadow_size && a.range == b.range &&
+		a.direction.x == b.direction.x && a.direction.y == b.direction.y && a.direction.z == b.direction.z &&
+		a.position.x == b.position.x && a.position.y == b.position.y && a.position.z == b.position.z;
+}
+
+ShadowStats UpdateShadowMaps(const std::vector<ShadowCaster>& casters, const std::vector<Light>& lights)
+{
+	ShadowStats result;
+	if (!shadow_mapping_enabled)
+	{
+		return result;
+	}
+
+	PROFILE_SCOPE("Shadow Maps");
+
+	// κһͶƶеӰͼҪػassign һε
+	bool casters_changed = !SameCasters(casters, shadow_casters);
+	if (casters_changed)
+	{
+		shadow_casters.assign(casters.begin(), casters.end());
+	}
+
+	Vec3 bounds_min(FLT_MAX, FLT_MAX, FLT_MAX), bounds_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (const ShadowCaster& caster : casters)
+	{
+		bounds_min = Vec3(std::min(bounds_min.x, caster.bounds_min.x), std::min(bounds_min.y, caster.bounds_min.y), std::min(bounds_min.z, caster.bounds_min.z));
+		bounds_max = Vec3(std::max(bounds_max.x, caster.bounds_max.x), std::max(bounds_max.y, caster.bounds_max.y), std::max(bounds_max.z, caster.bounds_max.z));
+	}
+
+	TileScheduler& scheduler = TileScheduler::Instance();
+	if ((int)shadow_worker_stats.size() < scheduler.WorkerCount())
+	{
+		shadow_worker_stats.resize(scheduler.WorkerCount());
+	}
+
+	shadow_maps.resize(lights.size());
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		const Light& light = lights[i];
+		ShadowMap& map = shadow_maps[i];
+		map.pcf = shadow_pcf_enabled;
+
+		if (light.shadow_size <= 0 || casters.empty())
+		{
+			map.faces = 0;
+			map.valid = false;
+			continue;
+		}
+
+		if (shadow_cache_enabled && map.valid && !casters_changed && SameShadowLight(map.light, light))
+		{
+			result.maps_cached++;
+			continue;
+		}
+
+		map.light = light;
+		map.size = light.shadow_size;
+		map.faces = light.type == LightType::Directional ? 1 : 6;
+		map.depth.resize((size_t)map.faces * map.size * map.size);
+		std::fill(map.depth.begin(), map.depth.end(), 1.0f);
+
+		if (light.type == LightType::Directional)
+		{
+			SetupDirectionalShadow(map, light, bounds_min, bounds_max);
+		}
+		else
+		{
+			SetupPointShadow(map, light, bounds_min, bounds_max);
+		}
+
+		for (int face = 0; face < map.faces; face++)
+		{
+			for (const ShadowCaster& caster : casters)
+			{
+				// ԴÿֻܿΧһͶ
+				if (frustum_culling_enabled && ClassifyBox(caster.bounds_min, caster.bounds_max, map.view_projection[face]) == FrustumOutside)
+				{
+					result.casters_culled++;
+					continue;
+				}
+				RenderDepth(caster, map.view_projection[face], map.Face(face), map.size);
+			}
+			result.faces_rendered++;
+		}
+
+		map.valid = true;
+		result.maps_rendered++;
+	}
+
+	for (auto& w : shadow_worker_stats)
+	{
+		result.vertices_transformed += w.stats.vertices_transformed;
+		result.triangles_submitted += w.stats.triangles_submitted;
+		result.pixels_tested += w.stats.pixels_tested;
+		result.pixels_written += w.stats.pixels_depth_passed;
+		w.stats = RenderStats();
+	}
+
+	return result;
+}
+
+float ShadowVisibility(const ShadowMap& map, const Vec3& world_pos, const Vec3& N)
+{
+	const Light& light = map.light;
+
+	// ԽҪƳľԽ󣻵ԴشС뵽Դľ
+	Vec3 L;
+	float texel = map.texel_scale;
+	if (light.type == LightType::Directional)
+	{
+		L = light.direction * -1.0f;
+	}
+	else
+	{
+		Vec3 light_vector = light.position - world_pos;
+		float distance = length(light_vector);
+		L = light_vector * (1.0f / std::max(distance, 1e-6f));
+		texel *= distance;
+	}
+	Vec3 p = world_pos + N * (texel * SHADOW_NORMAL_OFFSET) + L * (texel * SHADOW_LIGHT_OFFSET);
+
+	int face = light.type == LightType::Directional ? 0 : CubeFace(p - light.position);
+	Vec4 clip = map.view_projection[face] * p;
+	if (clip.w <= 0.0f)
+	{
+		return 1.0f;
+	}
+
+	// ͼΧı棨κͶߵİΧ߱Զƽ滹Զᱻס
+	float inv_w = 1.0f / clip.w;
+	float nx = clip.x * inv_w, ny = clip.y * inv_w, nz = clip.z * inv_w;
+	if (nz >= 1.0f || std::fabs(nx) > 1.0f || std::fabs(ny) > 1.0f)
+	{
+		return 1.0f;
+	}
+
+	//  (i, j)  (i + 0.5, j + 0.5)դʱһ
+	int size = map.size;
+	const float* depth = map.Face(face);
+	float sx = (nx + 1.0f) * 0.5f * size - 0.5f;
+	float sy = (1.0f - ny) * 0.5f * size - 0.5f;
+	auto lit = [&](int x, int y)
+	{
+		x = std::clamp(x, 0, size - 1);
+		y = std::clamp(y, 0, size - 1);
+		return nz <= depth[y * size + x] ? 1.0f : 0.0f;
+	};
+
+	if (!map.pcf)
+	{
+		return lit((int)std::floor(sx + 0.5f), (int)std::floor(sy + 0.5f));
+	}
+
+	//  (sx, sy) Ϊġһص 3x3 ˫ԱȽȡƽȼ 4x4 ذ (1 - f, 1, 1, f) / 3 ֱȨ
+	int x0 = (int)std::floor(sx);
+	int y0 = (int)std::floor(sy);
+	float fx = sx - x0;
+	float fy = sy - y0;
+	const float wx[4] = { 1.0f - fx, 1.0f, 1.0f, fx };
+	const float wy[4] = { 1.0f - fy, 1.0f, 1.0f, fy };
+
+	float sum = 0.0f;
+	for (int j = 0; j < 4; j++)
+	{
+		float row = 0.0f;
+		for (int i = 0; i < 4; i++)
+		{
+			row += wx[i] * lit(x0 - 1 + i, y0 - 1 + j);
+		}
+		sum += wy[j] * row;
+	}
+	return sum * (1.0f / 9.0f);
+}
+
+// 򣺵һÿֿǰ׺͵õ㣬ڶ鰴ύ˳±
+void BinTriangles(const std::vector<Triangle>& tris, int tiles_x, int tiles_y, int width, int height, TileBins& bins)
+{
+	PROFILE_SCOPE("Bin Triangles");
+
+	// assign  resize еֻзֿ±ǰֵʱŷ
+	int tile_count = tiles_x * tiles_y;
+	bins.offsets.assign(tile_count + 1, 0);
+
+	for (int i = 0; i < (int)tris.size(); i++)
+	{
+		Tile box = TriangleBounds(tris[i], width, height);
+		if (box.x0 > box.x1 || box.y0 > box.y1)
+		{
+			continue;// ȫĻ
+		}
+
+		for (int ty = box.y0 / TILE_SIZE; ty <= box.y1 / TILE_SIZE; ty++)
+		{
+			for (int tx = box.x0 / TILE_SIZE; tx <= box.x1 / TILE_SIZE; tx++)
+			{
+				bins.offsets[ty * tiles_x + tx + 1]++;
+			}
+		}
+	}
+
+	for (int t = 0; t < tile_count; t++)
+	{
+		bins.offsets[t + 1] += bins.offsets[t];
+	}
+
+	// ÿζһ֮֡Ϊ˼·
+	uint32_t total = bins.offsets[tile_count];
+	if (bins.indices.capacity() < total)
+	{
+		bins.indices.reserve(total + total / 2);
+	}
+	bins.indices.resize(total);
+
+	//  offsets[t] Ϊ t ֿдλãָһֿ㣬һλ
+	for (int i = 0; i < (int)tris.size(); i++)
+	{
+		Tile box = TriangleBounds(tris[i], width, height);
+		if (box.x0 > box.x1 || box.y0 > box.y1)
+		{
+			continue;
+		}
+
+		for (int ty = box.y0 / TILE_SIZE; ty <= box.y1 / TILE_SIZE; ty++)
+		{
+			for (int tx = box.x0 / TILE_SIZE; tx <= box.x1 / TILE_SIZE; tx++)
+			{
+				bins.indices[bins.offsets[ty * tiles_x + tx]++] = i;
+			}
+		}
+	}
+
+	for (int t = tile_count; t > 0; t--)
+	{
+		bins.offsets[t] = bins.offsets[t - 1];
+	}
+	bins.offsets[0] = 0;
+}
+
+RenderStats CollectRenderStats()
+{
+	RenderStats total;
+	for (auto& w : worker_stats)
+	{
+		total += w.stats;
+		w.stats = RenderStats();
+	}
+
+	return total;
+}
+
+void SetSIMDEnabled(bool enabled)
+{
+	simd_enabled = enabled && CpuSupportsSSE41();
+}
+
+bool IsSIMDEnabled()
+{
+	return simd_enabled;
+}
+
+void SetHiZEnabled(bool enabled)
+{
+	hiz_enabled = enabled;
+}
+
+bool IsHiZEnabled()
+{
+	return hiz_enabled;
+}
+
+void ClearDepth(std::vector<float>& z_buffer)
+{
+	std::fill(z_buffer.begin(), z_buffer.end(), 1.0f);
+	hiz_valid = false;
+}
+
+void InvalidateHiZ()
+{
+	hiz_valid = false;
+}
+
+void SetTextureFilter(TextureFilter filter)
+{
+	texture_filter = filter;
+}
+
+TextureFilter GetTextureFilter()
+{
+	return texture_filter;
+}
+
+void SetFrustumCullingEnabled(bool enabled)
+{
+	frustum_culling_enabled = enabled;
+}
+
+bool IsFrustumCullingEnabled()
+{
+	return frustum_culling_enabled;
+}
+
+void SetLodEnabled(bool enabled)
+{
+	lod_enabled = enabled;
+}
+
+bool IsLodEnabled()
+{
+	return lod_enabled;
+}
+
+void SetLodErrorPixels(float pixels)
+{
+	lod_error_pixels = pixels;
+}
+
+float GetLodErrorPixels()
+{
+	return lod_error_pixels;
+}
+
+const char* CullModeName(CullMode cull_mode)
+{
+	switch (cull_mode)
+	{
+	case CullBack: return "back";
+	case CullFront: return "front";
+	case CullNone: return "none";
+	}
+	return "unknown";
+}
+
+void SetLightCullingEnabled(bool enabled)
+{
+	light_culling_enabled = enabled;
+}
+
+bool IsLightCullingEnabled()
+{
+	return light_culling_enabled;
+}
+
+void SetShadowMappingEnabled(bool enabled)
+{
+	shadow_mapping_enabled = enabled;
+}
+
+bool IsShadowMappingEnabled()
+{
+	return shadow_mapping_enabled;
+}
+
+void SetShadowPCFEnabled(bool enabled)
+{
+	shadow_pcf_enabled = enabled;
+}
+
+bool IsShadowPCFEnabled()
+{
+	return shadow_pcf_enabled;
+}
 
-void Render(int width, int height, Model* model, Mat4 model_mat, SDL_Surface* texture, Camera* camera, SDL_Surface* normal_map, Uint32* frame_buffer, vector<float>& z_buffer, Material material, std::vector<Light>& lights)
+void SetShadowCacheEnabled(bool enabled)
 {
-	// mvp
-	Mat4 projection = CreatePerspective((45.0f * atan(1.0f) * 4) / 180, (float)(width) / (float)(height), 0.1f, 100.0f);
-	Mat4 view = CreateView(camera->position, camera->target, Vec3(0, 1, 0));
-	Mat4 mvp = projection * view * model_mat;
+	shadow_cache_enabled = enabled;
+}
 
-	// 
-	for (int i = 0; i < model->nfaces(); i++)
-	{
-		Face face = model->face(i);
+bool IsShadowCacheEnabled()
+{
+	return shadow_cache_enabled;
+}
+
+void SetShaderSpecializationEnabled(bool enabled)
+{
+	shader_specialization_enabled = enabled;
+}
+
+bool IsShaderSpecializationEnabled()
+{
+	return shader_specialization_enabled;
+}
+
+void SetFastMathEnabled(bool enabled)
+{
+	fast_math_enabled = enabled;
+}
+
+bool IsFastMathEnabled()
+{
+	return fast_math_enabled;
+}
+
+void SetDeferredEnabled(bool enabled)
+{
+	deferred_enabled = enabled;
+}
 
-		// ηڱ޳
-		Vec3 v[3];
-		v[0] = model->vert(face.v[0]);
-		v[1] = model->vert(face.v[1]);
-		v[2] = model->vert(face.v[2]);
+bool IsDeferredEnabled()
+{
+	return deferred_enabled;
+}
 
-		Vec3 world_v[3];
-		world_v[0] = model_mat * v[0];
-		world_v[1] = model_mat * v[1];
-		world_v[2] = model_mat * v[2];
+void ResolveDeferred(int width, int height, Camera* camera, Uint32* frame_buffer, std::vector<Light>& lights)
+{
+	if (deferred_materials.empty() || gbuffer.width != width || gbuffer.height != height)
+	{
+		return;
+	}
 
-		Vec3 edge1 = world_v[1] - world_v[0];
-		Vec3 edge2 = world_v[2] - world_v[0];
-		Vec3 normal = normalize(cross(edge1, edge2));
+	PROFILE_SCOPE("Deferred Resolve");
+	UpdateLightClusters(width, height, camera, lights);
+	const ShadowMap* shadows = ActiveShadowMaps(lights);
+	int scene_features = shader_specialization_enabled ? SceneFeatures(lights, shadows) : SHADER_DYNAMIC;
 
-		Vec3 view_dir = normalize((world_v[0] - camera->position));
-		float intensity = dot(normal, view_dir);
+	// ÿɼֻɫһΣɫֻĻСйأȻ޹
+	// ֮以зָ̳߳
+	TileScheduler& scheduler = TileScheduler::Instance();
+	if ((int)worker_stats.size() < scheduler.WorkerCount())
+	{
+		worker_stats.resize(scheduler.WorkerCount());
+	}
 
-		if (intensity >= 0)
+	scheduler.Run(height, [&](int y, int worker)
+	{
+		RenderStats& stats = worker_stats[worker].stats;
+		if (simd_enabled)
 		{
-			continue;
+			ResolveRowSSE41(gbuffer, deferred_materials, y, camera->position, lights, shadows, scene_features, light_clusters, frame_buffer, stats);
+		}
+		else
+		{
+			ResolveRow(gbuffer, deferred_materials, y, camera->position, lights, shadows, scene_features, light_clusters, frame_buffer, stats);
 		}
+	});
+
+	deferred_materials.clear();
+}
+
+void RasterizeTriangle(const Triangle& tri, const float* varyings, const TriangleSetup& setup, const Tile& tile, const DrawContext& ctx, HiZBuffer* hiz, RenderStats& stats)
+{
+	int width = ctx.width, height = ctx.height;
+	const float* z_buffer = ctx.z_buffer;
 
-		// ƽü
-		Vertex verts[3];
-		Vertex* inside_verts[3];
-		Vertex* outside_verts[3];
-		int in_n = 0, out_n = 0;
+	// ΰΧ뵱ǰֿ󽻣ֻƷֿڵ
+	Tile box = TriangleBounds(tri, width, height);
+	int x_min = std::max(box.x0, tile.x0);
+	int x_max = std::min(box.x1, tile.x1);
+	int y_min = std::max(box.y0, tile.y0);
+	int y_max = std::min(box.y1, tile.y1);
 
-		// ε
-		for (int j = 0; j < 3; j++)
+	if (x_min > x_max || y_min > y_max)
+	{
+		return;
+	}
+
+	// Render ɫѡõĹդCPU ֧ʱ 4 زе SSE4.1 ںˣдȵ
+	auto shade_rect = [&](const Tile& rect, bool full)
+	{
+		int written = ctx.rasterize_block(tri, varyings, setup, rect, full, ctx, stats);
+		stats.pixels_depth_passed += written;
+		return written;
+	};
+
+	// СεİΧвһؿ飬û壬ֱعդ
+	if (x_max - x_min < RASTER_BLOCK_SIZE && y_max - y_min < RASTER_BLOCK_SIZE)
+	{
+		Tile rect = { x_min, y_min, x_max, y_max };
+		if (shade_rect(rect, false) > 0 && hiz != NULL)
 		{
-			// Ӧmvp任תƵĻ
-			Vec4 pos_clip = mvp * v[j];
+			UpdateHiZ(*hiz, z_buffer, width, height, rect);
+		}
+		return;
+	}
 
-			verts[j].position.x = pos_clip.x;
-			verts[j].position.y = pos_clip.y;
-			verts[j].position.z = pos_clip.z;
+	// ֹդĻ 8x8 ؿ࣬ȫĿֱȫڵĿ鲻ǲ
+	for (int by = y_min - y_min % RASTER_BLOCK_SIZE; by <= y_max; by += RASTER_BLOCK_SIZE)
+	{
+		for (int bx = x_min - x_min % RASTER_BLOCK_SIZE; bx <= x_max; bx += RASTER_BLOCK_SIZE)
+		{
+			Tile block;
+			block.x0 = std::max(bx, x_min);
+			block.y0 = std::max(by, y_min);
+			block.x1 = std::min(bx + RASTER_BLOCK_SIZE - 1, x_max);
+			block.y1 = std::min(by + RASTER_BLOCK_SIZE - 1, y_max);
+
+			BlockCoverage coverage = ClassifyBlock(setup, block);
+			if (coverage == BlockOutside)
+			{
+				PROFILE_COUNT(stats.blocks_rejected, 1);
+				continue;
+			}
 
-			// ȡ
-			verts[j].texcoord = Vec2(model->vertTex(face.vt[j]));
-			verts[j].normal = normalize(Vec3(model_mat * model->vertNor(face.vn[j])));
-			verts[j].world_pos = world_v[j];
-			verts[j].pos_clip_w = pos_clip.w;
-			//verts[j].color = Vec3(1.0f, 1.0f, 1.0f) * dot(normalize(model->vertNor(face.vn[j])), normalize(light_dir * -1.0f));// ͨ Gouraud Shading 
+			// ȶȿеԶȻԶ鶼ᱻס
+			if (hiz != NULL && BlockMinDepth(tri, setup, block) > hiz->block_max[(by / RASTER_BLOCK_SIZE) * hiz->blocks_x + bx / RASTER_BLOCK_SIZE])
+			{
+				PROFILE_COUNT(stats.blocks_occluded, 1);
+				continue;
+			}
 
-			//  w ж϶ǷҰ
-			if (pos_clip.w >= 0.1f)
+			bool full = coverage == BlockInside;
+			if (full)
 			{
-				inside_verts[in_n++] = &verts[j];
+				PROFILE_COUNT(stats.blocks_accepted, 1);
 			}
 			else
 			{
-				outside_verts[out_n++] = &verts[j];
+				PROFILE_COUNT(stats.blocks_partial, 1);
 			}
 
+			if (shade_rect(block, full) > 0 && hiz != NULL)
+			{
+				UpdateHiZ(*hiz, z_buffer, width, height, block);
+			}
 		}
+	}
+}
+
+float BlockMinDepth(const Triangle& tri, const TriangleSetup& setup, const Tile& block)
+{
+	// ĻռԵģϽǵȣټ xy ı仯
+	float z = ((float)setup.edge[0].Evaluate(block.x0, block.y0) * tri.z[0] +
+			   (float)setup.edge[1].Evaluate(block.x0, block.y0) * tri.z[1] +
+			   (float)setup.edge[2].Evaluate(block.x0, block.y0) * tri.z[2]) * setup.inv_area;
+
+	float dx = setup.z_dx * (block.x1 - block.x0);
+	float dy = setup.z_dy * (block.y1 - block.y0);
+	float min_z = z + std::min(dx, 0.0f) + std::min(dy, 0.0f);
+
+	// Ľǿ棬ƳȲȸ
+	return std::max(min_z, setup.min_z);
+}
+
+void UpdateHiZ(HiZBuffer& hiz, const float* z_buffer, int width, int height, const Tile& rect)
+{
+	// rect һĻֿ֮
+	int tx = rect.x0 / TILE_SIZE;
+	int ty = rect.y0 / TILE_SIZE;
+	float tile_max = hiz.tile_max[ty * hiz.tiles_x + tx];
+	bool tile_dirty = false;
 
-		if (in_n == 3)
+	for (int by = rect.y0 / RASTER_BLOCK_SIZE; by <= rect.y1 / RASTER_BLOCK_SIZE; by++)
+	{
+		for (int bx = rect.x0 / RASTER_BLOCK_SIZE; bx <= rect.x1 / RASTER_BLOCK_SIZE; bx++)
 		{
-			// 㶼棬ֱӻƳ
-			Triangle tri;
-			tri.v[0] = *inside_verts[0];
-			tri.v[1] = *inside_verts[1];
-			tri.v[2] = *inside_verts[2];
-			TransformToScreen(tri, width, height);
-			RasterizeTriangle(tri, width, height, texture, camera, normal_map, frame_buffer, z_buffer, material, lights);
+			int x_end = std::min((bx + 1) * RASTER_BLOCK_SIZE, width);
+			int y_end = std::min((by + 1) * RASTER_BLOCK_SIZE, height);
+
+			float max_z = -FLT_MAX;
+			for (int y = by * RASTER_BLOCK_SIZE; y < y_end; y++)
+			{
+				for (int x = bx * RASTER_BLOCK_SIZE; x < x_end; x++)
+				{
+					max_z = std::max(max_z, z_buffer[y * width + x]);
+				}
+			}
+
+			// ֻԭֵֿؿСˣֵֿҪ¼
+			float& block_max = hiz.block_max[by * hiz.blocks_x + bx];
+			if (block_max >= tile_max && max_z < block_max)
+			{
+				tile_dirty = true;
+			}
+			block_max = max_z;
 		}
-		else if(in_n == 1)
+	}
+
+	if (tile_dirty)
+	{
+		UpdateHiZTile(hiz, tx, ty);
+	}
+}
+
+void UpdateHiZTile(HiZBuffer& hiz, int tx, int ty)
+{
+	const int blocks_per_tile = TILE_SIZE / RASTER_BLOCK_SIZE;
+	int bx_end = std::min((tx + 1) * blocks_per_tile, hiz.blocks_x);
+	int by_end = std::min((ty + 1) * blocks_per_tile, hiz.blocks_y);
+
+	float max_z = -FLT_MAX;
+	for (int by = ty * blocks_per_tile; by < by_end; by++)
+	{
+		for (int bx = tx * blocks_per_tile; bx < bx_end; bx++)
 		{
-			// ֻһ棬һС
-			Triangle new_tri;
-			new_tri.v[0] = *inside_verts[0];
-			new_tri.v[1] = intersect(*inside_verts[0], *outside_verts[0]);
-			new_tri.v[2] = intersect(*inside_verts[0], *outside_verts[1]);
-			TransformToScreen(new_tri, width, height);
-			RasterizeTriangle(new_tri, width, height, texture, camera, normal_map, frame_buffer, z_buffer, material, lights);
+			max_z = std::max(max_z, hiz.block_max[by * hiz.blocks_x + bx]);
 		}
-		else if (in_n == 2)
-		{
-			// 棬
-			Vertex A = intersect(*inside_verts[0], *outside_verts[0]);
-			Vertex B = intersect(*inside_verts[1], *outside_verts[0]);
+	}
+
+	hiz.tile_max[ty * hiz.tiles_x + tx] = max_z;
+}
 
-			Triangle tri1, tri2;
+BlockCoverage ClassifyBlock(const TriangleSetup& setup, const Tile& block)
+{
+	bool inside = true;
 
-			tri1.v[0] = *inside_verts[0]; tri1.v[1] = *inside_verts[1]; tri1.v[2] = A;
-			tri2.v[0] = *inside_verts[1]; tri2.v[1] = B; tri2.v[2] = A;
+	for (const auto& e : setup.edge)
+	{
+		// ߺԵģڵֵСֵһڿĽ
+		int64_t corner = e.Evaluate(block.x0, block.y0);
+		int64_t dx = e.StepX() * (block.x1 - block.x0);
+		int64_t dy = e.StepY() * (block.y1 - block.y0);
+		int64_t max_value = corner + std::max<int64_t>(dx, 0) + std::max<int64_t>(dy, 0);
+		int64_t min_value = corner + std::min<int64_t>(dx, 0) + std::min<int64_t>(dy, 0);
+
+		if (!e.Inside(max_value))
+		{
+			return BlockOutside;// 鶼
+		}
 
-			TransformToScreen(tri1, width, height);
-			TransformToScreen(tri2, width, height);
-			RasterizeTriangle(tri1, width, height, texture, camera, normal_map, frame_buffer, z_buffer, material, lights);
-			RasterizeTriangle(tri2, width, height, texture, camera, normal_map, frame_buffer, z_buffer, material, lights);
+		if (!e.Inside(min_value))
+		{
+			inside = false;
 		}
 	}
+
+	return inside ? BlockInside : BlockPartial;
 }
 
-void RasterizeTriangle(const Triangle& tri, int width, int height, SDL_Surface* texture, Camera* camera, SDL_Surface* normal_map, Uint32* frame_buffer, vector<float>& z_buffer, Material material, std::vector<Light>& lights)
-{
-	// ҵܿεС
-	int x_min = (int)std::floor(std::min({ tri.v[0].position.x,tri.v[1].position.x, tri.v[2].position.x }));
-	int x_max = (int)std::ceil(std::max({ tri.v[0].position.x,tri.v[1].position.x, tri.v[2].position.x }));
-	int y_min = (int)std::floor(std::min({ tri.v[0].position.y,tri.v[1].position.y, tri.v[2].position.y }));
-	int y_max = (int)std::ceil(std::max({ tri.v[0].position.y,tri.v[1].position.y, tri.v[2].position.y }));
+// һͼ Blinn-Phong գǰȾӳɫĹս׶ιãlod  TextureLod
+// TB ǲֵߺ͸ߣֻзͼʱʹãֻ light_indices еĹԴڴصĹԴб
+// shadows  lights һһӦӰͼΪ NULL ʱӰFEATURES ɫϣShaderFeature
+template <int FEATURES>
+static Vec3 ShadePixel(const SurfaceMaterial& surface, const Vec3& world_pos, float u, float v, float lod, const Vec3& N, const Vec3& T, const Vec3& B, const Vec3& camera_pos, const std::vector<Light>& lights, const ShadowMap* shadows, const uint32_t* light_indices, int light_count);
 
-	// ȡʱܻ΢Ҫǯһ
-	x_min = std::max(0, x_min);
-	x_max = std::min(width - 1, x_max);
-	y_min = std::max(0, y_min);
-	y_max = std::min(height - 1, y_max);
+// դһؿ飬ÿɫ FEATURES ʵһݣ SelectRasterizeBlock ѡ
+template <int FEATURES>
+static int RasterizeBlock(const Triangle& tri, const float* varyings, const TriangleSetup& setup, const Tile& block, bool full, const DrawContext& ctx, RenderStats& stats)
+{
+	int written = 0;
+	int width = ctx.width;
+	float* z_buffer = ctx.z_buffer;
+
+	int x_min = block.x0, x_max = block.x1;
+	int y_min = block.y0, y_max = block.y1;
+
+	const EdgeEquation& e0 = setup.edge[0];
+	const EdgeEquation& e1 = setup.edge[1];
+	const EdgeEquation& e2 = setup.edge[2];
+
+	// ֻһαߺ֮ءжֻӷ
+	int64_t row0 = e0.Evaluate(x_min, y_min);
+	int64_t row1 = e1.Evaluate(x_min, y_min);
+	int64_t row2 = e2.Evaluate(x_min, y_min);
+
+	int64_t step_x0 = e0.StepX(), step_x1 = e1.StepX(), step_x2 = e2.StepX();
+	int64_t step_y0 = e0.StepY(), step_y1 = e1.StepY(), step_y2 = e2.StepY();
+
+	// ûͼʱҪ lodûзͼʱҪߣҲûдߣ
+	bool has_texture = ShaderHas<FEATURES>(FeatureDiffuseMap | FeatureNormalMap, ctx.surface.SampleCount() > 0);
+	bool has_normal_map = ShaderHas<FEATURES>(FeatureNormalMap, ctx.surface.normal_map != NULL);
+	bool write_gbuffer = ShaderHas<FEATURES>(FeatureGBuffer, ctx.gbuffer != NULL);
+
+	// ÿԷϵֵ
+	const float* tex_u = varyings + VaryingU * 3;
+	const float* tex_v = varyings + VaryingV * 3;
+	const float* world_x = varyings + VaryingWorldX * 3;
+	const float* world_y = varyings + VaryingWorldY * 3;
+	const float* world_z = varyings + VaryingWorldZ * 3;
+	const float* inv_w = tri.inv_w;
 
 	// С
-	for (int y = y_min; y <= y_max; y++)
+	for (int y = y_min; y <= y_max; y++, row0 += step_y0, row1 += step_y1, row2 += step_y2)
 	{
-		for (int x = x_min; x <= x_max; x++)
-		{
-			// ص
-			Vec3 curPoint((float)x + 0.5f, (float)y + 0.5f, 0.0f);
-			Vec3 barycentric = ComputeBarycentric(curPoint, tri.v[0].position, tri.v[1].position, tri.v[2].position);
+		int64_t w0 = row0, w1 = row1, w2 = row2;
 
-			// 0ʱ
-			if (barycentric.x >= 0.0f && barycentric.y >= 0.0f && barycentric.z >= 0.0f)
+		for (int x = x_min; x <= x_max; x++, w0 += step_x0, w1 += step_x1, w2 += step_x2)
+		{
+			// ߺڲࣨϹϵأʱڣ鶼ڲʱٲ
+			if (full || (e0.Inside(w0) && e1.Inside(w1) && e2.Inside(w2)))
 			{
+				// ߺֵΪ
+				Vec3 barycentric((float)w0 * setup.inv_area, (float)w1 * setup.inv_area, (float)w2 * setup.inv_area);
+
 				// ֵвֵȲ
 				int index = y * width + x;
-				float z = tri.v[0].position.z * barycentric.x + tri.v[1].position.z * barycentric.y + tri.v[2].position.z * barycentric.z;
+				float z = tri.z[0] * barycentric.x + tri.z[1] * barycentric.y + tri.z[2] * barycentric.z;
+				PROFILE_COUNT(stats.pixels_tested, 1);
 				if (z < z_buffer[index])
 				{
 					z_buffer[index] = z;
+					written++;
 				}
 				else
 				{
@@ -155,194 +1587,520 @@ void RasterizeTriangle(const Triangle& tri, int width, int height, SDL_Surface*
 				}
 
 				// ͸ӽֵ͸ԭ uv 
-				float interpolated_u_over_w = (tri.v[0].texcoord.x * tri.v[0].inv_w) * barycentric.x +
-											  (tri.v[1].texcoord.x * tri.v[1].inv_w) * barycentric.y +
-											  (tri.v[2].texcoord.x * tri.v[2].inv_w) * barycentric.z;
+				float interpolated_u_over_w = (tex_u[0] * inv_w[0]) * barycentric.x +
+											  (tex_u[1] * inv_w[1]) * barycentric.y +
+											  (tex_u[2] * inv_w[2]) * barycentric.z;
 
-				float interpolated_v_over_w = (tri.v[0].texcoord.y * tri.v[0].inv_w) * barycentric.x +
-											  (tri.v[1].texcoord.y * tri.v[1].inv_w) * barycentric.y +
-											  (tri.v[2].texcoord.y * tri.v[2].inv_w) * barycentric.z;
+				float interpolated_v_over_w = (tex_v[0] * inv_w[0]) * barycentric.x +
+											  (tex_v[1] * inv_w[1]) * barycentric.y +
+											  (tex_v[2] * inv_w[2]) * barycentric.z;
 
-				float interpolated_inv_w = tri.v[0].inv_w * barycentric.x +
-										   tri.v[1].inv_w * barycentric.y +
-										   tri.v[2].inv_w * barycentric.z;
+				float interpolated_inv_w = inv_w[0] * barycentric.x +
+										   inv_w[1] * barycentric.y +
+										   inv_w[2] * barycentric.z;
 
 				float true_u = interpolated_u_over_w / interpolated_inv_w;
 				float true_v = interpolated_v_over_w / interpolated_inv_w;
 
+				// u = (u/w) / (1/w) x 󵼵 du/dx = (d(u/w)/dx - u * d(1/w)/dx) / (1/w)y ͬ
+				//  GPU  2x2 ֵĽ൱ÿص
+				float lod = 0.0f;
+				if (has_texture)
+				{
+					float w = 1.0f / interpolated_inv_w;
+					lod = TextureLod((setup.uw_dx - true_u * setup.inv_w_dx) * w, (setup.vw_dx - true_v * setup.inv_w_dx) * w,
+									 (setup.uw_dy - true_u * setup.inv_w_dy) * w, (setup.vw_dy - true_v * setup.inv_w_dy) * w);
+				}
+
 				// 
-				float interp_pixel_x = (tri.v[0].world_pos.x * tri.v[0].inv_w) * barycentric.x +
-									   (tri.v[1].world_pos.x * tri.v[1].inv_w) * barycentric.y +
-									   (tri.v[2].world_pos.x * tri.v[2].inv_w) * barycentric.z;
+				float interp_pixel_x = (world_x[0] * inv_w[0]) * barycentric.x +
+									   (world_x[1] * inv_w[1]) * barycentric.y +
+									   (world_x[2] * inv_w[2]) * barycentric.z;
 
-				float interp_pixel_y = (tri.v[0].world_pos.y * tri.v[0].inv_w) * barycentric.x +
-									   (tri.v[1].world_pos.y * tri.v[1].inv_w) * barycentric.y +
-									   (tri.v[2].world_pos.y * tri.v[2].inv_w) * barycentric.z;
+				float interp_pixel_y = (world_y[0] * inv_w[0]) * barycentric.x +
+									   (world_y[1] * inv_w[1]) * barycentric.y +
+									   (world_y[2] * inv_w[2]) * barycentric.z;
 
-				float interp_pixel_z = (tri.v[0].world_pos.z * tri.v[0].inv_w) * barycentric.x +
-									   (tri.v[1].world_pos.z * tri.v[1].inv_w) * barycentric.y +
-									   (tri.v[2].world_pos.z * tri.v[2].inv_w) * barycentric.z;
+				float interp_pixel_z = (world_z[0] * inv_w[0]) * barycentric.x +
+									   (world_z[1] * inv_w[1]) * barycentric.y +
+									   (world_z[2] * inv_w[2]) * barycentric.z;
 
 				Vec3 pixel_world_pos(interp_pixel_x / interpolated_inv_w, interp_pixel_y / interpolated_inv_w, interp_pixel_z / interpolated_inv_w);
 
-				// ȡͼ
-				Vec3 texColor;
-				if (texture != NULL)
+				// ֵ
+				Vec3 N = normalize(VaryingVec3(varyings, VaryingNormalX, 0) * barycentric.x +
+					VaryingVec3(varyings, VaryingNormalX, 1) * barycentric.y +
+					VaryingVec3(varyings, VaryingNormalX, 2) * barycentric.z);
+
+				// ֵߺ͸ߣ뷨һĻռֵ ShadePixel Ŷķͳһһ
+				Vec3 T, B;
+				if (has_normal_map)
 				{
-					texColor = GetPixelFromSurface(texture, true_u, true_v);
+					T = VaryingVec3(varyings, VaryingTangentX, 0) * barycentric.x + VaryingVec3(varyings, VaryingTangentX, 1) * barycentric.y + VaryingVec3(varyings, VaryingTangentX, 2) * barycentric.z;
+					B = VaryingVec3(varyings, VaryingBitangentX, 0) * barycentric.x + VaryingVec3(varyings, VaryingBitangentX, 1) * barycentric.y + VaryingVec3(varyings, VaryingBitangentX, 2) * barycentric.z;
 				}
-				else
+
+				// ӳɫֻ¼ԣθʱ˷ѹռ
+				if (write_gbuffer)
 				{
-					int check = (int)(floor(true_u * 10.0f)) + (int)(floor(true_v * 10.0f));
-					texColor = (check % 2 == 0) ? Vec3(0.2f, 0.2f, 0.2f) : Vec3(0.3f, 0.3f, 0.3f);
+					ctx.gbuffer->Write(index, pixel_world_pos, true_u, true_v, lod, N, ctx.material_id);
+					if (has_normal_map)
+					{
+						ctx.gbuffer->WriteTangentFrame(index, T, B);
+					}
+					continue;
 				}
 
-				// Ϲģ
-				
-				// 
-				Vec3 ambient = Vec3(1, 1, 1) * material.ambient;
+				int cluster = ctx.clusters->Cluster(x, y, pixel_world_pos);
+				int light_count = ctx.clusters->LightCount(cluster);
+				PROFILE_COUNT(stats.pixels_shaded, 1);
+				PROFILE_COUNT(stats.texture_samples, ctx.surface.SampleCount());
+				PROFILE_COUNT(stats.pixel_lights, light_count);
+				Vec3 final_color = ShadePixel<FEATURES == SHADER_DYNAMIC ? SHADER_DYNAMIC : (FEATURES & ~FeatureGBuffer)>(ctx.surface, pixel_world_pos, true_u, true_v, lod, N, T, B,
+					ctx.camera->position, *ctx.lights, ctx.shadows, ctx.clusters->Lights(cluster), light_count);
+				ctx.frame_buffer[index] = Vec3ToUint32(final_color);
+			}
+		}
+	}
+
+	return written;
+}
 
-				// 㷨ͼ
-				Vec3 normal;
-				Vec3 N = normalize(tri.v[0].normal * barycentric.x +
-					tri.v[1].normal * barycentric.y +
-					tri.v[2].normal * barycentric.z);
+// ÿϵĺǰɫֱȡ±꣬ν׶ΰ FeatureGBuffer ͼλ
+template <int BASE, int... F>
+static constexpr std::array<RasterizeBlockFunc, sizeof...(F)> RasterizeBlockTable(std::integer_sequence<int, F...>)
+{
+	return { { &RasterizeBlock<BASE | F>... } };
+}
 
-				if (normal_map != NULL)
-				{
-					Vec3 worldUp = (abs(N.y) > 0.99f) ? Vec3(0, 0, 1) : Vec3(0, 1, 0);// ֹ T Ĳ˽Ϊ޷ normalize
-					Vec3 T = normalize(cross(worldUp, N));
-					Vec3 B = cross(N, T);
+static constexpr std::array<RasterizeBlockFunc, SHADER_PERMUTATIONS> rasterize_block_table = RasterizeBlockTable<0>(std::make_integer_sequence<int, SHADER_PERMUTATIONS>());
+static constexpr std::array<RasterizeBlockFunc, 4> rasterize_block_gbuffer_table = RasterizeBlockTable<FeatureGBuffer>(std::make_integer_sequence<int, 4>());
 
-					Vec3 normalColor = GetPixelFromSurface(normal_map, true_u, true_v);
-					Vec3 tangentNormal;
-					tangentNormal.x = (normalColor.x * 2.0f) - 1.0f;
-					tangentNormal.y = (normalColor.y * 2.0f) - 1.0f;
-					tangentNormal.z = (normalColor.z * 2.0f) - 1.0f;
+RasterizeBlockFunc SelectRasterizeBlock(int features)
+{
+	if (features == SHADER_DYNAMIC)
+	{
+		return &RasterizeBlock<SHADER_DYNAMIC>;
+	}
+	if (features & FeatureGBuffer)
+	{
+		return rasterize_block_gbuffer_table[features & (FeatureDiffuseMap | FeatureNormalMap)];
+	}
+	return rasterize_block_table[features];
+}
 
-					normal = normalize(T * tangentNormal.x + B * tangentNormal.y + N * tangentNormal.z);
-				}
-				else
+void RasterizeTriangleDepth(const Triangle& tri, const TriangleSetup& setup, const Tile& tile, float* depth, int size, RenderStats& stats)
+{
+	Tile box = TriangleBounds(tri, size, size);
+	int x_min = std::max(box.x0, tile.x0);
+	int x_max = std::min(box.x1, tile.x1);
+	int y_min = std::max(box.y0, tile.y0);
+	int y_max = std::min(box.y1, tile.y1);
+
+	if (x_min > x_max || y_min > y_max)
+	{
+		return;
+	}
+
+	//  RasterizeTriangle ͬСֱأȰ 8x8 ؿַ
+	if (x_max - x_min < RASTER_BLOCK_SIZE && y_max - y_min < RASTER_BLOCK_SIZE)
+	{
+		Tile rect = { x_min, y_min, x_max, y_max };
+		stats.pixels_depth_passed += RasterizeBlockDepth(tri, setup, rect, false, depth, size, stats);
+		return;
+	}
+
+	for (int by = y_min - y_min % RASTER_BLOCK_SIZE; by <= y_max; by += RASTER_BLOCK_SIZE)
+	{
+		for (int bx = x_min - x_min % RASTER_BLOCK_SIZE; bx <= x_max; bx += RASTER_BLOCK_SIZE)
+		{
+			Tile block;
+			block.x0 = std::max(bx, x_min);
+			block.y0 = std::max(by, y_min);
+			block.x1 = std::min(bx + RASTER_BLOCK_SIZE - 1, x_max);
+			block.y1 = std::min(by + RASTER_BLOCK_SIZE - 1, y_max);
+
+			BlockCoverage coverage = ClassifyBlock(setup, block);
+			if (coverage == BlockOutside)
+			{
+				PROFILE_COUNT(stats.blocks_rejected, 1);
+				continue;
+			}
+
+			bool full = coverage == BlockInside;
+			if (full)
+			{
+				PROFILE_COUNT(stats.blocks_accepted, 1);
+			}
+			else
+			{
+				PROFILE_COUNT(stats.blocks_partial, 1);
+			}
+			stats.pixels_depth_passed += RasterizeBlockDepth(tri, setup, block, full, depth, size, stats);
+		}
+	}
+}
+
+int RasterizeBlockDepth(const Triangle& tri, const TriangleSetup& setup, const Tile& block, bool full, float* depth, int size, RenderStats& stats)
+{
+	int written = 0;
+
+	const EdgeEquation& e0 = setup.edge[0];
+	const EdgeEquation& e1 = setup.edge[1];
+	const EdgeEquation& e2 = setup.edge[2];
+
+	int64_t row0 = e0.Evaluate(block.x0, block.y0);
+	int64_t row1 = e1.Evaluate(block.x0, block.y0);
+	int64_t row2 = e2.Evaluate(block.x0, block.y0);
+
+	int64_t step_x0 = e0.StepX(), step_x1 = e1.StepX(), step_x2 = e2.StepX();
+	int64_t step_y0 = e0.StepY(), step_y1 = e1.StepY(), step_y2 = e2.StepY();
+
+	// ĻռԵģֻڿֵһΣ֮ءмҪ
+	float row_z = ((float)row0 * tri.z[0] + (float)row1 * tri.z[1] + (float)row2 * tri.z[2]) * setup.inv_area;
+
+	for (int y = block.y0; y <= block.y1; y++, row0 += step_y0, row1 += step_y1, row2 += step_y2, row_z += setup.z_dy)
+	{
+		int64_t w0 = row0, w1 = row1, w2 = row2;
+		float z = row_z;
+		float* line = depth + y * size;
+
+		for (int x = block.x0; x <= block.x1; x++, w0 += step_x0, w1 += step_x1, w2 += step_x2, z += setup.z_dx)
+		{
+			if (full || (e0.Inside(w0) && e1.Inside(w1) && e2.Inside(w2)))
+			{
+				PROFILE_COUNT(stats.pixels_tested, 1);
+				if (z < line[x])
 				{
-					normal = N;
+					line[x] = z;
+					written++;
 				}
+			}
+		}
+	}
 
-				Vec3 total_diffuse(0, 0, 0);
-				Vec3 total_specular(0, 0, 0);
-				Vec3 V = normalize(camera->position - pixel_world_pos);
+	return written;
+}
 
-				// 
-				float cosTheta = std::clamp(dot(V, N), 0.0f, 1.0f);
-				float F0 = 0.04f;
-				float fresnel = F0 + (1.0f - F0) * std::pow(1.0f - cosTheta, 5.0f);
+template <int FEATURES>
+static Vec3 ShadePixel(const SurfaceMaterial& surface, const Vec3& world_pos, float u, float v, float lod, const Vec3& N, const Vec3& T, const Vec3& B, const Vec3& camera_pos, const std::vector<Light>& lights, const ShadowMap* shadows, const uint32_t* light_indices, int light_count)
+{
+	const Material& material = surface.material;
+	MathAccuracy accuracy = ShaderHas<FEATURES>(FeatureFastMath, fast_math_enabled) ? MathFast : MathExact;
 
-				// йԴ
-				for (const auto& light : lights)
-				{
-					if (light.type == LightType::Directional)
-					{
-						// 
-						float diff = std::max(dot(normal, normalize(light.dir_inv)), 0.0f);
-						total_diffuse = total_diffuse + light.color * (diff * light.intensity * material.diffuse);//float
+	// ȡͼ
+	// ûͼʱ̸
+	Vec3 texColor = ShaderHas<FEATURES>(FeatureDiffuseMap, surface.texture != NULL) ? surface.texture->Sample(u, v, lod, surface.filter) : SampleDiffuse(NULL, u, v, lod, surface.filter);
 
-						// ߹
-						//Vec3 R = normalize(reflect(light.direction, normal));
-						//float spec = std::pow(std::max(dot(R, V), 0.0f), material.shininess);
+	// Ϲģ
 
-						Vec3 H = normalize(light.dir_inv + V);
-						float spec = std::pow(std::max(dot(normal, H), 0.0f), material.shininess * 4.0f);
-						total_specular = total_specular + light.color * (spec * light.intensity * material.specular * fresnel);
-					}
-					else if (light.type == LightType::Point)
-					{
-						// Դ͵ǰصλùϵ
-						Vec3 light_vector = light.position - pixel_world_pos;
-						float distance = length(light_vector);
-						Vec3 L = normalize(light_vector);
-
-						// ˥ϵ
-						float attenuation = 1.0f / (light.Kc + light.Kl * distance + light.Kq * distance * distance);
-
-						// 
-						float diff = std::max(dot(normal, L), 0.0f);
-						total_diffuse = total_diffuse + light.color * (diff * light.intensity * material.diffuse * attenuation);
-
-						// ߹
-						//Vec3 R = normalize(reflect(L * -1.0f, normal));
-						//float spec = std::pow(std::max(dot(R, V), 0.0f), material.shininess);
-						Vec3 H = normalize(L + V);
-						float spec = std::pow(std::max(dot(normal, H), 0.0f), material.shininess * 4.0f);
-						total_specular = total_specular + light.color * (spec * light.intensity * material.specular * attenuation * fresnel);
-					}
+	// 
+	Vec3 ambient = Vec3(1, 1, 1) * material.ambient;
 
-				}
+	// 㷨ͼ߿ռķ߳ TBN 任ռ
+	Vec3 normal;
+	if (ShaderHas<FEATURES>(FeatureNormalMap, surface.normal_map != NULL))
+	{
+		Vec3 normalColor = surface.normal_map->Sample(u, v, lod, surface.filter);
+		Vec3 tangentNormal;
+		tangentNormal.x = (normalColor.x * 2.0f) - 1.0f;
+		tangentNormal.y = (normalColor.y * 2.0f) - 1.0f;
+		tangentNormal.z = (normalColor.z * 2.0f) - 1.0f;
+
+		normal = normalize(T * tangentNormal.x + B * tangentNormal.y + N * tangentNormal.z, accuracy);
+	}
+	else
+	{
+		normal = N;
+	}
+
+	Vec3 total_diffuse(0, 0, 0);
+	Vec3 total_specular(0, 0, 0);
+
+	// ߹ϵΪ 0 Ĳʲ߷򡢷͸߹⣨ػʱճ㣬 0
+	bool specular = ShaderHas<FEATURES>(FeatureSpecular, true);
+	Vec3 V;
+	float fresnel = 0.0f;
+	if (specular)
+	{
+		V = normalize(camera_pos - world_pos, accuracy);
+
+		// 
+		float cosTheta = std::clamp(dot(V, N), 0.0f, 1.0f);
+		fresnel = SchlickFresnel(cosTheta, 0.04f, accuracy);
+	}
+
+	// ֻڴصĹԴûйԴȥ
+	if (!ShaderHas<FEATURES>(FeatureDirectional | FeaturePoint, true))
+	{
+		light_count = 0;
+	}
+	for (int i = 0; i < light_count; i++)
+	{
+		const Light& light = lights[light_indices[i]];
+		const ShadowMap* shadow = ShaderHas<FEATURES>(FeatureShadows, shadows != NULL) && shadows[light_indices[i]].faces > 0 ? &shadows[light_indices[i]] : NULL;
+		if (ShaderIsDirectional<FEATURES>(light))
+		{
+			// סĲְԴǿ
+			float intensity = light.intensity;
+			if (shadow != NULL)
+			{
+				intensity *= ShadowVisibility(*shadow, world_pos, N);
+			}
+
+			// 
+			float diff = std::max(dot(normal, light.dir_inv), 0.0f);
+			total_diffuse = total_diffuse + light.color * (diff * intensity * material.diffuse);//float
+
+			// ߹
+			//Vec3 R = normalize(reflect(light.direction, normal));
+			//float spec = std::pow(std::max(dot(R, V), 0.0f), material.shininess);
+			if (specular)
+			{
+				Vec3 H = normalize(light.dir_inv + V, accuracy);
+				float spec = SpecularPow(std::max(dot(normal, H), 0.0f), material.shininess * 4.0f, accuracy);
+				total_specular = total_specular + light.color * (spec * intensity * material.specular * fresnel);
+			}
+		}
+		else
+		{
+			// Դ͵ǰصλùϵð뾶ĹԴ㣨صķΧ
+			Vec3 light_vector = light.position - world_pos;
+			float distance2 = dot(light_vector, light_vector);
+			if (distance2 > light.range * light.range)
+			{
+				continue;
+			}
+
+			// ٽʱͷһ FastRsqrt
+			float distance;
+			Vec3 L;
+			if (accuracy == MathFast)
+			{
+				float inv_distance = distance2 > 1e-12f ? FastRsqrt(distance2) : 0.0f;
+				distance = distance2 * inv_distance;
+				L = light_vector * inv_distance;
+			}
+			else
+			{
+				distance = length(light_vector);
+				L = normalize(light_vector);
+			}
+
+			float intensity = light.intensity;
+			if (shadow != NULL)
+			{
+				intensity *= ShadowVisibility(*shadow, world_pos, N);
+			}
 
-				// ɫ = ɫ *  + ⣩ + ߹
-				Vec3 final_color = texColor * (ambient + total_diffuse) + total_specular;
+			// ˥ϵ
+			float attenuation = 1.0f / (light.Kc + light.Kl * distance + light.Kq * distance * distance);
 
-				frame_buffer[y * width + x] = Vec3ToUint32(final_color);
+			// 
+			float diff = std::max(dot(normal, L), 0.0f);
+			total_diffuse = total_diffuse + light.color * (diff * intensity * material.diffuse * attenuation);
+
+			// ߹
+			//Vec3 R = normalize(reflect(L * -1.0f, normal));
+			//float spec = std::pow(std::max(dot(R, V), 0.0f), material.shininess);
+			if (specular)
+			{
+				Vec3 H = normalize(L + V, accuracy);
+				float spec = SpecularPow(std::max(dot(normal, H), 0.0f), material.shininess * 4.0f, accuracy);
+				total_specular = total_specular + light.color * (spec * intensity * material.specular * attenuation * fresnel);
 			}
 		}
+
+	}
+
+	// ɫ = ɫ *  + ⣩ + ߹
+	return texColor * (ambient + total_diffuse) + total_specular;
+}
+
+// ÿϵɫӳɫĹս׶ΰصĲѡ
+typedef Vec3 (*ShadePixelFunc)(const SurfaceMaterial& surface, const Vec3& world_pos, float u, float v, float lod, const Vec3& N, const Vec3& T, const Vec3& B, const Vec3& camera_pos, const std::vector<Light>& lights, const ShadowMap* shadows, const uint32_t* light_indices, int light_count);
+
+template <int... F>
+static constexpr std::array<ShadePixelFunc, sizeof...(F)> ShadePixelTable(std::integer_sequence<int, F...>)
+{
+	return { { &ShadePixel<F>... } };
+}
+
+static constexpr std::array<ShadePixelFunc, SHADER_PERMUTATIONS> shade_pixel_table = ShadePixelTable(std::make_integer_sequence<int, SHADER_PERMUTATIONS>());
+
+void ResolveRow(GBuffer& gbuffer, const std::vector<SurfaceMaterial>& materials, int y, const Vec3& camera_pos, const std::vector<Light>& lights, const ShadowMap* shadows, int scene_features, const LightClusters& clusters, Uint32* frame_buffer, RenderStats& stats)
+{
+	int index = y * gbuffer.width;
+	for (int x = 0; x < gbuffer.width; x++, index++)
+	{
+		uint16_t id = gbuffer.material_id[index];
+		if (id == 0)
+		{
+			continue;
+		}
+
+		Vec3 world_pos(gbuffer.pos_x[index], gbuffer.pos_y[index], gbuffer.pos_z[index]);
+		Vec3 N(gbuffer.nor_x[index], gbuffer.nor_y[index], gbuffer.nor_z[index]);
+		Vec3 T(gbuffer.tan_x[index], gbuffer.tan_y[index], gbuffer.tan_z[index]);
+		Vec3 B(gbuffer.bit_x[index], gbuffer.bit_y[index], gbuffer.bit_z[index]);
+		int cluster = clusters.Cluster(x, y, world_pos);
+		int light_count = clusters.LightCount(cluster);
+		ShadePixelFunc shade = scene_features == SHADER_DYNAMIC ? &ShadePixel<SHADER_DYNAMIC> : shade_pixel_table[materials[id - 1].Features() | scene_features];
+		Vec3 final_color = shade(materials[id - 1], world_pos, gbuffer.tex_u[index], gbuffer.tex_v[index], gbuffer.tex_lod[index], N, T, B, camera_pos, lights, shadows, clusters.Lights(cluster), light_count);
+		frame_buffer[index] = Vec3ToUint32(final_color);
+
+		gbuffer.material_id[index] = 0;// գһ֡ G-Buffer
+		PROFILE_COUNT(stats.pixels_shaded, 1);
+		PROFILE_COUNT(stats.texture_samples, materials[id - 1].SampleCount());
+		PROFILE_COUNT(stats.pixel_lights, light_count);
 	}
 }
 
-float EdgeFunction(const Vec3& p1, const Vec3& p2, const Vec3& p3)
+Tile TriangleBounds(const Triangle& tri, int width, int height)
 {
-	Vec3 m = p2 - p1;
-	Vec3 n = p3 - p1;
+	// ҵܿεС
+	Tile box;
+	box.x0 = (int)std::floor(std::min({ tri.x[0], tri.x[1], tri.x[2] }));
+	box.x1 = (int)std::ceil(std::max({ tri.x[0], tri.x[1], tri.x[2] }));
+	box.y0 = (int)std::floor(std::min({ tri.y[0], tri.y[1], tri.y[2] }));
+	box.y1 = (int)std::ceil(std::max({ tri.y[0], tri.y[1], tri.y[2] }));
+
+	// ȡʱܻ΢Ҫǯһ
+	box.x0 = std::max(0, box.x0);
+	box.x1 = std::min(width - 1, box.x1);
+	box.y0 = std::max(0, box.y0);
+	box.y1 = std::min(height - 1, box.y1);
 
-	return (m.y * n.x) - (m.x * n.y);
+	return box;
 }
 
-//
-Vec3 ComputeBarycentric(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c)
+// νѶתɶ꣬ߵıߺ
+SetupResult SetupTriangle(const Triangle& tri, const float* varyings, CullMode cull_mode, TriangleSetup& setup)
 {
-	//Ĳ˵ε
-	float area_reciprocal = EdgeFunction(a, b, c);
+	int64_t px[3], py[3];
+	for (int i = 0; i < 3; i++)
+	{
+		// ǯһ£ֹƽ渽ľ޴ڶ
+		float x = std::clamp(tri.x[i], -SCREEN_COORD_LIMIT, SCREEN_COORD_LIMIT);
+		float y = std::clamp(tri.y[i], -SCREEN_COORD_LIMIT, SCREEN_COORD_LIMIT);
+		px[i] = (int64_t)std::floor(x * SUBPIXEL_ONE + 0.5f);
+		py[i] = (int64_t)std::floor(y * SUBPIXEL_ONE + 0.5f);
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		//  i ıߣӶ j ָ򶥵 k
+		int j = (i + 1) % 3;
+		int k = (i + 2) % 3;
+
+		EdgeEquation& e = setup.edge[i];
+		e.A = py[k] - py[j];
+		e.B = px[j] - px[k];
+		e.x0 = px[j];
+		e.y0 = py[j];
+	}
+
+	// ڱ 0 ڶ 0 ֵ
+	int64_t area = setup.edge[0].A * (px[0] - px[1]) + setup.edge[0].B * (py[0] - py[1]);
+	if (area == 0)
+	{
+		return SetupDegenerate;
+	}
+
+	// 棨ռдȥʱ룩ͶӰ y µĻ˳ʱ룬ʱ area > 0
+	bool back_facing = area < 0;
+	if (cull_mode == (back_facing ? CullBack : CullFront))
+	{
+		return SetupCulled;
+	}
+
+	// ͳһʹڲıߺΪ
+	if (area < 0)
+	{
+		area = -area;
+		for (auto& e : setup.edge)
+		{
+			e.A = -e.A;
+			e.B = -e.B;
+		}
+	}
 
-	if (std::abs(area_reciprocal) < 1e-6)
+	for (auto& e : setup.edge)
 	{
-		return Vec3(-1.0f, -1.0f, -1.0f);
+		// Ļ y £ߵڲҲࣨA > 0ϱˮƽڲ·A == 0 && B > 0
+		e.top_left = e.A > 0 || (e.A == 0 && e.B > 0);
 	}
 
-	area_reciprocal = 1.0f / area_reciprocal;
+	// ߺֵ 2 * SUBPIXEL_BITS λСҲһֵ
+	setup.inv_area = 1.0f / (float)area;
+
+	// ƽ棺Եģȵ߲ļȨ
+	float z0 = tri.z[0], z1 = tri.z[1], z2 = tri.z[2];
+	setup.min_z = std::min({ z0, z1, z2 });
+	setup.z_dx = ((float)setup.edge[0].StepX() * z0 + (float)setup.edge[1].StepX() * z1 + (float)setup.edge[2].StepX() * z2) * setup.inv_area;
+	setup.z_dy = ((float)setup.edge[0].StepY() * z0 + (float)setup.edge[1].StepY() * z1 + (float)setup.edge[2].StepY() * z2) * setup.inv_area;
 
-	float alpha = EdgeFunction(b, c, p) * area_reciprocal;
-	float beta = EdgeFunction(c, a, p) * area_reciprocal;
-	float gamma = EdgeFunction(a, b, p) * area_reciprocal;
+	if (varyings == NULL)
+	{
+		return back_facing ? SetupBackFacing : SetupFrontFacing;
+	}
 
-	return Vec3(alpha, beta, gamma);
+	// u/wv/w1/w ĻռҲԵģͬķɫʱǵõĵ
+	auto plane_dx = [&](float a0, float a1, float a2)
+	{
+		return ((float)setup.edge[0].StepX() * a0 + (float)setup.edge[1].StepX() * a1 + (float)setup.edge[2].StepX() * a2) * setup.inv_area;
+	};
+	auto plane_dy = [&](float a0, float a1, float a2)
+	{
+		return ((float)setup.edge[0].StepY() * a0 + (float)setup.edge[1].StepY() * a1 + (float)setup.edge[2].StepY() * a2) * setup.inv_area;
+	};
+
+	const float* u = varyings + VaryingU * 3;
+	const float* v = varyings + VaryingV * 3;
+	const float* inv_w = tri.inv_w;
+	setup.uw_dx = plane_dx(u[0] * inv_w[0], u[1] * inv_w[1], u[2] * inv_w[2]);
+	setup.uw_dy = plane_dy(u[0] * inv_w[0], u[1] * inv_w[1], u[2] * inv_w[2]);
+	setup.vw_dx = plane_dx(v[0] * inv_w[0], v[1] * inv_w[1], v[2] * inv_w[2]);
+	setup.vw_dy = plane_dy(v[0] * inv_w[0], v[1] * inv_w[1], v[2] * inv_w[2]);
+	setup.inv_w_dx = plane_dx(inv_w[0], inv_w[1], inv_w[2]);
+	setup.inv_w_dy = plane_dy(inv_w[0], inv_w[1], inv_w[2]);
+
+	return back_facing ? SetupBackFacing : SetupFrontFacing;
 }
 
-//ץȡ
-Vec3 GetPixelFromSurface(SDL_Surface* surface, float u, float v)
+SDL_Surface* LoadTexture(const char* filename)
 {
-	//uvת
-	int x = (int)(u * surface->w);
-	int y = (int)((1.0f - v) * surface->h);
-
-	//ֹԽ
-	x = std::clamp(x, 0, surface->w - 1);
-	y = std::clamp(y, 0, surface->h - 1);
+	// ͼƬ
+	SDL_Surface* loadedSurface = IMG_Load(filename);
+	if (!loadedSurface)
+	{
+		SDL_Log("޷ͼƬ %s: %s", filename, SDL_GetError());
+		return nullptr;
+	}
 
-	Uint32* pixels = (Uint32*)surface->pixels;
-	Uint32 pixel = pixels[y * (surface->pitch / 4) + x];
+	// ͼƬת RGBA32 ʽȡ
+	SDL_Surface* optimizedSurface = SDL_ConvertSurface(loadedSurface, SDL_PIXELFORMAT_RGBA32);
 
-	Uint8 r, g, b, a;
-	SDL_GetRGBA(pixel, SDL_GetPixelFormatDetails(surface->format), NULL, &r, &g, &b, &a);
+	// ͷԭ
+	SDL_DestroySurface(loadedSurface);
 
-	return Vec3(r / 255.0f, g / 255.0f, b / 255.0f);
+	return optimizedSurface;
 }
 
-Vec3 reflect(const Vec3& I, const Vec3& N)
+Vec3 SampleDiffuse(const Texture* texture, float u, float v, float lod, TextureFilter filter)
 {
-	return I - N * (2.0f * dot(N, I));
+	if (texture != NULL)
+	{
+		return texture->Sample(u, v, lod, filter);
+	}
+
+	int check = (int)(floor(u * 10.0f)) + (int)(floor(v * 10.0f));
+	return (check % 2 == 0) ? Vec3(0.2f, 0.2f, 0.2f) : Vec3(0.3f, 0.3f, 0.3f);
 }
 
-Vertex intersect(const Vertex& a, const Vertex& b, float w_near)
+Vec3 reflect(const Vec3& I, const Vec3& N)
 {
-	float t = (w_near - a.pos_clip_w) / (b.pos_clip_w - a.pos_clip_w);
-	return Vertex::lerp(a, b, t);
+	return I - N * (2.0f * dot(N, I));
 }
 
 void TransformToScreen(Triangle& tri, int width, int height)
@@ -350,14 +2108,14 @@ void TransformToScreen(Triangle& tri, int width, int height)
 	for (int j = 0; j < 3; j++)
 	{
 		//͸ӳ3düռ䵽2d ndcռ䣡
-		tri.v[j].inv_w = 1.0f / tri.v[j].pos_clip_w;
+		tri.inv_w[j] = 1.0f / tri.w[j];
 
-		float nx = tri.v[j].position.x * tri.v[j].inv_w;
-		float ny = tri.v[j].position.y * tri.v[j].inv_w;
-		float nz = tri.v[j].position.z * tri.v[j].inv_w;
+		float nx = tri.x[j] * tri.inv_w[j];
+		float ny = tri.y[j] * tri.inv_w[j];
+		float nz = tri.z[j] * tri.inv_w[j];
 
-		tri.v[j].position.x = (nx + 1.0f) * 0.5f * width;
-		tri.v[j].position.y = (1.0f - ny) * 0.5f * height;
-		tri.v[j].position.z = nz;
+		tri.x[j] = (nx + 1.0f) * 0.5f * width;
+		tri.y[j] = (1.0f - ny) * 0.5f * height;
+		tri.z[j] = nz;
 	}
 }
\ No newline at end of file
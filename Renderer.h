@@ -4,11 +4,152 @@
 #include <SDL3/SDL.h>
 #include "Model.h"
 
-void Render(int width, int height, Model* model, Mat4 model_mat, SDL_Surface* texture, Camera* camera, SDL_Surface* normal_map, Uint32* frame_buffer, vector<float>& z_buffer, Material material, std::vector<Light>& lights);
-void RasterizeTriangle(const Triangle& tri, int width, int height, SDL_Surface* texture, Camera* camera, SDL_Surface* normal_map, Uint32* frame_buffer, vector<float>& z_buffer, Material material, std::vector<Light>& lights);
-float EdgeFunction(const Vec3& p1, const Vec3& p2, const Vec3& p3);
-inline Vec3 ComputeBarycentric(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c);
-Vec3 GetPixelFromSurface(SDL_Surface* surface, float u, float v);
+// ĻֿСأÿֿһ̶߳ռ
+const int TILE_SIZE = 64;
+
+// ֹդؿСжǷ
+const int RASTER_BLOCK_SIZE = 8;
+
+// 㴦׶ÿ任Ķ
+const int VERTEX_BATCH_SIZE = 1024;
+
+enum BlockCoverage { BlockOutside = 0, BlockPartial = 1, BlockInside = 2 };
+
+// ÿ Render õ޳ʽCullBack ޳棬CullFront ޳棬CullNone 涼˫ҶƬ
+enum CullMode { CullBack = 0, CullFront = 1, CullNone = 2 };
+
+// ޳ʽ֣
+const char* CullModeName(CullMode cull_mode);
+
+// Χ׶Ĺϵ
+enum FrustumCoverage { FrustumOutside = 0, FrustumPartial = 1, FrustumInside = 2 };
+
+// νĽͱ
+enum SetupResult { SetupFrontFacing = 0, SetupBackFacing = 1, SetupDegenerate = 2, SetupCulled = 3 };
+
+// ͶӰģͣbounds_minbounds_max ռİΧ
+struct ShadowCaster
+{
+	Model* model;
+	Mat4 model_mat;
+	CullMode cull_mode;
+	Vec3 bounds_min, bounds_max;
+};
+
+void Render(int width, int height, Model* model, Mat4 model_mat, Texture* texture, Camera* camera, Texture* normal_map, Uint32* frame_buffer, std::vector<float>& z_buffer, Material material, std::vector<Light>& lights, CullMode cull_mode = CullBack);
+
+// Render ʹõͶӰͼٳģ; mvp
+Mat4 CreateViewProjection(int width, int height, const Camera* camera);
+
+// ѡģ͵ϸڲΣֵһԭʼļͶӰĻϲ GetLodErrorPixels() 
+int SelectLod(const Model* model, const Mat4& model_mat, int height, const Camera* camera);
+
+//  mvp ѰΧе 8 ǵ任üռ䣬жϰΧ׶⡢׶ཻ׶
+FrustumCoverage ClassifyBox(const Vec3& bounds_min, const Vec3& bounds_max, const Mat4& mvp);
+
+// ̵߳ȾͳƲ㣬ÿ֡һ
+RenderStats CollectRenderStats();
+
+// Ƿʹ SIMD դںˣCPU ֧ʱʼΪ false
+void SetSIMDEnabled(bool enabled);
+bool IsSIMDEnabled();
+
+// Ƿʹ Hi-Z ǰ޳ڵκؿ
+void SetHiZEnabled(bool enabled);
+bool IsHiZEnabled();
+
+// ȻΪ 1ͬʱ Hi-Zÿ֮֡ǰֱȻ
+void ClearDepth(std::vector<float>& z_buffer);
+
+// Hi-Z ڶ Render ֮䱣ʽдȻ֮Ҫһ
+void InvalidateHiZ();
+
+// Ƿװǰ׶޳ģ͵İΧк͵Σͱüرʱֻƽü
+void SetFrustumCullingEnabled(bool enabled);
+bool IsFrustumCullingEnabled();
+
+// ǷĻռΪÿ Render ѡģ͵ LODرʱʼջԭʼ
+void SetLodEnabled(bool enabled);
+bool IsLodEnabled();
+
+// LOD ĻռأĬ 1 
+void SetLodErrorPixels(float pixels);
+float GetLodErrorPixels();
+
+// Ƿ񰴴޳ԴԴð뾶ֵĻֿȲɵĴֻڴصĹԴرʱÿرйԴ
+void SetLightCullingEnabled(bool enabled);
+bool IsLightCullingEnabled();
+
+// Ϊ shadow_size > 0 ĹԴȾӰͼƽйǰסͶߵͶӰԴͼ֮ Render  ResolveDeferred ǼӰ
+// ÿ֡ڻ֮ǰһΣӰȵĹԴ͡λáð뾶ͼСͶбģ͡ģ;޳ʽһͬͼֱãȾ
+// ͼֻ任λáֵֻȣ Render εĲüͷֿդ
+ShadowStats UpdateShadowMaps(const std::vector<ShadowCaster>& casters, const std::vector<Light>& lights);
+
+// ǷӰرʱ UpdateShadowMaps ʲôɫʱҲѯӰͼ
+void SetShadowMappingEnabled(bool enabled);
+bool IsShadowMappingEnabled();
+
+// ѯӰͼʱǷ PCF ˣ3x3 ˫ԱȽϵƽرʱֻȽһ
+void SetShadowPCFEnabled(bool enabled);
+bool IsShadowPCFEnabled();
+
+// ǷùԴͶ߶ûӰͼرʱÿζȾڲͼȾٶȣ
+void SetShadowCacheEnabled(bool enabled);
+bool IsShadowCacheEnabled();
+
+// ǷɫѡػĹդɫ룻رʱлƶʱжÿԵͨð汾ڶԱȣ
+void SetShaderSpecializationEnabled(bool enabled);
+bool IsShaderSpecializationEnabled();
+
+// ǷʹÿٽƵѧFastMath.h  MathFastĬϹرգرʱʹ׼ͬľȷ㷨
+void SetFastMathEnabled(bool enabled);
+bool IsFastMathEnabled();
+
+// ʺԴʱɫϣShaderFeature FeatureGBufferûйԴʱ FeatureShadows
+int SelectShaderFeatures(const SurfaceMaterial& surface, const std::vector<Light>& lights);
+
+// Ϊ world_pos㷨Ϊ N ı汻ӰͼĹԴյı0 ʾȫӰ
+// Ƚ֮ǰѱطߺ͹ԴƳԼһأԼסԼӰ
+float ShadowVisibility(const ShadowMap& map, const Vec3& world_pos, const Vec3& N);
+
+// ǷʹӳɫRender ֻѿɼд G-BufferResolveDeferred ٶÿɼɫһ
+void SetDeferredEnabled(bool enabled);
+bool IsDeferredEnabled();
+
+// ˷ʽ֮ Render Ч
+void SetTextureFilter(TextureFilter filter);
+TextureFilter GetTextureFilter();
+
+// ӳɫĹս׶Σ Render ֮ʾ֮ǰһΣδӳɫʱʲô
+void ResolveDeferred(int width, int height, Camera* camera, Uint32* frame_buffer, std::vector<Light>& lights);
+
+// varyings εĲֵԣ Triangle ctx.surface.VaryingCount() 
+void RasterizeTriangle(const Triangle& tri, const float* varyings, const TriangleSetup& setup, const Tile& tile, const DrawContext& ctx, HiZBuffer* hiz, RenderStats& stats);
+BlockCoverage ClassifyBlock(const TriangleSetup& setup, const Tile& block);
+//  featuresԴ FeatureGBufferSHADER_DYNAMIC Ϊػİ汾Ӧıդ
+RasterizeBlockFunc SelectRasterizeBlock(int features);
+// ֻдȵĹդӰͼdepth  size x size ͼдȵ
+void RasterizeTriangleDepth(const Triangle& tri, const TriangleSetup& setup, const Tile& tile, float* depth, int size, RenderStats& stats);
+int RasterizeBlockDepth(const Triangle& tri, const TriangleSetup& setup, const Tile& block, bool full, float* depth, int size, RenderStats& stats);
+// ӳɫս׶ΣԵ y мɫЩصĲ ID
+// scene_features ǹԴȫþɫԣÿصĲԺѡɫΪ SHADER_DYNAMIC ʱػ
+void ResolveRow(GBuffer& gbuffer, const std::vector<SurfaceMaterial>& materials, int y, const Vec3& camera_pos, const std::vector<Light>& lights, const ShadowMap* shadows, int scene_features, const LightClusters& clusters, Uint32* frame_buffer, RenderStats& stats);
+float BlockMinDepth(const Triangle& tri, const TriangleSetup& setup, const Tile& block);
+// Ȼ¼ rect ǵؿȣҪʱ˳Ļֿ
+void UpdateHiZ(HiZBuffer& hiz, const float* z_buffer, int width, int height, const Tile& rect);
+void UpdateHiZTile(HiZBuffer& hiz, int tx, int ty);
+// ģѡеһ LODж任üռռ䣬ߺ߱任ռ䲢һߣ
+// ͬʱ¼ÿԲüƽλãClipFlagsguard_band Ǳ NDC еİvarying_count ʱߺ͸
+void TransformVertices(const MeshView& mesh, const Mat4& model_mat, const Mat4& mvp, float guard_band, int varying_count, VertexCache& cache);
+void BinTriangles(const std::vector<Triangle>& tris, int tiles_x, int tiles_y, int width, int height, TileBins& bins);
+Tile TriangleBounds(const Triangle& tri, int width, int height);
+// Ļռжϳcull_mode Ҫ޳һ淵 SetupCulledΪ 0  SetupDegenerate
+// varyings Ϊ NULL ʱͼ 1/w 
+SetupResult SetupTriangle(const Triangle& tri, const float* varyings, CullMode cull_mode, TriangleSetup& setup);
+// ͼƬת RGBA32 ʽʧʱ NULLȾǰ Texture::CreateTexture 
+SDL_Surface* LoadTexture(const char* filename);
+// ɫͲûͻһ̸
+Vec3 SampleDiffuse(const Texture* texture, float u, float v, float lod, TextureFilter filter);
 Vec3 reflect(const Vec3& I, const Vec3& N);
-Vertex intersect(const Vertex& a, const Vertex& b, float w_near = 0.1f);
+// ͸ӳӿڱ任ֻıλãֵԱֲüռеֵ
 void TransformToScreen(Triangle& tri, int width, int height);
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include <cfloat>
+#include <algorithm>
+
+#include "Scene.h"
+#include "Profiler.h"
+
+// Ҷڵʵ
+const int BVH_LEAF_SIZE = 4;
+
+static inline float Axis(const Vec3& v, int axis)
+{
+	return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+static inline void GrowBounds(Vec3& bounds_min, Vec3& bounds_max, const Vec3& p_min, const Vec3& p_max)
+{
+	bounds_min = Vec3(std::min(bounds_min.x, p_min.x), std::min(bounds_min.y, p_min.y), std::min(bounds_min.z, p_min.z));
+	bounds_max = Vec3(std::max(bounds_max.x, p_max.x), std::max(bounds_max.y, p_max.y), std::max(bounds_max.z, p_max.z));
+}
+
+// ģͿռİΧб任ռȡ 8 ǵİΧ
+static void TransformBounds(const Vec3& local_min, const Vec3& local_max, const Mat4& m, Vec3& world_min, Vec3& world_max)
+{
+	world_min = Vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+	world_max = Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (int i = 0; i < 8; i++)
+	{
+		Vec3 corner((i & 1) ? local_max.x : local_min.x, (i & 2) ? local_max.y : local_min.y, (i & 4) ? local_max.z : local_min.z);
+		Vec4 p = m * corner;
+		Vec3 w(p.x, p.y, p.z);
+		GrowBounds(world_min, world_max, w, w);
+	}
+}
+
+int Scene::AddMesh(Model* model, Texture* texture, Texture* normal_map, Material material, CullMode cull_mode)
+{
+	meshes.push_back({ model, texture, normal_map, material, cull_mode });
+	return (int)meshes.size() - 1;
+}
+
+int Scene::AddInstance(int mesh, const Mat4& model_mat)
+{
+	instances.push_back(SceneInstance());
+	instances.back().mesh = mesh;
+	SetInstanceTransform((int)instances.size() - 1, model_mat);
+	return (int)instances.size() - 1;
+}
+
+void Scene::SetInstanceTransform(int instance, const Mat4& model_mat)
+{
+	SceneInstance& inst = instances[instance];
+	const MeshView& mesh = meshes[inst.mesh].model->mesh;
+	inst.model_mat = model_mat;
+	TransformBounds(mesh.bounds_min, mesh.bounds_max, model_mat, inst.bounds_min, inst.bounds_max);
+	dirty = true;
+}
+
+void Scene::Build()
+{
+	instance_order.resize(instances.size());
+	for (int i = 0; i < (int)instances.size(); i++)
+	{
+		instance_order[i] = i;
+	}
+
+	// n ʵĶ 2n - 1 ڵ㣬Ԥȷãݹʱڵ±겻ʧЧ
+	nodes.clear();
+	nodes.reserve(std::max<size_t>(1, instances.size() * 2));
+	nodes.push_back(BVHNode());
+	BuildNode(0, 0, (int)instances.size());
+	dirty = false;
+}
+
+// Զ½һʵİΧУذΧķֲᰴλֳ
+void Scene::BuildNode(int node, int first, int count)
+{
+	Vec3 bounds_min(FLT_MAX, FLT_MAX, FLT_MAX), bounds_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	Vec3 center_min(FLT_MAX, FLT_MAX, FLT_MAX), center_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (int i = first; i < first + count; i++)
+	{
+		const SceneInstance& inst = instances[instance_order[i]];
+		Vec3 center = (inst.bounds_min + inst.bounds_max) * 0.5f;
+		GrowBounds(bounds_min, bounds_max, inst.bounds_min, inst.bounds_max);
+		GrowBounds(center_min, center_max, center, center);
+	}
+
+	nodes[node].bounds_min = bounds_min;
+	nodes[node].bounds_max = bounds_max;
+	nodes[node].first = first;
+	nodes[node].count = count;
+	nodes[node].left = -1;
+	if (count <= BVH_LEAF_SIZE)
+	{
+		return;
+	}
+
+	Vec3 extent = center_max - center_min;
+	int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+	int half = count / 2;
+	std::nth_element(instance_order.begin() + first, instance_order.begin() + first + half, instance_order.begin() + first + count, [&](int a, int b)
+	{
+		return Axis(instances[a].bounds_min, axis) + Axis(instances[a].bounds_max, axis) < Axis(instances[b].bounds_min, axis) + Axis(instances[b].bounds_max, axis);
+	});
+
+	int left = (int)nodes.size();
+	nodes[node].left = left;
+	nodes.push_back(BVHNode());
+	nodes.push_back(BVHNode());
+	BuildNode(left, first, half);
+	BuildNode(left + 1, first + half, count - half);
+}
+
+SceneStats Scene::Draw(int width, int height, Camera* camera, Uint32* frame_buffer, std::vector<float>& z_buffer, std::vector<Light>& lights)
+{
+	PROFILE_SCOPE("Scene Draw");
+	if (dirty)
+	{
+		Build();
+	}
+
+	SceneStats stats;
+	stats.instances_total = (int)instances.size();
+	Mat4 view_projection = CreateViewProjection(width, height, camera);
+	visible.clear();
+
+	// Χĵľ룬ڰΧʱΪ 0
+	auto add_visible = [&](int index)
+	{
+		const SceneInstance& inst = instances[index];
+		const Vec3& p = camera->position;
+		Vec3 closest(std::clamp(p.x, inst.bounds_min.x, inst.bounds_max.x), std::clamp(p.y, inst.bounds_min.y, inst.bounds_max.y), std::clamp(p.z, inst.bounds_min.z, inst.bounds_max.z));
+		Vec3 d = closest - p;
+		visible.push_back({ dot(d, d), index });
+	};
+
+	if (!bvh_enabled)
+	{
+		// ʵ
+		for (int i = 0; i < (int)instances.size(); i++)
+		{
+			stats.nodes_visited++;
+			if (ClassifyBox(instances[i].bounds_min, instances[i].bounds_max, view_projection) != FrustumOutside)
+			{
+				add_visible(i);
+			}
+		}
+	}
+	else if (!nodes.empty() && !instances.empty())
+	{
+		// ڵ׶׶ھͲٲӽڵ
+		stack.clear();
+		stack.push_back(0);
+		while (!stack.empty())
+		{
+			const BVHNode& node = nodes[stack.back()];
+			stack.pop_back();
+			stats.nodes_visited++;
+
+			FrustumCoverage coverage = ClassifyBox(node.bounds_min, node.bounds_max, view_projection);
+			if (coverage == FrustumOutside)
+			{
+				continue;
+			}
+			if (coverage == FrustumInside || node.left < 0)
+			{
+				for (int i = node.first; i < node.first + node.count; i++)
+				{
+					// Ҷڵ׶ཻʱڵʵҪһ
+					if (coverage == FrustumInside || ClassifyBox(instances[instance_order[i]].bounds_min, instances[instance_order[i]].bounds_max, view_projection) != FrustumOutside)
+					{
+						add_visible(instance_order[i]);
+					}
+				}
+				continue;
+			}
+			stack.push_back(node.left + 1);
+			stack.push_back(node.left);
+		}
+	}
+
+	// ͬʱʵ±֤꣬ÿεĻ˳ͬ
+	if (sort_enabled)
+	{
+		std::sort(visible.begin(), visible.end());
+	}
+	else
+	{
+		std::sort(visible.begin(), visible.end(), [](const std::pair<float, int>& a, const std::pair<float, int>& b) { return a.second < b.second; });
+	}
+
+	for (const auto& v : visible)
+	{
+		const SceneInstance& inst = instances[v.second];
+		const SceneMesh& mesh = meshes[inst.mesh];
+		Render(width, height, mesh.model, inst.model_mat, mesh.texture, camera, mesh.normal_map, frame_buffer, z_buffer, mesh.material, lights, mesh.cull_mode);
+	}
+
+	stats.instances_visible = (int)visible.size();
+	return stats;
+}
+
+ShadowStats Scene::UpdateShadows(const std::vector<Light>& lights)
+{
+	casters.resize(instances.size());
+	for (size_t i = 0; i < instances.size(); i++)
+	{
+		const SceneInstance& inst = instances[i];
+		const SceneMesh& mesh = meshes[inst.mesh];
+		casters[i] = { mesh.model, inst.model_mat, mesh.cull_mode, inst.bounds_min, inst.bounds_max };
+	}
+	return UpdateShadowMaps(casters, lights);
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <SDL3/SDL.h>
+#include "Math.h"
+#include "Model.h"
+#include "Renderer.h"
+
+// еһ񣺹ģͺĲʡͼ޳ʽԱʵ
+// ӹģͺͼ߸ڳ֮ͷ
+struct SceneMesh
+{
+	Model* model;
+	Texture* texture;
+	Texture* normal_map;
+	Material material;
+	CullMode cull_mode;
+};
+
+// һڷλ
+struct SceneInstance
+{
+	int mesh;// SceneMesh ±
+	Mat4 model_mat;
+	Vec3 bounds_min, bounds_max;// ռİΧУģͿռΧе 8 ǵ任
+};
+
+// ʵΧϵĲΰΧУBVHڵ
+// ÿڵ instance_order һ [first, first + count)׶ڵĽڵ㲻ٲӽڵ
+struct BVHNode
+{
+	Vec3 bounds_min, bounds_max;
+	int left;// ڲڵӽڵ㣬ӽڵ棻ҶڵΪ -1
+	int first, count;
+};
+
+// ÿ Draw ͳ
+struct SceneStats
+{
+	int instances_total;
+	int instances_visible;// ȥ Render ʵ
+	int nodes_visited;//  BVH ʱ׶ԵĽڵ
+
+	SceneStats() : instances_total(0), instances_visible(0), nodes_visited(0) {}
+};
+
+// ǵʵÿ֡ BVH ޳׶ʵֻԿɼʵ Render
+// Ŀɼʵ BVH ȣȣ볡еʵ޹
+class Scene
+{
+public:
+	Scene() : bvh_enabled(true), sort_enabled(true), dirty(false) {}
+
+	Scene(const Scene&) = delete;
+	Scene& operator=(const Scene&) = delete;
+
+	// ±꣬AddInstance 
+	int AddMesh(Model* model, Texture* texture, Texture* normal_map, Material material, CullMode cull_mode = CullBack);
+
+	// ʵ±ꣻӻƶʵһ Draw ֮ǰؽ BVH
+	int AddInstance(int mesh, const Mat4& model_mat);
+	void SetInstanceTransform(int instance, const Mat4& model_mat);
+
+	int MeshCount() const { return (int)meshes.size(); }
+	int InstanceCount() const { return (int)instances.size(); }
+	const SceneInstance& Instance(int instance) const { return instances[instance]; }
+
+	// ǰʵؽ BVHDraw ҪʱԶ
+	void Build();
+
+	// ޳׶ʵѿɼʵ˳򽻸 Renderӳɫʱл֮ ResolveDeferred
+	SceneStats Draw(int width, int height, Camera* camera, Uint32* frame_buffer, std::vector<float>& z_buffer, std::vector<Light>& lights);
+
+	// ʵģΪͶ߸Ӱͼÿ֡ Draw ֮ǰãʵ͹Դûʱһ֡Ӱͼ
+	ShadowStats UpdateShadows(const std::vector<Light>& lights);
+
+	// ر BVH ʱʵ԰ΧУڶԱȣرʱӵ˳
+	void SetBVHEnabled(bool enabled) { bvh_enabled = enabled; }
+	bool IsBVHEnabled() const { return bvh_enabled; }
+
+	// ɼʵΧеľӽԶƣдȣHi-Z Ȳܵ
+	void SetSortEnabled(bool enabled) { sort_enabled = enabled; }
+	bool IsSortEnabled() const { return sort_enabled; }
+
+private:
+	void BuildNode(int node, int first, int count);
+
+	std::vector<SceneMesh> meshes;
+	std::vector<SceneInstance> instances;
+	std::vector<BVHNode> nodes;
+	std::vector<int> instance_order;// BVH Ҷڵõʵ±꣬ÿҶڵռһ
+
+	// ÿ Draw ãÿ֡·ڴ
+	std::vector<std::pair<float, int>> visible;// ɼʵƽʵ±
+	std::vector<int> stack;
+	std::vector<ShadowCaster> casters;
+
+	bool bvh_enabled;
+	bool sort_enabled;
+	bool dirty;
+};
@@ -0,0 +1,601 @@
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+
+#include "Texture.h"
+
+static const float INV_255 = 1.0f / 255.0f;
+
+static inline Vec3 DecodeTexel(uint32_t texel)
+{
+	return Vec3((float)(texel & 0xff) * INV_255, (float)((texel >> 8) & 0xff) * INV_255, (float)((texel >> 16) & 0xff) * INV_255);
+}
+
+const uint16_t Texture::morton_x[TEXTURE_TILE_SIZE] =
+{
+	0x000, 0x001, 0x004, 0x005, 0x010, 0x011, 0x014, 0x015,
+	0x040, 0x041, 0x044, 0x045, 0x050, 0x051, 0x054, 0x055,
+	0x100, 0x101, 0x104, 0x105, 0x110, 0x111, 0x114, 0x115,
+	0x140, 0x141, 0x144, 0x145, 0x150, 0x151, 0x154, 0x155,
+};
+
+// 2x2 صƽֵĸֱͨ㲢
+static inline uint32_t Average4(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+	uint32_t result = 0;
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		uint32_t sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff) + ((c >> shift) & 0xff) + ((d >> shift) & 0xff);
+		result |= ((sum + 2) >> 2) << shift;
+	}
+	return result;
+}
+
+// ÿѹռõ 32 λ
+static inline int BlockWords(TextureFormat format)
+{
+	return format == FormatBC1 ? 2 : 4;
+}
+
+static inline uint32_t Channel(uint32_t texel, int i)
+{
+	return (texel >> (i * 8)) & 0xff;
+}
+
+// RGB565 չ 8 λλøλ룬0  3163öӦ 0  255
+static inline uint32_t Expand565(uint16_t c)
+{
+	uint32_t r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+	return ((r << 3) | (r >> 2)) | (((g << 2) | (g >> 4)) << 8) | (((b << 3) | (b >> 2)) << 16) | 0xff000000u;
+}
+
+// BC1  4 ɫc0 > c1 ʱ˵֮ 1/32/3 ˵㡢е͸ɫ
+static void BC1Palette(uint16_t c0, uint16_t c1, uint32_t* palette)
+{
+	uint32_t a = Expand565(c0), b = Expand565(c1);
+	palette[0] = a;
+	palette[1] = b;
+	palette[2] = palette[3] = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		uint32_t ca = Channel(a, i), cb = Channel(b, i);
+		if (c0 > c1)
+		{
+			palette[2] |= ((2 * ca + cb + 1) / 3) << (i * 8);
+			palette[3] |= ((ca + 2 * cb + 1) / 3) << (i * 8);
+		}
+		else
+		{
+			palette[2] |= ((ca + cb + 1) / 2) << (i * 8);
+		}
+	}
+	palette[2] |= 0xff000000u;
+	if (c0 > c1)
+	{
+		palette[3] |= 0xff000000u;
+	}
+}
+
+static inline uint16_t To565(const float* rgb)
+{
+	int r = std::clamp((int)(rgb[0] * (31.0f / 255.0f) + 0.5f), 0, 31);
+	int g = std::clamp((int)(rgb[1] * (63.0f / 255.0f) + 0.5f), 0, 63);
+	int b = std::clamp((int)(rgb[2] * (31.0f / 255.0f) + 0.5f), 0, 31);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+// һ BC1 飺ɫᣨЭȡΪ˵㣬ٸÿӽɫ
+static void EncodeBC1(const uint32_t* block, uint32_t* out)
+{
+	float mean[3] = { 0, 0, 0 };
+	for (int k = 0; k < 16; k++)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			mean[i] += (float)Channel(block[k], i) * (1.0f / 16.0f);
+		}
+	}
+
+	float cov[3][3] = {};
+	for (int k = 0; k < 16; k++)
+	{
+		float d[3] = { Channel(block[k], 0) - mean[0], Channel(block[k], 1) - mean[1], Channel(block[k], 2) - mean[2] };
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				cov[i][j] += d[i] * d[j];
+			}
+		}
+	}
+
+	// ݵᣬɫЭΪ 0ȡһ򼴿
+	float axis[3] = { 1, 1, 1 };
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[3];
+		for (int i = 0; i < 3; i++)
+		{
+			next[i] = cov[i][0] * axis[0] + cov[i][1] * axis[1] + cov[i][2] * axis[2];
+		}
+		float len = std::max({ std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2]) });
+		if (len < 1e-6f)
+		{
+			break;
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			axis[i] = next[i] / len;
+		}
+	}
+
+	float min_t = 1e30f, max_t = -1e30f;
+	for (int k = 0; k < 16; k++)
+	{
+		float t = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			t += ((float)Channel(block[k], i) - mean[i]) * axis[i];
+		}
+		min_t = std::min(min_t, t);
+		max_t = std::max(max_t, t);
+	}
+
+	// ˵ 1/16 ķΧС stb_dxt ͬ
+	float inset = (max_t - min_t) / 16.0f;
+	float high[3], low[3];
+	for (int i = 0; i < 3; i++)
+	{
+		high[i] = mean[i] + axis[i] * (max_t - inset);
+		low[i] = mean[i] + axis[i] * (min_t + inset);
+	}
+
+	uint16_t c0 = To565(high), c1 = To565(low);
+	if (c0 < c1)
+	{
+		std::swap(c0, c1);
+	}
+
+	uint32_t palette[4];
+	BC1Palette(c0, c1, palette);
+	int colors = c0 > c1 ? 4 : 3;// ˵ͬʱֻò͸ 3 ɫ
+
+	uint32_t indices = 0;
+	for (int k = 0; k < 16; k++)
+	{
+		int best = 0, best_error = INT32_MAX;
+		for (int p = 0; p < colors; p++)
+		{
+			int error = 0;
+			for (int i = 0; i < 3; i++)
+			{
+				int d = (int)Channel(block[k], i) - (int)Channel(palette[p], i);
+				error += d * d;
+			}
+			if (error < best_error)
+			{
+				best = p;
+				best_error = error;
+			}
+		}
+		indices |= (uint32_t)best << (k * 2);
+	}
+
+	out[0] = (uint32_t)c0 | ((uint32_t)c1 << 16);
+	out[1] = indices;
+}
+
+static void DecodeBC1(const uint32_t* in, uint32_t* texels)
+{
+	uint32_t palette[4];
+	BC1Palette((uint16_t)(in[0] & 0xffff), (uint16_t)(in[0] >> 16), palette);
+	for (int k = 0; k < 16; k++)
+	{
+		texels[k] = palette[(in[1] >> (k * 2)) & 3];
+	}
+}
+
+// BC4BC5 һͨ 8 ȡֵr0 > r1 ʱ˵ֵ֮ 6 ֵ 4 ֵ 0  255
+static void BC4Palette(uint32_t r0, uint32_t r1, uint32_t* palette)
+{
+	palette[0] = r0;
+	palette[1] = r1;
+	if (r0 > r1)
+	{
+		for (uint32_t i = 2; i < 8; i++)
+		{
+			palette[i] = ((8 - i) * r0 + (i - 1) * r1 + 3) / 7;
+		}
+	}
+	else
+	{
+		for (uint32_t i = 2; i < 6; i++)
+		{
+			palette[i] = ((6 - i) * r0 + (i - 1) * r1 + 2) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+// һ BC4 飺ͨСֵΪ˵㣬 16 λ˵㣬֮ÿ 3 λ±
+static uint64_t EncodeBC4(const uint32_t* block, int channel)
+{
+	uint32_t r0 = 0, r1 = 255;
+	for (int k = 0; k < 16; k++)
+	{
+		r0 = std::max(r0, Channel(block[k], channel));
+		r1 = std::min(r1, Channel(block[k], channel));
+	}
+
+	uint32_t palette[8];
+	BC4Palette(r0, r1, palette);
+
+	uint64_t bits = (uint64_t)r0 | ((uint64_t)r1 << 8);
+	for (int k = 0; k < 16; k++)
+	{
+		int value = (int)Channel(block[k], channel);
+		int best = 0;
+		for (int p = 1; p < 8; p++)
+		{
+			if (std::abs(value - (int)palette[p]) < std::abs(value - (int)palette[best]))
+			{
+				best = p;
+			}
+		}
+		bits |= (uint64_t)best << (16 + k * 3);
+	}
+	return bits;
+}
+
+static void DecodeBC4(uint64_t bits, uint32_t* values)
+{
+	uint32_t palette[8];
+	BC4Palette((uint32_t)(bits & 0xff), (uint32_t)((bits >> 8) & 0xff), palette);
+	for (int k = 0; k < 16; k++)
+	{
+		values[k] = palette[(bits >> (16 + k * 3)) & 7];
+	}
+}
+
+static void EncodeBC5(const uint32_t* block, uint32_t* out)
+{
+	uint64_t red = EncodeBC4(block, 0);
+	uint64_t green = EncodeBC4(block, 1);
+	out[0] = (uint32_t)red;
+	out[1] = (uint32_t)(red >> 32);
+	out[2] = (uint32_t)green;
+	out[3] = (uint32_t)(green >> 32);
+}
+
+// ߵ z ɵλؽz = sqrt(1 - x^2 - y^2)
+static void DecodeBC5(const uint32_t* in, uint32_t* texels)
+{
+	uint32_t red[16], green[16];
+	DecodeBC4((uint64_t)in[0] | ((uint64_t)in[1] << 32), red);
+	DecodeBC4((uint64_t)in[2] | ((uint64_t)in[3] << 32), green);
+	for (int k = 0; k < 16; k++)
+	{
+		float x = red[k] * (2.0f / 255.0f) - 1.0f;
+		float y = green[k] * (2.0f / 255.0f) - 1.0f;
+		float z = std::sqrt(std::max(0.0f, 1.0f - x * x - y * y));
+		uint32_t blue = (uint32_t)((z * 0.5f + 0.5f) * 255.0f + 0.5f);
+		texels[k] = red[k] | (green[k] << 8) | (blue << 16) | 0xff000000u;
+	}
+}
+
+// ÿ߳ѹ飬ֱӳ䣺λɿĵ 3 λmipmap żŵż
+// ڵ 8x8 飨32x32 أԹõԼͬһ uv ͼͷͼͬʱڻ
+struct DecodedBlock
+{
+	const uint32_t* source;// ѹĵַһΪ
+	uint32_t texture_id;
+	uint32_t texels[16];
+};
+
+const int DECODED_BLOCK_CACHE_SIZE = 256;
+static thread_local DecodedBlock decoded_blocks[DECODED_BLOCK_CACHE_SIZE];
+
+// Ŵ 1 ʼ̻߳ʼĿղλᱻΪ
+static std::atomic<uint32_t> next_texture_id(1);
+
+const uint32_t* Texture::DecodeBlock(int level, int bx, int by) const
+{
+	const MipLevel& l = levels[level];
+	const uint32_t* source = data + l.offset + ((size_t)by * l.tiles_x + bx) * BlockWords(format);
+
+	DecodedBlock& entry = decoded_blocks[(bx & 7) | ((by & 7) << 3) | ((level & 1) << 6) | ((id & 1) << 7)];
+	if (entry.source != source || entry.texture_id != id)
+	{
+		if (format == FormatBC1)
+		{
+			DecodeBC1(source, entry.texels);
+		}
+		else
+		{
+			DecodeBC5(source, entry.texels);
+		}
+		entry.source = source;
+		entry.texture_id = id;
+	}
+	return entry.texels;
+}
+
+Texture* Texture::CreateTexture(SDL_Surface* surface, TextureLayout layout, TextureFormat format)
+{
+	if (surface == NULL || surface->w <= 0 || surface->h <= 0)
+	{
+		return NULL;
+	}
+
+	// ͳһ RGBA32ڴа RGBA ֽ˳Уٶȡ
+	SDL_Surface* rgba = surface;
+	if (surface->format != SDL_PIXELFORMAT_RGBA32)
+	{
+		rgba = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA32);
+		if (rgba == NULL)
+		{
+			return NULL;
+		}
+	}
+
+	Texture* texture = new Texture();
+	texture->layout = format == FormatRGBA8 ? layout : LayoutLinear;
+	texture->format = format;
+	texture->id = next_texture_id++;
+
+	// ÿһĴСλãһηмڴ
+	// Tiled ʱÿһ뵽飬ӿı߽翪ʼѹʽ 4x4 Ŀ
+	std::vector<size_t> linear_offsets;
+	size_t linear_total = 0;
+	size_t total = 0;
+	int w = rgba->w, h = rgba->h;
+	while (true)
+	{
+		if (format != FormatRGBA8)
+		{
+			int blocks_x = (w + 3) / 4;
+			int blocks_y = (h + 3) / 4;
+			texture->levels.push_back({ w, h, blocks_x, total });
+			total += (size_t)blocks_x * blocks_y * BlockWords(format);
+		}
+		else
+		{
+			int tiles_x = (w + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE;
+			int tiles_y = (h + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE;
+			texture->levels.push_back({ w, h, tiles_x, total });
+			total += layout == LayoutTiled ? (size_t)tiles_x * tiles_y * TEXTURE_TILE_SIZE * TEXTURE_TILE_SIZE : (size_t)w * h;
+		}
+		linear_offsets.push_back(linear_total);
+		linear_total += (size_t)w * h;
+		if (w == 1 && h == 1)
+		{
+			break;
+		}
+		w = std::max(1, w / 2);
+		h = std::max(1, h / 2);
+	}
+	texture->lod_bias = std::log2((float)std::max(rgba->w, rgba->h));
+
+	// mipmap ȰɣٰҪзʽȥ
+	std::vector<uint32_t> linear(linear_total);
+	for (int y = 0; y < rgba->h; y++)
+	{
+		const Uint8* src = (const Uint8*)rgba->pixels + y * rgba->pitch;
+		uint32_t* dst = &linear[(size_t)y * rgba->w];
+		for (int x = 0; x < rgba->w; x++, src += 4)
+		{
+			dst[x] = (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+		}
+	}
+
+	if (rgba != surface)
+	{
+		SDL_DestroySurface(rgba);
+	}
+
+	//  2x2 ʽ˲߳ʱһУУԼƽ
+	for (size_t i = 1; i < texture->levels.size(); i++)
+	{
+		const MipLevel& src = texture->levels[i - 1];
+		const MipLevel& dst = texture->levels[i];
+		const uint32_t* s = &linear[linear_offsets[i - 1]];
+		uint32_t* d = &linear[linear_offsets[i]];
+
+		for (int y = 0; y < dst.height; y++)
+		{
+			int y0 = std::min(y * 2, src.height - 1);
+			int y1 = std::min(y * 2 + 1, src.height - 1);
+			for (int x = 0; x < dst.width; x++)
+			{
+				int x0 = std::min(x * 2, src.width - 1);
+				int x1 = std::min(x * 2 + 1, src.width - 1);
+				d[y * dst.width + x] = Average4(s[y0 * src.width + x0], s[y0 * src.width + x1], s[y1 * src.width + x0], s[y1 * src.width + x1]);
+			}
+		}
+	}
+
+	//  4KB뵽 4KBÿ 32x32 һڴҳÿ 4x4 Сһ
+	const size_t alignment = 4096;
+	texture->texels.resize(total + alignment / sizeof(uint32_t) - 1);
+	uintptr_t address = (uintptr_t)texture->texels.data();
+	uint32_t* data = texture->texels.data() + ((alignment - (address & (alignment - 1))) & (alignment - 1)) / sizeof(uint32_t);
+	texture->data = data;
+
+	for (size_t i = 0; i < texture->levels.size(); i++)
+	{
+		const MipLevel& level = texture->levels[i];
+		const uint32_t* s = &linear[linear_offsets[i]];
+
+		// ѹÿȡһ 4x4 룬ԽԵĲظһУУ
+		if (format != FormatRGBA8)
+		{
+			int blocks_y = (level.height + 3) / 4;
+			for (int by = 0; by < blocks_y; by++)
+			{
+				for (int bx = 0; bx < level.tiles_x; bx++)
+				{
+					uint32_t block[16];
+					for (int k = 0; k < 16; k++)
+					{
+						int x = std::min(bx * 4 + (k & 3), level.width - 1);
+						int y = std::min(by * 4 + (k >> 2), level.height - 1);
+						block[k] = s[y * level.width + x];
+					}
+
+					uint32_t* out = data + level.offset + ((size_t)by * level.tiles_x + bx) * BlockWords(format);
+					if (format == FormatBC1)
+					{
+						EncodeBC1(block, out);
+					}
+					else
+					{
+						EncodeBC5(block, out);
+					}
+				}
+			}
+			continue;
+		}
+
+		for (int y = 0; y < level.height; y++)
+		{
+			for (int x = 0; x < level.width; x++)
+			{
+				data[texture->TexelIndex(level, x, y)] = s[y * level.width + x];
+			}
+		}
+	}
+
+	return texture;
+}
+
+Vec3 Texture::Sample(float u, float v, float lod, TextureFilter filter) const
+{
+	if (filter == FilterNearest)
+	{
+		const MipLevel& base = levels[0];
+		int x = std::clamp((int)std::clamp(u * base.width, -1.0f, (float)base.width), 0, base.width - 1);
+		int y = std::clamp((int)std::clamp((1.0f - v) * base.height, -1.0f, (float)base.height), 0, base.height - 1);
+		return DecodeTexel(Texel(0, x, y));
+	}
+
+	float level = std::clamp(lod + lod_bias, 0.0f, (float)(levels.size() - 1));
+	float c0[3];
+	if (filter == FilterBilinear)
+	{
+		SampleBilinear((int)(level + 0.5f), u, v, c0);
+		return Vec3(c0[0], c0[1], c0[2]) * INV_255;
+	}
+
+	int level0 = (int)level;
+	float t = level - level0;
+	SampleBilinear(level0, u, v, c0);
+	if (t > 0.0f)
+	{
+		float c1[3];
+		SampleBilinear(level0 + 1, u, v, c1);
+		for (int i = 0; i < 3; i++)
+		{
+			c0[i] += (c1[i] - c0[i]) * t;
+		}
+	}
+	return Vec3(c0[0], c0[1], c0[2]) * INV_255;
+}
+
+//  [0, 255] Χ rgbͳһ 1/255
+void Texture::SampleBilinear(int level, float u, float v, float* rgb) const
+{
+	const MipLevel& l = levels[level];
+
+	//  +0.5 ǯƸֹܴ꣬ uv תʱ
+	float x = std::clamp(u * l.width - 0.5f, -1.0f, (float)l.width);
+	float y = std::clamp((1.0f - v) * l.height - 0.5f, -1.0f, (float)l.height);
+	float fx = std::floor(x);
+	float fy = std::floor(y);
+	float tx = x - fx;
+	float ty = y - fy;
+
+	int x0 = std::clamp((int)fx, 0, l.width - 1);
+	int x1 = std::clamp((int)fx + 1, 0, l.width - 1);
+	int y0 = std::clamp((int)fy, 0, l.height - 1);
+	int y1 = std::clamp((int)fy + 1, 0, l.height - 1);
+
+	uint32_t c00, c10, c01, c11;
+	if (format == FormatRGBA8)
+	{
+		const uint32_t* row0 = data + l.offset + RowOffset(l, y0);
+		const uint32_t* row1 = data + l.offset + RowOffset(l, y1);
+		size_t column0 = ColumnOffset(x0);
+		size_t column1 = ColumnOffset(x1);
+		c00 = row0[column0];
+		c10 = row0[column1];
+		c01 = row1[column0];
+		c11 = row1[column1];
+	}
+	else
+	{
+		// 2x2  4 飬ʱͬһڣÿֻһλ
+		// ڵĿڽ뻺ĲͬλϣĲѯǰ淵صĿ黻ȥ
+		int bx0 = x0 >> 2, bx1 = x1 >> 2, by0 = y0 >> 2, by1 = y1 >> 2;
+		const uint32_t* b00 = DecodeBlock(level, bx0, by0);
+		const uint32_t* b10 = bx1 == bx0 ? b00 : DecodeBlock(level, bx1, by0);
+		const uint32_t* b01 = by1 == by0 ? b00 : DecodeBlock(level, bx0, by1);
+		const uint32_t* b11 = by1 == by0 ? b10 : (bx1 == bx0 ? b01 : DecodeBlock(level, bx1, by1));
+		int r0 = (y0 & 3) << 2, r1 = (y1 & 3) << 2;
+		c00 = b00[r0 | (x0 & 3)];
+		c10 = b10[r0 | (x1 & 3)];
+		c01 = b01[r1 | (x0 & 3)];
+		c11 = b11[r1 | (x1 & 3)];
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		int shift = i * 8;
+		float a = (float)((c00 >> shift) & 0xff);
+		float b = (float)((c10 >> shift) & 0xff);
+		float c = (float)((c01 >> shift) & 0xff);
+		float d = (float)((c11 >> shift) & 0xff);
+		float top = a + (b - a) * tx;
+		float bottom = c + (d - c) * tx;
+		rgb[i] = top + (bottom - top) * ty;
+	}
+}
+
+const char* TextureFilterName(TextureFilter filter)
+{
+	switch (filter)
+	{
+	case FilterNearest: return "nearest";
+	case FilterBilinear: return "bilinear";
+	case FilterTrilinear: return "trilinear";
+	}
+	return "unknown";
+}
+
+const char* TextureLayoutName(TextureLayout layout)
+{
+	return layout == LayoutTiled ? "tiled" : "linear";
+}
+
+const char* TextureFormatName(TextureFormat format)
+{
+	switch (format)
+	{
+	case FormatRGBA8: return "rgba8";
+	case FormatBC1: return "bc1";
+	case FormatBC5: return "bc5";
+	}
+	return "unknown";
+}
+
+float TextureLod(float du_dx, float dv_dx, float du_dy, float dv_dy)
+{
+	float footprint = std::max(du_dx * du_dx + dv_dx * dv_dx, du_dy * du_dy + dv_dy * dv_dy);
+
+	// ˻λ NaN ʱŴ߾ȵһ
+	if (!(footprint > 1e-20f))
+	{
+		footprint = 1e-20f;
+	}
+	return 0.5f * std::log2(footprint);
+}
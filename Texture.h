@@ -0,0 +1,127 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <SDL3/SDL.h>
+#include "Math.h"
+
+// ˷ʽ
+// Nearestֻ߾ȵһȡأԭزͬ
+// Bilinear lod ѡӽһ mipmapһ˫Բֵ
+// Trilinear mipmap ϸһ˫Բֵٰ lod Сֻ
+enum TextureFilter { FilterNearest = 0, FilterBilinear = 1, FilterTrilinear = 2 };
+
+// ڴезʽ
+// Linearдţ SDL_Surface ͬ v һͿԽһУÿβµĻ
+// Tiled 32x32 Ŀţһ 4KB һڴҳ֮Уڰ Z Morton У
+//         4x4 ĶС 16 أ 64 ֽڵһС
+//        ĻתڵĲ˫Ե 2x2 ͬһкͬһҳ
+enum TextureLayout { LayoutLinear = 0, LayoutTiled = 1 };
+
+const int TEXTURE_TILE_SHIFT = 5;
+const int TEXTURE_TILE_SIZE = 1 << TEXTURE_TILE_SHIFT;
+
+// ڴеĸʽ
+// RGBA8ÿ 4 ֽڣѹ
+// BC1ÿ 4x4  8 ֽڣÿ 4 λRGBA8  1/8 RGB565 ˵ 16  2 λ±꣬ͼ
+// BC5ÿ 4x4  16 ֽڣÿ 8 λRGBA8  1/4RG ͨ 8 λ˵ 16  3 λ±꣬
+//      ڷͼB ڽʱ sqrt(1 - x^2 - y^2) ؽ
+// ѹʽڼʱ룬ʱŰ룬Ŀ黺ÿ߳ԼС
+enum TextureFormat { FormatRGBA8 = 0, FormatBC1 = 1, FormatBC5 = 2 };
+
+// һ mipmap еλ
+struct MipLevel
+{
+	int width, height;
+	int tiles_x;// ÿеĿTiled ʱ 32x32 Ŀ飬Ⱥ͸߶ȶϲ뵽 32 ıѹʽ 4x4 Ŀ
+	size_t offset;
+};
+
+//  SDL_Surface һε
+// ԤȽɹ̶ RGBA8 ˳򣨻ѹ BC1 / BC5 mipmap һ
+// ʱҪѯظʽתɸҲֻó˷
+class Texture
+{
+public:
+	// surface ظʽΪ NULL ʱ NULLӹ surfaceͷ
+	// ѹʽĿ鰴дţ 4x4 ķֿ飬layout ֻ RGBA8 Ч
+	static Texture* CreateTexture(SDL_Surface* surface, TextureLayout layout = LayoutTiled, TextureFormat format = FormatRGBA8);
+
+	// lod  log2(һĻظǵ uv Χ)С޹أ TextureLodٻ mipmap 
+	// 곬 [0, 1] ʱȡԵ
+	Vec3 Sample(float u, float v, float lod, TextureFilter filter) const;
+
+	int Width() const { return levels[0].width; }
+	int Height() const { return levels[0].height; }
+	int LevelCount() const { return (int)levels.size(); }
+	TextureLayout Layout() const { return layout; }
+	TextureFormat Format() const { return format; }
+
+	//  level  (x, y) أr | g << 8 | b << 16 | a << 24ѹʽؽֵ
+	uint32_t Texel(int level, int x, int y) const
+	{
+		if (format != FormatRGBA8)
+		{
+			return DecodeBlock(level, x >> 2, y >> 2)[((y & 3) << 2) | (x & 3)];
+		}
+		return data[TexelIndex(levels[level], x, y)];
+	}
+
+	//  mipmap ռõֽ
+	size_t MemorySize() const { return texels.size() * sizeof(uint32_t); }
+
+private:
+	Texture() : layout(LayoutLinear), format(FormatRGBA8), id(0), data(nullptr), lod_bias(0.0f) {}
+
+	// data ָ texels ڲƺָԭĶ
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+
+	//  level  (x, y)  data е± = level.offset + RowOffset(y) + ColumnOffset(x)
+	// ֿкУ˫Բ 2x2 ֻҪ
+	size_t RowOffset(const MipLevel& level, int y) const
+	{
+		if (layout == LayoutTiled)
+		{
+			return ((size_t)(y >> TEXTURE_TILE_SHIFT) * level.tiles_x << (TEXTURE_TILE_SHIFT * 2)) + ((size_t)morton_x[y & (TEXTURE_TILE_SIZE - 1)] << 1);
+		}
+		return (size_t)y * level.width;
+	}
+
+	size_t ColumnOffset(int x) const
+	{
+		if (layout == LayoutTiled)
+		{
+			return ((size_t)(x >> TEXTURE_TILE_SHIFT) << (TEXTURE_TILE_SHIFT * 2)) + morton_x[x & (TEXTURE_TILE_SIZE - 1)];
+		}
+		return (size_t)x;
+	}
+
+	size_t TexelIndex(const MipLevel& level, int x, int y) const
+	{
+		return level.offset + RowOffset(level, y) + ColumnOffset(x);
+	}
+
+	// ѹʽ level е (bx, by)  4x4  16 أȲ鵱ǰ̵߳Ľ뻺
+	const uint32_t* DecodeBlock(int level, int bx, int by) const;
+
+	void SampleBilinear(int level, float u, float v, float* rgb) const;
+
+	// ĸλһλչabcde -> 0a0b0c0d0ex  y չһλƴ Z ±
+	static const uint16_t morton_x[TEXTURE_TILE_SIZE];
+
+	TextureLayout layout;
+	TextureFormat format;
+	uint32_t id;// ÿΨһıţ뻺Ⱥͬһַϵ
+	std::vector<MipLevel> levels;
+	std::vector<uint32_t> texels;// RGBA8 ʱÿ r | g << 8 | b << 16 | a << 24ѹʽʱǸݣ 4KB ڶ
+	const uint32_t* data;// texels а 4KB 
+	float lod_bias;// log2(max(width, height))
+};
+
+// ˷ʽзʽ͸ʽ֣
+const char* TextureFilterName(TextureFilter filter);
+const char* TextureLayoutName(TextureLayout layout);
+const char* TextureFormatName(TextureFormat format);
+
+// Ļռ uv  xy ƫ lodȡиǷΧϴһ
+float TextureLod(float du_dx, float dv_dx, float du_dy, float dv_dy);
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include "TileScheduler.h"
+
+static std::unique_ptr<TileScheduler> scheduler_instance;
+
+TileScheduler::TileScheduler(int thread_count) : worker_count(std::max(1, thread_count)), job_function(nullptr), job_context(nullptr), generation(0), busy_workers(0), quit(false)
+{
+	for (int i = 0; i < worker_count; i++)
+	{
+		queues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	// 0 ߳̾ǵ Run ֻ̱߳Ҫⴴ worker_count - 1 ߳
+	for (int i = 1; i < worker_count; i++)
+	{
+		threads.emplace_back(&TileScheduler::WorkerLoop, this, i);
+	}
+}
+
+TileScheduler::~TileScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	start_cv.notify_all();
+
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+}
+
+TileScheduler& TileScheduler::Instance()
+{
+	if (!scheduler_instance)
+	{
+		int cores = (int)std::thread::hardware_concurrency();
+		scheduler_instance = std::make_unique<TileScheduler>(cores > 0 ? cores : 1);
+	}
+
+	return *scheduler_instance;
+}
+
+void TileScheduler::SetThreadCount(int thread_count)
+{
+	scheduler_instance.reset();
+	scheduler_instance = std::make_unique<TileScheduler>(thread_count);
+}
+
+void TileScheduler::RunJob(int task_count, JobFunction function, const void* context)
+{
+	if (task_count <= 0)
+	{
+		return;
+	}
+
+	// ڵķֿ龡ͬһ߳
+	for (int w = 0; w < worker_count; w++)
+	{
+		std::lock_guard<std::mutex> lock(queues[w]->mutex);
+		queues[w]->tasks.clear();
+		queues[w]->head = 0;
+		for (int i = task_count * w / worker_count; i < task_count * (w + 1) / worker_count; i++)
+		{
+			queues[w]->tasks.push_back(i);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job_function = function;
+		job_context = context;
+		busy_workers = worker_count - 1;
+		generation++;
+	}
+	start_cv.notify_all();
+
+	// ߳Ҳɻ
+	ExecuteTasks(0);
+
+	// ̶߳һ֣job ܰȫʧЧ
+	std::unique_lock<std::mutex> lock(mutex);
+	done_cv.wait(lock, [this] { return busy_workers == 0; });
+	job_function = nullptr;
+	job_context = nullptr;
+}
+
+void TileScheduler::WorkerLoop(int worker)
+{
+	int seen_generation = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			start_cv.wait(lock, [&] { return quit || generation != seen_generation; });
+			if (quit)
+			{
+				return;
+			}
+			seen_generation = generation;
+		}
+
+		ExecuteTasks(worker);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busy_workers--;
+		}
+		done_cv.notify_one();
+	}
+}
+
+void TileScheduler::ExecuteTasks(int worker)
+{
+	int task;
+	while (PopTask(worker, task))
+	{
+		job_function(job_context, task, worker);
+	}
+}
+
+bool TileScheduler::PopTask(int worker, int& task)
+{
+	// ȴԼ
+	{
+		WorkQueue& own = *queues[worker];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (own.head < own.tasks.size())
+		{
+			task = own.tasks[own.head++];
+			return true;
+		}
+	}
+
+	// Լˣʹ̵߳Ķβ͵һ
+	for (int i = 1; i < worker_count; i++)
+	{
+		WorkQueue& victim = *queues[(worker + i) % worker_count];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.head < victim.tasks.size())
+		{
+			task = victim.tasks.back();
+			victim.tasks.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// ÿ߳ԼУԼӶͷȡ˴Ӷβ͵
+//  vector Ӷͷ±ʵ֣clear ͷÿ֡ʱ÷ڴ
+struct WorkQueue
+{
+	std::mutex mutex;
+	std::vector<int> tasks;
+	size_t head = 0;
+};
+
+// ȡһĻֿ飩ָ̳߳أ̻߳ȥ͵˵
+class TileScheduler
+{
+public:
+	explicit TileScheduler(int thread_count);
+	~TileScheduler();
+
+	// ȫΨһĵ߳Ĭϵ CPU 
+	static TileScheduler& Instance();
+
+	// ߳1 ʾ߳Ⱦؽ̳߳
+	static void SetThreadCount(int thread_count);
+
+	int WorkerCount() const { return worker_count; }
+
+	// ִ task_count job(task, worker) ڸ߳еãȫɺŷ
+	// job ַֻ̣߳ std::function Ϊıڴ
+	template <typename Job>
+	void Run(int task_count, const Job& job)
+	{
+		RunJob(task_count, [](const void* context, int task, int worker) { (*(const Job*)context)(task, worker); }, &job);
+	}
+
+private:
+	typedef void (*JobFunction)(const void* context, int task, int worker);
+
+	void RunJob(int task_count, JobFunction function, const void* context);
+	void WorkerLoop(int worker);
+	void ExecuteTasks(int worker);
+	bool PopTask(int worker, int& task);
+
+	int worker_count;
+	std::vector<std::thread> threads;
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+
+	std::mutex mutex;
+	std::condition_variable start_cv;
+	std::condition_variable done_cv;
+	JobFunction job_function;
+	const void* job_context;
+	int generation;
+	int busy_workers;
+	bool quit;
+};
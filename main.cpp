@@ -2,13 +2,16 @@ using namespace std;
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_render.h>
-#include <SDL3_image/SDL_image.h>
 #include <iostream>
 #include <cmath>
+#include <cstring>
 
 #include "Math.h"
 #include "Renderer.h"
 #include "Model.h"
+#include "Scene.h"
+#include "MappedFile.h"
+#include "Profiler.h"
 
 // ڴС
 int width = 800;    
@@ -25,10 +28,10 @@ std::vector<Light> lights =
     Light::Point(Vec3(0, 2, 0), Vec3(0.2f, 0.2f, 0.5f), 10.0f)      // Դ
 };
 
-SDL_Surface* LoadTexture(const char* filename);
 void MoveCamera(Camera* camera);
 void MoveLight();
 void CalculateFPS();
+void BenchmarkLoad(const char* filename);
 
 // ֡ʱ
 Uint64 last_time;
@@ -37,10 +40,21 @@ float deltaTime;
 
 int main(int argc, char* argv[]) {
 
+    // RendererLearn --bench-load ģ.objֻģͼٶȣ򿪴
+    if (argc >= 3 && strcmp(argv[1], "--bench-load") == 0)
+    {
+        BenchmarkLoad(argv[2]);
+        return 0;
+    }
+
     // ģ͡ͼ
     Model* plant = new Model("indoor plant_02.obj");
-    SDL_Surface* texture = LoadTexture("indoor plant_2_COL.jpg");
-    SDL_Surface* normal_map = LoadTexture("indoor plant_2_NOR.jpg");
+    SDL_Surface* texture_surface = LoadTexture("indoor plant_2_COL.jpg");
+    SDL_Surface* normal_map_surface = LoadTexture("indoor plant_2_NOR.jpg");
+    Texture* texture = Texture::CreateTexture(texture_surface);
+    Texture* normal_map = Texture::CreateTexture(normal_map_surface);
+    SDL_DestroySurface(texture_surface);
+    SDL_DestroySurface(normal_map_surface);
     Material plant_Mat = { 0.1f, 0.8f, 0.1f, 5.0f };
     Mat4 plant_model_mat1 = CreateScale(Vec3(1.0f, 1.0f, 1.0f));
 
@@ -48,6 +62,15 @@ int main(int argc, char* argv[]) {
     Material ground_Mat = { 0.1f, 0.7f, 0.5f, 32.0f };
     Mat4 ground_model_mat = CreateTranslation(Vec3(0, 0, 0));
 
+    // ƽйһ 2048 ӰͼԴ 6  512 Ӱͼ
+    lights[0].shadow_size = 2048;
+    lights[1].shadow_size = 512;
+
+    // ֲһʵҶƬǵƬ涼Ҫ
+    Scene scene;
+    scene.AddInstance(scene.AddMesh(ground, NULL, NULL, ground_Mat), ground_model_mat);
+    scene.AddInstance(scene.AddMesh(plant, texture, normal_map, plant_Mat, CullNone), plant_model_mat1);
+
     // ڡȾ
     SDL_Init(SDL_INIT_VIDEO);
     SDL_Window* window = SDL_CreateWindow("RendererLearn", width, height, 0);
@@ -71,7 +94,7 @@ int main(int argc, char* argv[]) {
     {
         // ȾȻ
         SDL_RenderClear(renderer);
-        std::fill(z_buffer.begin(), z_buffer.end(), 1.0f);
+        ClearDepth(z_buffer);
 
         // һɫպ
         for (int y = 0; y < height; y++)
@@ -90,9 +113,39 @@ int main(int argc, char* argv[]) {
         {
             if (event.type == SDL_EVENT_QUIT)
             {
+                // ʱ RENDERER_PROFILE Żдʱ
+                WriteChromeTrace("RendererLearn_trace.json");
                 exit(0);
             }
 
+            // F1 лǰȾӳɫ
+            if (event.type == SDL_EVENT_KEY_DOWN && !event.key.repeat && event.key.scancode == SDL_SCANCODE_F1)
+            {
+                SetDeferredEnabled(!IsDeferredEnabled());
+            }
+
+            // F2 л˷ʽ㡢˫ԡ
+            if (event.type == SDL_EVENT_KEY_DOWN && !event.key.repeat && event.key.scancode == SDL_SCANCODE_F2)
+            {
+                SetTextureFilter((TextureFilter)((GetTextureFilter() + 1) % 3));
+            }
+
+            // F3 ӰF4 Ӱ PCF 
+            if (event.type == SDL_EVENT_KEY_DOWN && !event.key.repeat && event.key.scancode == SDL_SCANCODE_F3)
+            {
+                SetShadowMappingEnabled(!IsShadowMappingEnabled());
+            }
+            if (event.type == SDL_EVENT_KEY_DOWN && !event.key.repeat && event.key.scancode == SDL_SCANCODE_F4)
+            {
+                SetShadowPCFEnabled(!IsShadowPCFEnabled());
+            }
+
+            // F5 лյĿٽ뾫ȷѧ
+            if (event.type == SDL_EVENT_KEY_DOWN && !event.key.repeat && event.key.scancode == SDL_SCANCODE_F5)
+            {
+                SetFastMathEnabled(!IsFastMathEnabled());
+            }
+
             if (event.type == SDL_EVENT_MOUSE_MOTION)
             {
                 float xoffset = event.motion.xrel;
@@ -122,9 +175,14 @@ int main(int argc, char* argv[]) {
         // Դʱת
         MoveLight();
 
+        // ӰͼƽйͳֻƶĵԴÿ֡ػ
+        scene.UpdateShadows(lights);
+
         // Ƶֲ
-        Render(width, height, ground, ground_model_mat, NULL, camera, NULL, frame_buffer, z_buffer, ground_Mat, lights);
-        Render(width, height, plant, plant_model_mat1, texture, camera, normal_map, frame_buffer, z_buffer, plant_Mat, lights);
+        scene.Draw(width, height, camera, frame_buffer, z_buffer, lights);
+
+        // ӳɫʱ廭ͳһ
+        ResolveDeferred(width, height, camera, frame_buffer, lights);
 
         // Ƶʾ
         SDL_UpdateTexture(texture_buffer, NULL, frame_buffer, width * sizeof(Uint32));
@@ -148,25 +206,6 @@ int main(int argc, char* argv[]) {
     return 0;
 }
 
-SDL_Surface* LoadTexture(const char* filename)
-{
-    // ͼƬ
-    SDL_Surface* loadedSurface = IMG_Load(filename);
-    if (!loadedSurface)
-    {
-        SDL_Log("޷ͼƬ %s: %s", filename, SDL_GetError());
-        return nullptr;
-    }
-
-    // ͼƬת RGBA32 ʽȡ
-    SDL_Surface* optimizedSurface = SDL_ConvertSurface(loadedSurface, SDL_PIXELFORMAT_RGBA32);
-
-    // ͷԭ
-    SDL_DestroySurface(loadedSurface);
-
-    return optimizedSurface;
-}
-
 void MoveCamera(Camera* camera)
 {
     Vec3 front;
@@ -200,12 +239,84 @@ void MoveLight()
 void CalculateFPS()
 {
     static int frame_count = 0;
+    static RenderStats stats;
     static float last_fps_time = SDL_GetTicks() / 1000.0f;
     frame_count++;
+    RenderStats frame_stats = CollectRenderStats();
+    ProfileFrame(frame_stats);
+    stats += frame_stats;
     float current_fps_time = SDL_GetTicks() / 1000.0f;
     if (current_fps_time - last_fps_time >= 1.0f) {
-        cout << "FPS: " << frame_count << endl;
+        cout << "FPS: " << frame_count << "  (" << (IsSIMDEnabled() ? "SSE4.1" : "scalar") << ", " << (IsDeferredEnabled() ? "deferred" : "forward") << ", " << TextureFilterName(GetTextureFilter()) << ", " << (IsFastMathEnabled() ? "fast" : "exact") << " math)" << endl;
+
+        // ɫ/룩8x8 ؿͳƺ͹ȻƣЩֻ RENDERER_PROFILE=1 ʱͳ
+        float screen_pixels = (float)width * height * frame_count;
+        if (RENDERER_PROFILE) {
+            float mpixels = stats.pixels_shaded / (current_fps_time - last_fps_time) / 1e6f;
+            float msamples = stats.texture_samples / (current_fps_time - last_fps_time) / 1e6f;
+            cout << "  Shading: " << mpixels << " Mpixels/s  Texture: " << msamples << " Msamples/s" << endl;
+            cout << "  Blocks/frame: rejected " << stats.blocks_rejected / frame_count
+                 << ", accepted " << stats.blocks_accepted / frame_count
+                 << ", partial " << stats.blocks_partial / frame_count << endl;
+            cout << "  Overdraw: tested " << stats.pixels_tested / screen_pixels << "x, shaded " << stats.pixels_shaded / screen_pixels << "x"
+                 << "  Hi-Z culled blocks/frame: " << stats.blocks_occluded / frame_count << endl;
+        }
+        cout << "  Vertices/frame: " << stats.vertices_transformed / frame_count
+             << "  Hi-Z culled triangles/frame: " << stats.triangles_occluded / frame_count << endl;
+
+        // ÿ֡ƽװLOD ʡġ׶޳޳ƽü1  2 ڲࣩüȥդ
+        cout << "  Triangles/frame: submitted " << stats.triangles_submitted / frame_count
+             << ", skipped by LOD " << stats.triangles_lod_skipped / frame_count
+             << ", frustum culled " << stats.triangles_frustum_culled / frame_count
+             << ", back-face culled " << stats.triangles_backface_culled / frame_count
+             << ", near-clipped " << stats.triangles_clipped_one / frame_count << " + " << stats.triangles_clipped_two / frame_count
+             << ", guard-band clipped " << stats.triangles_guard_clipped / frame_count
+             << "  Depth passed: " << stats.pixels_depth_passed / screen_pixels << "x" << endl;
+
         frame_count = 0;
+        stats = RenderStats();
         last_fps_time = current_fps_time;
     }
+}
+
+void BenchmarkLoad(const char* filename)
+{
+    MappedFile file(filename);
+    if (!file.IsOpen())
+    {
+        cout << "Cannot open " << filename << endl;
+        return;
+    }
+    double megabytes = file.Size() / (1024.0 * 1024.0);
+
+    // һμļϵͳ棨ͬʱ񻺴棩֮ȡһ
+    const int runs = 5;
+    double parse_ms = 1e30, cached_ms = 1e30;
+    int verts = 0, faces = 0;
+    for (int i = 0; i <= runs; i++)
+    {
+        // ֱӽ OBJ
+        Uint64 start = SDL_GetPerformanceCounter();
+        std::vector<MeshVertex> vertices;
+        std::vector<uint32_t> indices;
+        LoadObj(filename, vertices, indices);
+        double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+        // ͨƻ
+        start = SDL_GetPerformanceCounter();
+        Model model(filename);
+        double cached = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+        verts = model.nverts();
+        faces = model.nfaces();
+        if (i > 0)
+        {
+            parse_ms = std::min(parse_ms, ms);
+            cached_ms = std::min(cached_ms, cached);
+        }
+    }
+
+    cout << filename << ": " << megabytes << " MB, " << verts << " vertices, " << faces << " triangles" << endl;
+    cout << "  Parse OBJ: " << parse_ms << " ms (best of " << runs << "), " << megabytes / (parse_ms / 1000.0) << " MB/s" << endl;
+    cout << "  Cached:    " << cached_ms << " ms (best of " << runs << ")" << endl;
 }
\ No newline at end of file